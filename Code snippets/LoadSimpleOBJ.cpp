@@ -6,7 +6,8 @@
  *
  *  Este arquivo contém a função `loadSimpleOBJ`, responsável por carregar arquivos
  *  no formato Wavefront .OBJ e armazenar seus vértices em um VAO para renderização
- *  com OpenGL.
+ *  com OpenGL. A leitura do arquivo é feita pelo leitor compartilhado em
+ *  Common/ObjLoader.h (arquivo mapeado em memória, sem istringstream).
  *
  *  Forma de uso (carregamento de um .obj)
  *  -----------------
@@ -25,8 +26,6 @@
 
  // Cabeçalhos necessários (para esta função), acrescentar ao seu código 
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
 #include <vector>
  
@@ -44,6 +43,9 @@ using namespace std;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// Leitor de .OBJ compartilhado (Common/)
+#include "ObjLoader.h"
+
 struct Mesh 
 {
     GLuint VAO; 
@@ -52,67 +54,34 @@ struct Mesh
 
 int loadSimpleOBJ(string filePATH, int &nVertices)
  {
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec2> texCoords;
-    std::vector<glm::vec3> normals;
+    ObjData obj;
     std::vector<GLfloat> vBuffer;
     glm::vec3 color = glm::vec3(1.0, 0.0, 0.0);
 
-    std::ifstream arqEntrada(filePATH.c_str());
-    if (!arqEntrada.is_open()) 
-	{
-        std::cerr << "Erro ao tentar ler o arquivo " << filePATH << std::endl;
+    if (!loadOBJ(filePATH, obj, false))
         return -1;
-    }
-
-    std::string line;
-    while (std::getline(arqEntrada, line)) 
-	{
-        std::istringstream ssline(line);
-        std::string word;
-        ssline >> word;
-
-        if (word == "v") 
-		{
-            glm::vec3 vertice;
-            ssline >> vertice.x >> vertice.y >> vertice.z;
-            vertices.push_back(vertice);
-        } 
-        else if (word == "vt") 
-		{
-            glm::vec2 vt;
-            ssline >> vt.s >> vt.t;
-            texCoords.push_back(vt);
-        } 
-        else if (word == "vn") 
-		{
-            glm::vec3 normal;
-            ssline >> normal.x >> normal.y >> normal.z;
-            normals.push_back(normal);
-        } 
-        else if (word == "f")
-		 {
-            while (ssline >> word) 
-			{
-                int vi = 0, ti = 0, ni = 0;
-                std::istringstream ss(word);
-                std::string index;
 
-                if (std::getline(ss, index, '/')) vi = !index.empty() ? std::stoi(index) - 1 : 0;
-                if (std::getline(ss, index, '/')) ti = !index.empty() ? std::stoi(index) - 1 : 0;
-                if (std::getline(ss, index)) ni = !index.empty() ? std::stoi(index) - 1 : 0;
+    auto pushCorner = [&](const ObjCorner &corner)
+    {
+        if (obj.positions.empty())
+            return;
+        int vi = corner.v >= 0 && corner.v < (int)obj.positions.size() ? corner.v : 0;
 
-                vBuffer.push_back(vertices[vi].x);
-                vBuffer.push_back(vertices[vi].y);
-                vBuffer.push_back(vertices[vi].z);
-                vBuffer.push_back(color.r);
-                vBuffer.push_back(color.g);
-                vBuffer.push_back(color.b);
-            }
-        }
-    }
+        vBuffer.push_back(obj.positions[vi].x);
+        vBuffer.push_back(obj.positions[vi].y);
+        vBuffer.push_back(obj.positions[vi].z);
+        vBuffer.push_back(color.r);
+        vBuffer.push_back(color.g);
+        vBuffer.push_back(color.b);
+    };
 
-    arqEntrada.close();
+    vBuffer.reserve(obj.corners.size() * 6);
+    forEachTriangle(obj, [&](const ObjCorner &a, const ObjCorner &b, const ObjCorner &c)
+    {
+        pushCorner(a);
+        pushCorner(b);
+        pushCorner(c);
+    });
 
     std::cout << "Gerando o buffer de geometria..." << std::endl;
     GLuint VBO, VAO;
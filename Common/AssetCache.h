@@ -0,0 +1,234 @@
+/*
+ *  AssetCache.h
+ *
+ *  Pasta de cache compartilhada por todos os executáveis (../cache, ao lado de
+ *  ../assets), endereçada pelo conteúdo: o nome de cada entrada é o hash dos
+ *  bytes do arquivo de origem combinado com as opções de importação (formato,
+ *  versão, inversão vertical...). O mesmo .OBJ ou .PNG carregado com as mesmas
+ *  opções cai na mesma entrada em M4, M5, SpherePhong ou TriangleTex, não importa
+ *  por qual caminho ele foi aberto. Mudar a origem ou as opções gera outra chave;
+ *  a entrada antiga só sai por despejo.
+ *
+ *  Para não reler a origem inteira a cada carga, o hash de cada arquivo fica
+ *  guardado em um carimbo (.src, chaveado pelo caminho absoluto) com o tamanho e
+ *  a data de modificação; o conteúdo só é lido de novo quando eles mudam.
+ *
+ *  O tamanho da pasta é limitado a assetCacheMaxBytes: depois de cada gravação as
+ *  entradas usadas há mais tempo são apagadas (LRU pela data de modificação, que
+ *  é renovada a cada acerto); a entrada recém-gravada nunca sai nesse despejo,
+ *  mesmo que sozinha passe do limite. Cada gravação usa um arquivo temporário com nome
+ *  único e termina com rename, então processos e threads diferentes podem
+ *  preencher o cache ao mesmo tempo sem deixar entradas pela metade.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  // MeshCache.h e ImageCache.h já usam o cache; um novo tipo de recurso faz:
+ *  AssetSource source;
+ *  statAssetSource(path, source);
+ *  std::string entry = assetCachePath(assetCacheKey(source.hash, "opcoes"), ".ext");
+ *  // acerto: lê entry e chama touchAssetCacheEntry(entry)
+ *  // falta: grava em temp = assetCacheTempPath(entry) e chama commitAssetCacheFile(temp, entry)
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MappedFile.h"
+
+const char *const ASSET_CACHE_DIRECTORY = "../cache";        // relativo à pasta de execução, como ../assets
+const uint64_t ASSET_CACHE_MAX_BYTES = 512ull * 1024 * 1024;
+const char ASSET_SOURCE_MAGIC[4] = {'C', 'G', 'S', 'R'};
+
+// Podem ser trocados antes da primeira carga (ex.: o benchmark usa uma pasta própria)
+inline std::string assetCacheDirectory = ASSET_CACHE_DIRECTORY;
+inline uint64_t assetCacheMaxBytes = ASSET_CACHE_MAX_BYTES;
+
+// Tamanho, data de modificação e hash do conteúdo de um arquivo de origem
+struct AssetSource
+{
+    uint64_t size = 0;
+    int64_t time = 0;
+    uint64_t hash = 0;
+};
+
+// Carimbo .src: o hash de um caminho enquanto tamanho e data não mudarem
+struct AssetSourceStamp
+{
+    char magic[4];
+    uint32_t reserved;
+    uint64_t size;
+    int64_t time;
+    uint64_t hash;
+};
+
+// FNV-1a de 64 bits
+inline uint64_t hashBytes(const void *data, size_t size, uint64_t hash = 0xCBF29CE484222325ull)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+inline bool hashFile(const std::string &filePath, uint64_t &hash)
+{
+    MappedFile file;
+    if (!file.open(filePath))
+        return false;
+    hash = hashBytes(file.data, file.size);
+    return true;
+}
+
+inline bool statFile(const std::string &filePath, uint64_t &size, int64_t &time)
+{
+    std::error_code error;
+    size = (uint64_t)std::filesystem::file_size(filePath, error);
+    if (error)
+        return false;
+    time = (int64_t)std::filesystem::last_write_time(filePath, error).time_since_epoch().count();
+    return !error;
+}
+
+// Chave de uma entrada: hash da origem seguido das opções de importação
+inline uint64_t assetCacheKey(uint64_t sourceHash, const std::string &settings)
+{
+    return hashBytes(settings.data(), settings.size(), hashBytes(&sourceHash, sizeof(sourceHash)));
+}
+
+inline std::string assetCachePath(uint64_t key, const char *extension)
+{
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+    return (std::filesystem::path(assetCacheDirectory) / (name + std::string(extension))).string();
+}
+
+// Arquivo temporário ao lado de path, com nome único por thread (cria a pasta do cache)
+inline std::string assetCacheTempPath(const std::string &path)
+{
+    std::error_code error;
+    std::filesystem::create_directories(assetCacheDirectory, error);
+    size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+    uint64_t now = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+    char suffix[40];
+    snprintf(suffix, sizeof(suffix), ".%llx.tmp", (unsigned long long)(hashBytes(&now, sizeof(now), thread)));
+    return path + suffix;
+}
+
+// Renova a data de uso de uma entrada (despejo LRU)
+inline void touchAssetCacheEntry(const std::string &path)
+{
+    std::error_code error;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+}
+
+// Apaga as entradas usadas há mais tempo até a pasta caber em assetCacheMaxBytes.
+// Arquivos temporários (gravações em andamento) não entram na conta, e keep (a entrada
+// recém-gravada) nunca é apagada: sozinha, ela pode passar do limite
+inline void trimAssetCache(const std::string &keep = "")
+{
+    struct Entry
+    {
+        std::filesystem::path path;
+        std::filesystem::file_time_type time;
+        uint64_t size;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code error;
+    std::filesystem::path kept = std::filesystem::path(keep).lexically_normal();
+    for (const auto &item : std::filesystem::directory_iterator(assetCacheDirectory, error))
+    {
+        std::error_code itemError;
+        if (!item.is_regular_file(itemError) || item.path().extension() == ".tmp")
+            continue;
+        Entry entry{item.path(), item.last_write_time(itemError), item.file_size(itemError)};
+        if (itemError)
+            continue;
+        total += entry.size;
+        if (keep.empty() || entry.path.lexically_normal() != kept)
+            entries.push_back(entry);
+    }
+    if (total <= assetCacheMaxBytes)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.time < b.time; });
+    for (const Entry &entry : entries)
+    {
+        if (total <= assetCacheMaxBytes)
+            break;
+        if (std::filesystem::remove(entry.path, error))
+            total -= entry.size;
+    }
+}
+
+// Troca a entrada pelo arquivo temporário já completo e aplica o limite de tamanho sem
+// apagar a entrada; false se ela não existe no fim (outro processo pode tê-la despejado)
+inline bool commitAssetCacheFile(const std::string &tempPath, const std::string &path)
+{
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    trimAssetCache(path);
+    return std::filesystem::exists(path, error);
+}
+
+// Tamanho, data e hash do conteúdo de path; o hash vem do carimbo quando tamanho e data coincidem
+inline bool statAssetSource(const std::string &path, AssetSource &source)
+{
+    if (!statFile(path, source.size, source.time))
+        return false;
+
+    std::error_code error;
+    std::string absolute = std::filesystem::absolute(path, error).lexically_normal().string();
+    std::string stampPath = assetCachePath(hashBytes(absolute.data(), absolute.size()), ".src");
+    AssetSourceStamp stamp;
+    {
+        std::ifstream in(stampPath, std::ios::binary);
+        if (in.read((char *)&stamp, sizeof(stamp)) && memcmp(stamp.magic, ASSET_SOURCE_MAGIC, 4) == 0 &&
+            stamp.size == source.size && stamp.time == source.time)
+        {
+            source.hash = stamp.hash;
+            return true;
+        }
+    }
+
+    if (!hashFile(path, source.hash))
+        return false;
+    memcpy(stamp.magic, ASSET_SOURCE_MAGIC, 4);
+    stamp.reserved = 0;
+    stamp.size = source.size;
+    stamp.time = source.time;
+    stamp.hash = source.hash;
+    std::string tempPath = assetCacheTempPath(stampPath);
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write((const char *)&stamp, sizeof(stamp));
+        if (!out)
+        {
+            out.close();
+            std::filesystem::remove(tempPath, error);
+            return true;  // sem carimbo: o hash é recalculado na próxima carga
+        }
+    }
+    commitAssetCacheFile(tempPath, stampPath);
+    return true;
+}
@@ -0,0 +1,1023 @@
+/*
+ *  AssetLoader.h
+ *
+ *  Carga assíncrona de malhas e texturas. As threads de carga fazem tudo o que
+ *  não usa OpenGL: leitura do cache ou do .OBJ (loadMeshStaging), leitura dos
+ *  .MTL e das imagens (loadTextureStaging, que só decodifica e comprime o que
+ *  ainda não está no cache compartilhado). Os resultados voltam para a thread da
+ *  OpenGL por uma pilha sem locks (CAS em completed), e updateAssetLoader envia
+ *  os dados em pedaços de ASSET_UPLOAD_CHUNK bytes (glBufferSubData,
+ *  glTexSubImage2D e glCompressedTexSubImage2D, ou as versões 3D nos arrays) até
+ *  esgotar o orçamento de tempo do quadro.
+ *
+ *  As texturas são alocadas de uma vez com glTexStorage2D (imutáveis) quando o
+ *  driver tem a função (loadGLExtensions, GLExtensions.h), e os pedaços passam
+ *  pelo anel de PBOs de uploadRing (UploadRing.h): a thread da OpenGL só copia
+ *  os bytes já prontos para a memória mapeada e a cópia para a textura fica com
+ *  a GPU, sem travar o quadro. Com o anel cheio, o envio continua no quadro
+ *  seguinte.
+ *
+ *  Uma malha pedida com uma MeshArena (MeshArena.h) não ganha VAO próprio: no
+ *  envio ela é acrescentada à arena (addArenaMesh) e passa a dividir o VAO com as
+ *  outras malhas de lá. Numa recarga a versão nova é acrescentada de novo, e a
+ *  antiga ocupa espaço na arena até destroyMeshArena.
+ *
+ *  Enquanto a carga não termina, as malhas pedidas são desenhadas como um cubo
+ *  e as texturas mostram um xadrez cinza, então a janela abre na hora e o laço
+ *  de desenho nunca espera por disco ou decodificação. Os materiais da malha são
+ *  acrescentados à MaterialLibrary quando ela fica pronta, e as texturas map_Kd
+ *  são pedidas automaticamente.
+ *
+ *  As texturas pertencem a textureRegistry (TextureRegistry.h): pedir de novo um
+ *  arquivo já pedido devolve a mesma textura com mais uma referência, e
+ *  releaseAssetTexture devolve uma referência (sem nenhuma, a textura é apagada
+ *  alguns quadros depois). Com textureRegistry.compressTextures (o padrão) as
+ *  imagens chegam em BC1/BC3 com os mipmaps já prontos; troque antes de
+ *  startAssetLoader para enviar sem compressão.
+ *
+ *  Com packTextures (ligue antes de startAssetLoader), as texturas map_Kd não
+ *  são pedidas uma a uma: sempre que a lista de arquivos dos materiais muda, um
+ *  pedido único lê todas e as empacota em GL_TEXTURE_2D_ARRAY (TextureArray.h),
+ *  enviado em faixas de linhas pelo mesmo anel de PBOs; os materiais passam a
+ *  apontar para o array e a camada (diffuseLayer) quando ele fica pronto, e até
+ *  lá ficam sem textura.
+ *
+ *  Com enableHotReload, os arquivos das malhas e texturas pedidas são observados
+ *  (FileWatcher.h). Um arquivo alterado é lido de novo só ele, nas mesmas threads
+ *  de carga, enquanto a versão antiga continua sendo desenhada. A malha mantém o
+ *  VAO; os pedaços vão para buffers novos, e quando o envio termina os de mesmo
+ *  tamanho são copiados para os buffers em uso (glCopyBufferSubData) e os outros
+ *  os substituem, junto com os LODs e a quantização. A textura
+ *  com as mesmas dimensões recebe glTexSubImage2D; senão é realocada com o mesmo
+ *  nome (ou, se for imutável, recriada com outro nome, trocado nos materiais
+ *  quando o envio termina). Materiais e objetos continuam com os mesmos índices.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  AssetLoader assets;
+ *  loadGLExtensions((GLADloadproc)glfwGetProcAddress);  // opcional: glTexStorage2D, glBufferStorage
+ *  startAssetLoader(assets, &materials, loadImage, stbi_image_free);
+ *  enableHotReload(assets);                       // opcional
+ *  uint32_t suzanne = requestMesh(assets, "../assets/Modelos3D/Suzanne.obj");
+ *  while (...)
+ *  {
+ *      updateAssetLoader(assets);                 // no início de cada quadro
+ *      drawModel(assetMesh(assets, suzanne), ...);
+ *  }
+ *  stopAssetLoader(assets);
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "FileWatcher.h"
+#include "ImageCache.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "MeshArena.h"
+#include "MeshCache.h"
+#include "TextureArray.h"
+#include "TextureRegistry.h"
+#include "UploadRing.h"
+
+const double ASSET_UPLOAD_BUDGET_MS = 2.0;     // tempo de envio para a GPU por quadro
+const size_t ASSET_UPLOAD_CHUNK = 1 << 20;     // bytes por glBufferSubData/glTexSubImage2D
+const unsigned ASSET_LOADER_THREADS = 2;
+const size_t ASSET_UPLOAD_RING_BYTES = 8 << 20;  // anel de PBOs das texturas
+
+enum AssetType
+{
+    ASSET_MESH,
+    ASSET_TEXTURE,
+    ASSET_TEXTURE_ARRAY
+};
+
+// Pedido de carga. A thread de carga preenche a parte de CPU; a thread da OpenGL
+// acompanha o envio em uploaded
+struct AssetJob
+{
+    AssetType type = ASSET_MESH;
+    std::string path;
+    bool packed = false;
+    uint32_t mesh = 0;     // índice em AssetLoader::meshes
+    MeshArena *arena = nullptr;  // malha acrescentada a esta arena em vez de ter VAO próprio
+    uint32_t textureSlot = 0;  // índice em AssetLoader::textures
+    GLuint texture = 0;    // textura já criada com o placeholder (ou a recriada numa recarga)
+    bool reload = false;   // o recurso já existe e está sendo lido de novo
+    bool sharesMesh = false;  // recarga: gpu usa o VAO da malha em uso
+    bool copyVertices = false;  // recarga: o VBO de gpu é copiado para o VBO em uso no fim
+    bool copyIndices = false;
+    bool loaded = false;
+
+    MeshStaging staging;
+    MaterialLibrary materials;  // .MTL citados pela malha
+    TextureStaging textureData;
+    TextureArrayStaging arrayData;
+
+    GPUMesh gpu;
+    TextureArraySet arrays;  // arrays em envio; substituem AssetLoader::textureArrays no fim
+    size_t uploaded = 0;   // bytes já enviados (arrays: de todas as camadas, em sequência)
+    bool started = false;
+    AssetJob *next = nullptr;  // encadeamento da pilha de resultados
+};
+
+struct AssetMeshSlot
+{
+    std::string path;
+    bool packed = false;
+    MeshArena *arena = nullptr;
+    bool ready = false;
+    bool loading = false;  // há um pedido em andamento para esta malha
+    bool changed = false;  // o arquivo mudou durante o pedido: recarrega de novo no fim
+    size_t vertexBytes = 0;
+    size_t indexBytes = 0;
+};
+
+struct AssetTexture
+{
+    TextureHandle handle;  // em AssetLoader::textureRegistry
+    GLuint texture = 0;
+    std::string path;
+    int width = 0;
+    int height = 0;
+    GLenum format = 0;  // formato interno enviado (0: placeholder)
+    bool immutable = false;  // alocada com glTexStorage2D: tamanho e formato não mudam mais
+    bool loading = false;
+    bool changed = false;
+};
+
+struct AssetLoader
+{
+    std::vector<std::thread> workers;
+    std::mutex mutex;                  // protege requests (só as threads de carga esperam nele)
+    std::condition_variable wake;
+    std::deque<AssetJob *> requests;
+    bool stopping = false;
+
+    std::atomic<AssetJob *> completed{nullptr};  // pilha sem locks: threads de carga -> OpenGL
+    std::deque<AssetJob *> uploads;              // só na thread da OpenGL
+
+    std::deque<GPUMesh> meshes;     // placeholder até a malha ficar pronta
+    std::vector<AssetMeshSlot> meshSlots;
+    std::vector<AssetTexture> textures;  // texturas criadas por requestTexture
+    TextureRegistry textureRegistry;     // dona das texturas; evita carregar o mesmo arquivo duas vezes
+    GPUMesh placeholderMesh;
+    UploadRing uploadRing;
+    FileWatcher watcher;
+    bool hotReload = false;
+    MaterialLibrary *materials = nullptr;
+    ImageLoadFunction loadImage = nullptr;
+    ImageFreeFunction freeImage = nullptr;
+    TextureCompressionSupport compression;  // copiados de textureRegistry em startAssetLoader,
+    bool compressTextures = true;           // para as threads de carga
+    bool packTextures = false;              // map_Kd em GL_TEXTURE_2D_ARRAY em vez de uma textura por arquivo
+    TextureArraySet textureArrays;
+    std::vector<std::string> arrayPaths;    // arquivos do último pedido de arrays
+    bool arraysLoading = false;
+    bool arraysChanged = false;             // a lista ou um arquivo mudou durante o pedido
+};
+
+// Cubo unitário com normais e coordenadas de textura, desenhado no lugar das malhas em carga
+inline Mesh makePlaceholderMesh()
+{
+    Mesh mesh;
+    const glm::vec2 corners[4] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}};
+    for (int axis = 0; axis < 3; axis++)
+        for (int sign = -1; sign <= 1; sign += 2)
+        {
+            glm::vec3 normal(0.0f), u(0.0f), v(0.0f);
+            normal[axis] = (float)sign;
+            u[(axis + 1) % 3] = 1.0f;
+            v[(axis + 2) % 3] = 1.0f;
+            if (sign < 0)
+                std::swap(u, v);
+
+            uint32_t base = (uint32_t)mesh.vertices.size();
+            for (const glm::vec2 &corner : corners)
+                mesh.vertices.push_back({normal * 0.5f + (corner.x - 0.5f) * u + (corner.y - 0.5f) * v, normal, corner});
+            const uint32_t quad[6] = {0, 1, 2, 0, 2, 3};
+            for (uint32_t index : quad)
+                mesh.indices.push_back(base + index);
+        }
+    mesh.subsets.push_back({0, (uint32_t)mesh.indices.size(), 0, 0});
+    mesh.materialNames.push_back("");
+    computeBounds(mesh);
+    return mesh;
+}
+
+// Xadrez 2x2 cinza, sem mipmaps
+inline void fillPlaceholderTexture(GLuint texture)
+{
+    const unsigned char pixels[12] = {160, 160, 160, 224, 224, 224, 224, 224, 224, 160, 160, 160};
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 2, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+inline void pushCompletedAsset(AssetLoader &loader, AssetJob *job)
+{
+    job->next = loader.completed.load(std::memory_order_relaxed);
+    while (!loader.completed.compare_exchange_weak(job->next, job, std::memory_order_release,
+                                                   std::memory_order_relaxed))
+        ;
+}
+
+// Toda a parte de CPU de um pedido (roda nas threads de carga)
+inline void loadAssetJob(AssetLoader &loader, AssetJob &job)
+{
+    if (job.type == ASSET_MESH)
+    {
+        job.loaded = loadMeshStaging(job.path, job.packed, job.staging);
+        if (job.loaded)
+            loadMeshMaterialFiles(job.materials, job.staging.mesh, job.path);
+    }
+    else if (job.type == ASSET_TEXTURE)
+    {
+        job.loaded = loadTextureStaging(job.path, loader.loadImage, loader.freeImage, loader.compression,
+                                        loader.compressTextures, job.textureData);
+    }
+    else
+    {
+        loadTextureArrayStaging(job.arrayData, loader.loadImage, loader.freeImage, loader.compression,
+                                loader.compressTextures);
+        job.loaded = true;
+    }
+}
+
+inline void assetWorker(AssetLoader &loader)
+{
+    while (true)
+    {
+        AssetJob *job;
+        {
+            std::unique_lock<std::mutex> lock(loader.mutex);
+            loader.wake.wait(lock, [&]() { return loader.stopping || !loader.requests.empty(); });
+            if (loader.stopping)
+                return;
+            job = loader.requests.front();
+            loader.requests.pop_front();
+        }
+        loadAssetJob(loader, *job);
+        pushCompletedAsset(loader, job);
+    }
+}
+
+inline void startAssetLoader(AssetLoader &loader, MaterialLibrary *materials, ImageLoadFunction loadImage,
+                             ImageFreeFunction freeImage, unsigned threadCount = ASSET_LOADER_THREADS)
+{
+    loader.materials = materials;
+    loader.loadImage = loadImage;
+    loader.freeImage = freeImage;
+    loader.compression = textureCompressionSupport(loader.textureRegistry);
+    loader.compressTextures = loader.textureRegistry.compressTextures;
+    loader.placeholderMesh = uploadMesh(makePlaceholderMesh());
+    if (!createUploadRing(loader.uploadRing, ASSET_UPLOAD_RING_BYTES))
+        destroyUploadRing(loader.uploadRing);  // sem anel, os pedaços saem direto da memória do pedido
+    for (unsigned i = 0; i < std::max(1u, threadCount); i++)
+        loader.workers.emplace_back(assetWorker, std::ref(loader));
+}
+
+inline void queueAssetJob(AssetLoader &loader, AssetJob *job)
+{
+    {
+        std::lock_guard<std::mutex> lock(loader.mutex);
+        loader.requests.push_back(job);
+    }
+    loader.wake.notify_one();
+}
+
+inline void queueMeshJob(AssetLoader &loader, uint32_t mesh, bool reload)
+{
+    AssetMeshSlot &slot = loader.meshSlots[mesh];
+    AssetJob *job = new AssetJob();
+    job->type = ASSET_MESH;
+    job->path = slot.path;
+    job->packed = slot.packed;
+    job->arena = slot.arena;
+    job->mesh = mesh;
+    job->reload = reload;
+    slot.loading = true;
+    queueAssetJob(loader, job);
+}
+
+inline void queueTextureJob(AssetLoader &loader, uint32_t textureSlot, bool reload)
+{
+    AssetTexture &texture = loader.textures[textureSlot];
+    AssetJob *job = new AssetJob();
+    job->type = ASSET_TEXTURE;
+    job->path = texture.path;
+    job->textureSlot = textureSlot;
+    job->texture = texture.texture;
+    job->reload = reload;
+    texture.loading = true;
+    retainTexture(loader.textureRegistry, texture.handle);  // não é apagada com o pedido em andamento
+    queueAssetJob(loader, job);
+}
+
+// Empacota de novo os map_Kd de todos os materiais; com um pedido em andamento, só
+// marca, e o novo pedido sai quando o atual terminar (releaseAssetSlot)
+inline void queueTextureArrayJob(AssetLoader &loader)
+{
+    if (loader.arraysLoading)
+    {
+        loader.arraysChanged = true;
+        return;
+    }
+    AssetJob *job = new AssetJob();
+    job->type = ASSET_TEXTURE_ARRAY;
+    job->arrayData.paths = materialTexturePaths(*loader.materials);
+    for (const std::string &path : job->arrayData.paths)
+    {
+        bool watched = std::find(loader.arrayPaths.begin(), loader.arrayPaths.end(), path) != loader.arrayPaths.end();
+        if (loader.hotReload && !watched)
+            watchFile(loader.watcher, path);
+    }
+    loader.arrayPaths = job->arrayData.paths;
+    loader.arraysLoading = true;
+    queueAssetJob(loader, job);
+}
+
+// Devolve o índice da malha; até a carga terminar, assetMesh devolve o cubo placeholder.
+// Com arena, a malha é acrescentada a ela em vez de ganhar VAO e buffers próprios
+inline uint32_t requestMesh(AssetLoader &loader, const std::string &objPath, bool packed = false,
+                            MeshArena *arena = nullptr)
+{
+    AssetMeshSlot slot;
+    slot.path = objPath;
+    slot.packed = packed;
+    slot.arena = arena;
+    uint32_t mesh = (uint32_t)loader.meshes.size();
+    loader.meshes.push_back(loader.placeholderMesh);
+    loader.meshSlots.push_back(slot);
+    if (loader.hotReload)
+        watchFile(loader.watcher, objPath);
+    queueMeshJob(loader, mesh, false);
+    return mesh;
+}
+
+// A textura pode ser usada na hora: mostra o placeholder até a imagem ser enviada.
+// O mesmo arquivo pedido de novo (por qualquer caminho) devolve a mesma textura
+inline GLuint requestTexture(AssetLoader &loader, const std::string &path)
+{
+    TextureHandle existing = findTexture(loader.textureRegistry, path);
+    if (existing.generation != 0)
+    {
+        retainTexture(loader.textureRegistry, existing);
+        return textureObject(loader.textureRegistry, existing);
+    }
+
+    AssetTexture texture;
+    texture.path = path;
+    texture.handle = createTexture(loader.textureRegistry, path);
+    texture.texture = textureObject(loader.textureRegistry, texture.handle);
+    fillPlaceholderTexture(texture.texture);
+    loader.textures.push_back(texture);
+    if (loader.hotReload)
+        watchFile(loader.watcher, path);
+    queueTextureJob(loader, (uint32_t)loader.textures.size() - 1, false);
+    return texture.texture;
+}
+
+// Devolve uma referência obtida com requestTexture; sem referências, a textura é
+// apagada alguns quadros depois (TextureRegistry.h)
+inline void releaseAssetTexture(AssetLoader &loader, GLuint texture)
+{
+    for (const AssetTexture &slot : loader.textures)
+        if (slot.texture == texture && isTextureHandleValid(loader.textureRegistry, slot.handle))
+        {
+            releaseTexture(loader.textureRegistry, slot.handle);
+            return;
+        }
+}
+
+// Passa a observar os arquivos das malhas e texturas (as já pedidas e as próximas)
+inline void enableHotReload(AssetLoader &loader)
+{
+    loader.hotReload = true;
+    for (const AssetMeshSlot &slot : loader.meshSlots)
+        watchFile(loader.watcher, slot.path);
+    for (const AssetTexture &texture : loader.textures)
+        watchFile(loader.watcher, texture.path);
+    for (const std::string &path : loader.arrayPaths)
+        watchFile(loader.watcher, path);
+}
+
+// Pede de novo os recursos cujos arquivos mudaram. Um recurso com pedido em andamento
+// só é marcado, e o novo pedido sai quando o atual terminar (releaseAssetSlot)
+inline void reloadChangedAssets(AssetLoader &loader)
+{
+    for (const std::string &path : pollFileWatcher(loader.watcher))
+    {
+        std::cout << "Recarregando " << path << std::endl;
+        for (uint32_t i = 0; i < loader.meshSlots.size(); i++)
+            if (loader.meshSlots[i].path == path)
+            {
+                if (loader.meshSlots[i].loading)
+                    loader.meshSlots[i].changed = true;
+                else
+                    queueMeshJob(loader, i, true);
+            }
+        for (uint32_t i = 0; i < loader.textures.size(); i++)
+        {
+            AssetTexture &texture = loader.textures[i];
+            if (texture.path == path && isTextureHandleValid(loader.textureRegistry, texture.handle))
+            {
+                if (texture.loading)
+                    texture.changed = true;
+                else
+                    queueTextureJob(loader, i, true);
+            }
+        }
+        if (std::find(loader.arrayPaths.begin(), loader.arrayPaths.end(), path) != loader.arrayPaths.end())
+            queueTextureArrayJob(loader);
+    }
+}
+
+inline const GPUMesh &assetMesh(const AssetLoader &loader, uint32_t mesh)
+{
+    return loader.meshes[mesh];
+}
+
+inline bool isMeshReady(const AssetLoader &loader, uint32_t mesh)
+{
+    return loader.meshSlots[mesh].ready;
+}
+
+// Buffer sem dados com o tamanho final, criado fora do VAO
+inline GLuint createUploadBuffer(size_t bytes)
+{
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, bytes, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return buffer;
+}
+
+// Copia o conteúdo de source para target (mesmo tamanho) e apaga source
+inline void copyUploadBuffer(GLuint source, GLuint target, size_t bytes)
+{
+    glBindBuffer(GL_COPY_READ_BUFFER, source);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, target);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (GLsizeiptr)bytes);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &source);
+}
+
+inline void finishMeshUpload(AssetLoader &loader, AssetJob &job)
+{
+    AssetMeshSlot &slot = loader.meshSlots[job.mesh];
+    GPUMesh &current = loader.meshes[job.mesh];
+    if (job.sharesMesh)
+    {
+        // Buffers de mesmo tamanho: copia para os em uso, no mesmo quadro em que os LODs e a
+        // quantização mudam, e descarta os temporários
+        if (job.copyVertices)
+        {
+            copyUploadBuffer(job.gpu.VBO, current.VBO, job.staging.vertexBytes);
+            job.gpu.VBO = current.VBO;
+        }
+        if (job.copyIndices)
+        {
+            copyUploadBuffer(job.gpu.EBO, current.EBO, meshStagingIndexBytes(job.staging));
+            job.gpu.EBO = current.EBO;
+        }
+
+        // Liga os buffers recriados ao VAO em uso e apaga os antigos
+        const MeshStaging &staging = job.staging;
+        glBindVertexArray(job.gpu.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, job.gpu.VBO);
+        setupVertexAttributes(staging.layout, staging.attributeCount, staging.stride);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, job.gpu.EBO);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        if (current.VBO != job.gpu.VBO)
+            glDeleteBuffers(1, &current.VBO);
+        if (current.EBO != job.gpu.EBO)
+            glDeleteBuffers(1, &current.EBO);
+    }
+    slot.ready = true;
+    slot.vertexBytes = job.staging.vertexBytes;
+    slot.indexBytes = meshStagingIndexBytes(job.staging);
+
+    if (!job.arena)
+        applyMeshStaging(job.staging, job.gpu);  // addArenaMesh já deslocou os LODs para o EBO da arena
+    if (loader.materials)
+    {
+        mergeMaterialLibrary(*loader.materials, job.materials);
+        assignMeshMaterials(*loader.materials, job.gpu);
+        if (!loader.packTextures)
+            loadMaterialTextures(*loader.materials, [&](const std::string &path) { return requestTexture(loader, path); });
+        else if (materialTexturePaths(*loader.materials) != loader.arrayPaths)
+            queueTextureArrayJob(loader);
+        else
+            assignMaterialLayers(loader.textureArrays, *loader.materials);
+    }
+    current = job.gpu;
+}
+
+// Envia mais um pedaço da malha (o primeiro junto com a alocação dos buffers); devolve
+// true quando ela está completa
+inline bool uploadMeshStep(AssetLoader &loader, AssetJob &job)
+{
+    const MeshStaging &staging = job.staging;
+    size_t indexBytes = meshStagingIndexBytes(staging);
+    const AssetMeshSlot &slot = loader.meshSlots[job.mesh];
+    const GPUMesh &current = loader.meshes[job.mesh];
+    if (job.arena)
+    {
+        // A malha entra inteira na arena; com layout de vértice diferente, o pedido falha
+        job.started = true;
+        job.loaded = addArenaMesh(*job.arena, staging, job.gpu);
+        job.uploaded = staging.vertexBytes + indexBytes;
+        return true;
+    }
+    if (!job.started && job.reload && slot.ready)
+    {
+        // Recarga: o VAO em uso continua desenhando a versão antiga até finishMeshUpload. Os
+        // pedaços vão para buffers novos, nunca para os em uso: vértices novos com índices,
+        // LODs ou quantização antigos desenhariam lixo nos quadros do meio do envio
+        job.started = true;
+        job.sharesMesh = true;
+        job.copyVertices = slot.vertexBytes == staging.vertexBytes;
+        job.copyIndices = indexBytes > 0 && current.EBO != 0 && slot.indexBytes == indexBytes;
+        job.gpu.VAO = current.VAO;
+        job.gpu.VBO = createUploadBuffer(staging.vertexBytes);
+        job.gpu.EBO = indexBytes == 0 ? 0 : createUploadBuffer(indexBytes);
+        job.gpu.indexCount = staging.indexCount > 0 ? (GLsizei)staging.indexCount
+                                                    : (GLsizei)(staging.vertexBytes / staging.stride);
+    }
+    if (!job.started)
+    {
+        // Buffers com o tamanho final e sem dados; o conteúdo vai por glBufferSubData
+        job.started = true;
+        glGenVertexArrays(1, &job.gpu.VAO);
+        glGenBuffers(1, &job.gpu.VBO);
+        glBindVertexArray(job.gpu.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, job.gpu.VBO);
+        glBufferData(GL_ARRAY_BUFFER, staging.vertexBytes, nullptr, GL_STATIC_DRAW);
+        if (staging.indexCount > 0)
+        {
+            glGenBuffers(1, &job.gpu.EBO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, job.gpu.EBO);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, nullptr, GL_STATIC_DRAW);
+            job.gpu.indexCount = (GLsizei)staging.indexCount;
+        }
+        else
+            job.gpu.indexCount = (GLsizei)(staging.vertexBytes / staging.stride);
+        setupVertexAttributes(staging.layout, staging.attributeCount, staging.stride);
+        glBindVertexArray(0);
+    }
+
+    if (job.uploaded < staging.vertexBytes)
+    {
+        size_t size = std::min(ASSET_UPLOAD_CHUNK, staging.vertexBytes - job.uploaded);
+        glBindBuffer(GL_ARRAY_BUFFER, job.gpu.VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, job.uploaded, size, staging.vertexData + job.uploaded);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        job.uploaded += size;
+    }
+    else if (job.uploaded < staging.vertexBytes + indexBytes)
+    {
+        // GL_COPY_WRITE_BUFFER não mexe no GL_ELEMENT_ARRAY_BUFFER guardado no VAO
+        size_t offset = job.uploaded - staging.vertexBytes;
+        size_t size = std::min(ASSET_UPLOAD_CHUNK, indexBytes - offset);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, job.gpu.EBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, staging.indexData + offset);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        job.uploaded += size;
+    }
+    return job.uploaded == staging.vertexBytes + indexBytes;
+}
+
+inline TextureSampler assetTextureSampler(AssetLoader &loader, const AssetTexture &texture)
+{
+    const TextureEntry *entry = textureEntry(loader.textureRegistry, texture.handle);
+    return entry ? entry->sampler : TextureSampler();
+}
+
+// Prepara a textura do pedido para receber todos os níveis. Com glTexStorage2D a
+// alocação é imutável e devolve true; uma textura já imutável não pode mudar de
+// tamanho, então a recarga ganha outra (trocada em replaceAssetTexture no fim)
+inline bool beginTextureStorage(AssetJob &job, AssetTexture &texture)
+{
+    if (!glExtensions().texStorage2D)
+        return false;
+    if (texture.immutable)
+    {
+        glGenTextures(1, &job.texture);
+        glBindTexture(GL_TEXTURE_2D, job.texture);
+    }
+    texture.immutable = true;
+    return true;
+}
+
+// Troca a textura do recurso pela recriada na recarga: o handle continua o mesmo e
+// os materiais passam para o nome novo
+inline void replaceAssetTexture(AssetLoader &loader, AssetTexture &texture, GLuint replacement)
+{
+    GLuint old = texture.texture;
+    TextureEntry *entry = textureEntry(loader.textureRegistry, texture.handle);
+    if (entry)
+        entry->texture = replacement;
+    texture.texture = replacement;
+    if (loader.materials)
+        for (Material &material : loader.materials->materials)
+            if (material.diffuseTexture == old)
+                material.diffuseTexture = replacement;
+    glDeleteTextures(1, &old);
+}
+
+// Origem de um glTexSubImage2D: o deslocamento no anel de PBOs (ligado até
+// endAssetUpload) ou, sem anel, os próprios dados. false se o anel está cheio
+inline bool beginAssetUpload(AssetLoader &loader, const unsigned char *data, size_t bytes, const void *&source)
+{
+    source = data;
+    if (loader.uploadRing.buffer == 0)
+        return true;
+    size_t offset = 0;
+    if (!stageUpload(loader.uploadRing, data, bytes, offset))
+        return false;
+    source = (const void *)offset;
+    return true;
+}
+
+inline void endAssetUpload(AssetLoader &loader)
+{
+    if (loader.uploadRing.buffer != 0)
+        finishUpload(loader.uploadRing);
+}
+
+// Envia mais uma faixa de blocos da cadeia comprimida (nível por nível, do maior
+// para o menor); devolve true quando ela está completa
+inline bool uploadCompressedTextureStep(AssetLoader &loader, AssetJob &job)
+{
+    const CompressedTextureStaging &blocks = job.textureData.blocks;
+    AssetTexture &texture = loader.textures[job.textureSlot];
+    const TextureSampler sampler = assetTextureSampler(loader, texture);
+    GLenum format = compressedTextureFormat(blocks.format, blocks.srgb);
+    size_t levelCount = compressedLevelCount(blocks, sampler);
+    glBindTexture(GL_TEXTURE_2D, job.texture);
+    if (!job.started)
+    {
+        // Todos os níveis alocados de uma vez; recarga com o mesmo tamanho e formato reaproveita a memória
+        job.started = true;
+        if (!job.reload || texture.width != blocks.levels[0].width || texture.height != blocks.levels[0].height ||
+            texture.format != format)
+        {
+            if (beginTextureStorage(job, texture))
+                glExtensions().texStorage2D(GL_TEXTURE_2D, (GLsizei)levelCount, format, blocks.levels[0].width,
+                                            blocks.levels[0].height);
+            else
+                for (size_t level = 0; level < levelCount; level++)
+                {
+                    const CompressedLevelView &view = blocks.levels[level];
+                    glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, format, view.width, view.height, 0,
+                                           (GLsizei)view.size, nullptr);
+                }
+        }
+        texture.width = blocks.levels[0].width;
+        texture.height = blocks.levels[0].height;
+        texture.format = format;
+    }
+
+    size_t level = 0, offset = job.uploaded;
+    while (offset >= blocks.levels[level].size)
+        offset -= blocks.levels[level++].size;
+    const CompressedLevelView &view = blocks.levels[level];
+    size_t rowBytes = (size_t)((view.width + 3) / 4) * blockBytes(blocks.format);  // uma linha de blocos
+    int blockRow = (int)(offset / rowBytes);
+    int blockRows = std::min((view.height + 3) / 4 - blockRow, (int)std::max<size_t>(1, ASSET_UPLOAD_CHUNK / rowBytes));
+    int y = blockRow * 4;
+    const void *source;
+    if (!beginAssetUpload(loader, view.data + offset, blockRows * rowBytes, source))
+        return false;
+    glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)level, 0, y, view.width, std::min(blockRows * 4, view.height - y),
+                              format, (GLsizei)(blockRows * rowBytes), source);
+    endAssetUpload(loader);
+    job.uploaded += blockRows * rowBytes;
+    if (job.uploaded < compressedTextureBytes(blocks, sampler))
+        return false;
+
+    if (job.texture != texture.texture)
+        replaceAssetTexture(loader, texture, job.texture);
+    applyTextureSampler(sampler);
+    setTextureLevelRange(levelCount);
+    setTextureImage(loader.textureRegistry, texture.handle, texture.width, texture.height, format,
+                    compressedTextureBytes(blocks, sampler));
+    return true;
+}
+
+// Envia mais um bloco de linhas da textura (nível por nível, com os mipmaps já
+// prontos); devolve true quando ela está completa
+inline bool uploadTextureStep(AssetLoader &loader, AssetJob &job)
+{
+    if (job.textureData.compressed)
+        return uploadCompressedTextureStep(loader, job);
+
+    const ImageStaging &image = job.textureData.image;
+    AssetTexture &texture = loader.textures[job.textureSlot];
+    const TextureSampler sampler = assetTextureSampler(loader, texture);
+    GLenum format = imageTextureFormat(image.channels);
+    size_t levelCount = imageLevelCount(image, sampler);
+    glBindTexture(GL_TEXTURE_2D, job.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (!job.started)
+    {
+        // Recarga com o mesmo tamanho e formato reaproveita a memória da textura
+        job.started = true;
+        if (!job.reload || texture.width != image.width || texture.height != image.height || texture.format != format)
+        {
+            if (beginTextureStorage(job, texture))
+                glExtensions().texStorage2D(GL_TEXTURE_2D, (GLsizei)levelCount, sizedTextureFormat(format),
+                                            image.width, image.height);
+            else
+                for (size_t level = 0; level < levelCount; level++)
+                {
+                    const ImageLevel &view = image.levels[level];
+                    glTexImage2D(GL_TEXTURE_2D, (GLint)level, format, view.width, view.height, 0, format,
+                                 GL_UNSIGNED_BYTE, nullptr);
+                }
+        }
+        texture.width = image.width;
+        texture.height = image.height;
+        texture.format = format;
+    }
+
+    // Os níveis estão um depois do outro a partir de image.pixels
+    size_t level = 0, offset = job.uploaded;
+    while (offset >= imageLevelBytes(image, level))
+        offset -= imageLevelBytes(image, level++);
+    const ImageLevel &view = image.levels[level];
+    size_t rowBytes = (size_t)view.width * image.channels;
+    int row = (int)(offset / rowBytes);
+    int rows = std::min(view.height - row, (int)std::max<size_t>(1, ASSET_UPLOAD_CHUNK / rowBytes));
+    const void *source;
+    if (!beginAssetUpload(loader, view.pixels + offset, rows * rowBytes, source))
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        return false;
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, (GLint)level, 0, row, view.width, rows, format, GL_UNSIGNED_BYTE, source);
+    endAssetUpload(loader);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    job.uploaded += rows * rowBytes;
+    size_t totalBytes = 0;
+    for (size_t i = 0; i < levelCount; i++)
+        totalBytes += imageLevelBytes(image, i);
+    if (job.uploaded < totalBytes)
+        return false;
+
+    if (job.texture != texture.texture)
+        replaceAssetTexture(loader, texture, job.texture);
+    applyTextureSampler(sampler);
+    setTextureLevelRange(levelCount);
+    setTextureImage(loader.textureRegistry, texture.handle, image.width, image.height, format,
+                    imageTextureBytes(image, sampler));
+    return true;
+}
+
+// Cria os arrays no primeiro passo e envia mais um bloco de linhas (ou de linhas de
+// blocos) de uma camada: as camadas vão uma depois da outra, cada uma nível por nível.
+// Devolve true quando todas foram enviadas
+inline bool uploadTextureArrayStep(AssetLoader &loader, AssetJob &job)
+{
+    const TextureArrayStaging &staging = job.arrayData;
+    const TextureArraySet &set = job.arrays;
+    if (!job.started)
+    {
+        job.started = true;
+        beginTextureArrays(job.arrays, staging);
+    }
+
+    // Camada, nível e deslocamento no nível que correspondem a job.uploaded
+    size_t index = 0, level = 0, offset = job.uploaded;
+    for (; index < staging.paths.size(); index++)
+    {
+        if (set.array[index] < 0)
+            continue;
+        size_t levels = set.arrays[set.array[index]].levels;
+        for (level = 0; level < levels && offset >= textureArrayLevelBytes(staging, index, level); level++)
+            offset -= textureArrayLevelBytes(staging, index, level);
+        if (level < levels)
+            break;
+    }
+    if (index == staging.paths.size())
+        return true;
+
+    const TextureArray &array = set.arrays[set.array[index]];
+    const TextureStaging &layer = staging.layers[index];
+    GLint z = set.layer[index];
+    size_t bytes;
+    const void *source;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+    if (layer.compressed)
+    {
+        const CompressedLevelView &view = layer.blocks.levels[level];
+        size_t rowBytes = (size_t)((view.width + 3) / 4) * blockBytes(layer.blocks.format);
+        int blockRow = (int)(offset / rowBytes);
+        int blockRows =
+            std::min((view.height + 3) / 4 - blockRow, (int)std::max<size_t>(1, ASSET_UPLOAD_CHUNK / rowBytes));
+        int y = blockRow * 4;
+        bytes = blockRows * rowBytes;
+        if (!beginAssetUpload(loader, view.data + offset, bytes, source))
+            return false;
+        glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, 0, y, z, view.width,
+                                  std::min(blockRows * 4, view.height - y), 1, array.format, (GLsizei)bytes, source);
+    }
+    else
+    {
+        const ImageLevel &view = layer.image.levels[level];
+        size_t rowBytes = (size_t)view.width * layer.image.channels;
+        int row = (int)(offset / rowBytes);
+        int rows = std::min(view.height - row, (int)std::max<size_t>(1, ASSET_UPLOAD_CHUNK / rowBytes));
+        bytes = rows * rowBytes;
+        if (!beginAssetUpload(loader, view.pixels + offset, bytes, source))
+            return false;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, 0, row, z, view.width, rows, 1, array.format,
+                        GL_UNSIGNED_BYTE, source);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    endAssetUpload(loader);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    job.uploaded += bytes;
+    return job.uploaded == textureArrayUploadBytes(set, staging);
+}
+
+// Troca os arrays em uso pelos novos e aponta os materiais para as camadas
+inline void finishTextureArrayUpload(AssetLoader &loader, AssetJob &job)
+{
+    destroyTextureArrays(loader.textureArrays);
+    loader.textureArrays = std::move(job.arrays);
+    job.arrays = TextureArraySet();
+    if (loader.materials)
+        assignMaterialLayers(loader.textureArrays, *loader.materials);
+    printTextureArrays(loader.textureArrays);
+}
+
+// Fim de um pedido (com ou sem sucesso): libera o recurso para uma nova recarga
+inline void releaseAssetSlot(AssetLoader &loader, const AssetJob &job)
+{
+    if (job.type == ASSET_MESH)
+    {
+        AssetMeshSlot &slot = loader.meshSlots[job.mesh];
+        slot.loading = false;
+        if (slot.changed)
+        {
+            slot.changed = false;
+            queueMeshJob(loader, job.mesh, true);
+        }
+        return;
+    }
+    if (job.type == ASSET_TEXTURE_ARRAY)
+    {
+        loader.arraysLoading = false;
+        if (loader.arraysChanged)
+        {
+            loader.arraysChanged = false;
+            queueTextureArrayJob(loader);
+        }
+        return;
+    }
+
+    AssetTexture &texture = loader.textures[job.textureSlot];
+    texture.loading = false;
+    releaseTexture(loader.textureRegistry, texture.handle);
+    if (texture.changed)
+    {
+        texture.changed = false;
+        queueTextureJob(loader, job.textureSlot, true);
+    }
+}
+
+// Move os pedidos prontos da pilha para a fila de envio, na ordem de chegada
+inline void collectCompletedAssets(AssetLoader &loader)
+{
+    AssetJob *completed = loader.completed.exchange(nullptr, std::memory_order_acquire);
+    std::vector<AssetJob *> arrived;
+    for (; completed; completed = completed->next)
+        arrived.push_back(completed);
+    loader.uploads.insert(loader.uploads.end(), arrived.rbegin(), arrived.rend());
+}
+
+// Chamada uma vez por quadro na thread da OpenGL: recolhe os pedidos prontos e envia
+// dados até esgotar budgetMs (pelo menos um pedaço por quadro, para a fila andar)
+inline void updateAssetLoader(AssetLoader &loader, double budgetMs = ASSET_UPLOAD_BUDGET_MS)
+{
+    collectCompletedAssets(loader);
+    updateTextureRegistry(loader.textureRegistry);
+    if (loader.uploadRing.buffer != 0)
+        retireUploads(loader.uploadRing);
+    if (loader.hotReload)
+        reloadChangedAssets(loader);
+
+    auto start = std::chrono::steady_clock::now();
+    while (!loader.uploads.empty())
+    {
+        AssetJob *job = loader.uploads.front();
+        size_t uploaded = job->uploaded;
+        bool done = true;
+        if (job->loaded && job->type == ASSET_MESH)
+        {
+            done = uploadMeshStep(loader, *job);
+            if (done && job->loaded)
+                finishMeshUpload(loader, *job);
+        }
+        else if (job->loaded && job->type == ASSET_TEXTURE)
+            done = uploadTextureStep(loader, *job);
+        else if (job->loaded)
+        {
+            done = uploadTextureArrayStep(loader, *job);
+            if (done)
+                finishTextureArrayUpload(loader, *job);
+        }
+
+        if (done)
+        {
+            loader.uploads.pop_front();
+            releaseAssetSlot(loader, *job);
+            delete job;
+        }
+        else if (job->uploaded == uploaded)
+            break;  // todo passo envia um pedaço, a não ser com o anel de PBOs cheio: espera a GPU
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() >= budgetMs)
+            break;
+    }
+}
+
+// Encerra as threads (pedidos em andamento são descartados) e apaga malhas e texturas criadas
+inline void stopAssetLoader(AssetLoader &loader)
+{
+    {
+        std::lock_guard<std::mutex> lock(loader.mutex);
+        loader.stopping = true;
+    }
+    loader.wake.notify_all();
+    for (std::thread &worker : loader.workers)
+        worker.join();
+    loader.workers.clear();
+
+    for (AssetJob *job : loader.requests)
+        delete job;
+    loader.requests.clear();
+    collectCompletedAssets(loader);
+    for (AssetJob *job : loader.uploads)
+    {
+        destroyTextureArrays(job->arrays);
+        if (job->type == ASSET_TEXTURE && job->texture != loader.textures[job->textureSlot].texture)
+            glDeleteTextures(1, &job->texture);  // recriada por uma recarga que não terminou
+        if (job->sharesMesh)
+        {
+            // Uma recarga só é dona dos buffers que ela mesma criou
+            const GPUMesh &current = loader.meshes[job->mesh];
+            if (job->gpu.VBO != current.VBO)
+                glDeleteBuffers(1, &job->gpu.VBO);
+            if (job->gpu.EBO != current.EBO)
+                glDeleteBuffers(1, &job->gpu.EBO);
+        }
+        else if (!job->arena)
+        {
+            glDeleteVertexArrays(1, &job->gpu.VAO);
+            glDeleteBuffers(1, &job->gpu.VBO);
+            glDeleteBuffers(1, &job->gpu.EBO);
+        }
+        delete job;
+    }
+    loader.uploads.clear();
+
+    for (size_t i = 0; i < loader.meshes.size(); i++)
+        if (loader.meshSlots[i].ready && !loader.meshSlots[i].arena)
+            deleteMesh(loader.meshes[i]);  // as malhas de arena são apagadas com destroyMeshArena
+    loader.meshes.clear();
+    loader.meshSlots.clear();
+    deleteMesh(loader.placeholderMesh);
+    destroyUploadRing(loader.uploadRing);
+    destroyTextureRegistry(loader.textureRegistry);
+    loader.textures.clear();
+    destroyTextureArrays(loader.textureArrays);
+    closeFileWatcher(loader.watcher);
+}
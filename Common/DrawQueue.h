@@ -0,0 +1,187 @@
+/*
+ *  DrawQueue.h
+ *
+ *  Fila de desenho ordenada por material. Durante o quadro cada objeto envia as
+ *  faixas de índices que quer desenhar (um MeshSubset por material do nível de
+ *  detalhe escolhido, ou as faixas visíveis de cullMeshlets); flushDrawQueue
+ *  ordena tudo por material, malha e objeto e percorre a lista uma vez:
+ *
+ *  - bindMaterial é chamado uma vez por material (textura e uniforms do material);
+ *  - o VAO só é trocado quando muda (malhas de um MeshArena dividem o mesmo);
+ *  - bindObject é chamado quando o objeto muda (model e demais uniforms do objeto);
+ *  - faixas seguidas com o mesmo estado viram um único glMultiDrawElements.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  DrawQueue queue;
+ *  ...
+ *  clearDrawQueue(queue);
+ *  submitMeshLOD(queue, mesh, lod, objectIndex);  // ou submitMeshlets(queue, mesh, drawList, objectIndex)
+ *  flushDrawQueue(queue, materials,
+ *                 [&](const Material &material) { ... },
+ *                 [&](uint32_t object) { ... });
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Material.h"
+#include "Mesh.h"
+#include "Meshlet.h"
+
+struct DrawItem
+{
+    uint32_t material;    // índice na MaterialLibrary
+    uint32_t object;      // índice repassado a bindObject
+    const GPUMesh *mesh;
+    GLsizei count;
+    const void *offset;   // deslocamento em bytes no EBO (sem EBO: primeiro vértice)
+};
+
+struct DrawQueue
+{
+    std::vector<DrawItem> items;
+    std::vector<GLsizei> counts;        // faixas do glMultiDrawElements em montagem
+    std::vector<const void *> offsets;
+    size_t materialBinds = 0;           // estatísticas do último flushDrawQueue
+    size_t drawCalls = 0;
+};
+
+inline void clearDrawQueue(DrawQueue &queue)
+{
+    queue.items.clear();
+}
+
+inline uint32_t meshMaterialId(const GPUMesh &mesh, uint32_t material)
+{
+    return material < mesh.materialIds.size() ? mesh.materialIds[material] : 0;
+}
+
+inline const void *meshIndexOffset(const GPUMesh &mesh, uint32_t index)
+{
+    size_t indexSize = mesh.EBO == 0 ? 1 : mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    return (const void *)(uintptr_t)(index * indexSize);
+}
+
+// Enfileira os materiais de um nível de detalhe (lod fora da faixa: malha completa)
+inline void submitMeshLOD(DrawQueue &queue, const GPUMesh &mesh, size_t lod, uint32_t object)
+{
+    uint32_t level = lod < mesh.lods.size() ? (uint32_t)lod : 0;
+    if (mesh.subsets.empty())
+    {
+        uint32_t first = mesh.lods.empty() ? 0 : mesh.lods[level].indexOffset;
+        GLsizei count = mesh.lods.empty() ? mesh.indexCount : (GLsizei)mesh.lods[level].indexCount;
+        queue.items.push_back({meshMaterialId(mesh, 0), object, &mesh, count, meshIndexOffset(mesh, first)});
+        return;
+    }
+
+    for (const MeshSubset &subset : mesh.subsets)
+        if (subset.lod == level)
+            queue.items.push_back({meshMaterialId(mesh, subset.material), object, &mesh, (GLsizei)subset.indexCount,
+                                   meshIndexOffset(mesh, subset.indexOffset)});
+}
+
+// Enfileira as faixas visíveis de cullMeshlets, cada uma com o material do seu subset
+inline void submitMeshlets(DrawQueue &queue, const GPUMesh &mesh, const MeshletDrawList &drawList, uint32_t object)
+{
+    if (mesh.meshlets.empty())
+    {
+        submitMeshLOD(queue, mesh, 0, object);
+        return;
+    }
+
+    for (size_t i = 0; i < drawList.counts.size(); i++)
+    {
+        uint32_t subset = drawList.subsets[i];
+        uint32_t material = subset < mesh.subsets.size() ? mesh.subsets[subset].material : 0;
+        queue.items.push_back({meshMaterialId(mesh, material), object, &mesh, drawList.counts[i],
+                               drawList.offsets[i]});
+    }
+}
+
+// Ordem de desenho: material, depois VAO, depois malha, depois objeto. flushDrawQueue
+// agrupa pela mesma chave, então itens da mesma malha ficam sempre contíguos
+inline void sortDrawQueue(DrawQueue &queue)
+{
+    std::stable_sort(queue.items.begin(), queue.items.end(), [](const DrawItem &a, const DrawItem &b) {
+        if (a.material != b.material)
+            return a.material < b.material;
+        if (a.mesh->VAO != b.mesh->VAO)
+            return a.mesh->VAO < b.mesh->VAO;
+        if (a.mesh != b.mesh)
+            return std::less<const GPUMesh *>()(a.mesh, b.mesh);
+        return a.object < b.object;
+    });
+}
+
+template <typename BindMaterial, typename BindObject>
+void flushDrawQueue(DrawQueue &queue, const MaterialLibrary &library, BindMaterial bindMaterial,
+                    BindObject bindObject)
+{
+    sortDrawQueue(queue);
+    std::vector<DrawItem> &items = queue.items;
+
+    queue.materialBinds = 0;
+    queue.drawCalls = 0;
+    const uint32_t none = ~0u;
+    uint32_t material = none;
+    uint32_t object = none;
+    const GPUMesh *mesh = nullptr;
+    size_t i = 0;
+    while (i < items.size())
+    {
+        const DrawItem &item = items[i];
+        if (item.material != material)
+        {
+            material = item.material;
+            bindMaterial(library.materials[material < library.materials.size() ? material : 0]);
+            queue.materialBinds++;
+        }
+        if (item.mesh != mesh)
+        {
+            if (!mesh || item.mesh->VAO != mesh->VAO)
+                glBindVertexArray(item.mesh->VAO);
+            mesh = item.mesh;
+        }
+        if (item.object != object)
+        {
+            object = item.object;
+            bindObject(object);
+        }
+
+        queue.counts.clear();
+        queue.offsets.clear();
+        for (; i < items.size() && items[i].material == material && items[i].mesh == mesh &&
+               items[i].object == object;
+             i++)
+        {
+            queue.counts.push_back(items[i].count);
+            queue.offsets.push_back(items[i].offset);
+        }
+
+        if (mesh->EBO == 0)
+        {
+            for (size_t k = 0; k < queue.counts.size(); k++, queue.drawCalls++)
+                glDrawArrays(GL_TRIANGLES, (GLint)(uintptr_t)queue.offsets[k], queue.counts[k]);
+        }
+        else if (queue.counts.size() == 1)
+        {
+            glDrawElements(GL_TRIANGLES, queue.counts[0], mesh->indexType, queue.offsets[0]);
+            queue.drawCalls++;
+        }
+        else
+        {
+            glMultiDrawElements(GL_TRIANGLES, queue.counts.data(), mesh->indexType, queue.offsets.data(),
+                                (GLsizei)queue.counts.size());
+            queue.drawCalls++;
+        }
+    }
+    glBindVertexArray(0);
+}
@@ -0,0 +1,185 @@
+/*
+ *  FileWatcher.h
+ *
+ *  Observa arquivos e informa quais foram alterados, sem bloquear quem chama.
+ *
+ *  No Linux cada pasta dos arquivos observados recebe um watch do inotify
+ *  (IN_CLOSE_WRITE e IN_MOVED_TO, que cobrem editores que salvam em um arquivo
+ *  temporário e renomeiam) e o descritor é lido em modo não bloqueante. Nos
+ *  outros sistemas, ou se o inotify falhar, a data de modificação de cada
+ *  arquivo é consultada a cada FILE_WATCH_POLL_MS.
+ *
+ *  Alterações seguidas do mesmo arquivo (um programa que grava em vários
+ *  passos) são agrupadas: o arquivo só é informado depois de FILE_WATCH_SETTLE_MS
+ *  sem novos eventos.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  FileWatcher watcher;
+ *  watchFile(watcher, "../assets/Modelos3D/Suzanne.png");
+ *  for (const std::string &path : pollFileWatcher(watcher))  // uma vez por quadro
+ *      ...;
+ *  closeFileWatcher(watcher);
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+const double FILE_WATCH_POLL_MS = 500.0;
+const double FILE_WATCH_SETTLE_MS = 100.0;
+
+struct WatchedFile
+{
+    std::string path;       // como foi pedido em watchFile
+    std::string directory;  // pasta e nome, para comparar com os eventos do inotify
+    std::string name;
+    std::filesystem::file_time_type time;
+    bool pending = false;
+    std::chrono::steady_clock::time_point changedAt;
+};
+
+struct FileWatcher
+{
+    std::vector<WatchedFile> files;
+    int inotify = -1;
+    std::vector<std::pair<int, std::string>> directories;  // watch do inotify -> pasta
+    std::chrono::steady_clock::time_point lastPoll;
+    bool initialized = false;
+};
+
+inline std::filesystem::file_time_type fileWatchTime(const std::string &path)
+{
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+    return error ? std::filesystem::file_time_type() : time;
+}
+
+inline void initFileWatcher(FileWatcher &watcher)
+{
+    watcher.initialized = true;
+    watcher.lastPoll = std::chrono::steady_clock::now();
+#ifdef __linux__
+    watcher.inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+// Observa path (uma vez; pedidos repetidos são ignorados)
+inline void watchFile(FileWatcher &watcher, const std::string &path)
+{
+    if (!watcher.initialized)
+        initFileWatcher(watcher);
+
+    std::error_code error;
+    std::filesystem::path absolute = std::filesystem::weakly_canonical(path, error);
+    if (error)
+        absolute = std::filesystem::absolute(path);
+    WatchedFile file;
+    file.path = path;
+    file.directory = absolute.parent_path().string();
+    file.name = absolute.filename().string();
+    for (const WatchedFile &other : watcher.files)
+        if (other.directory == file.directory && other.name == file.name)
+            return;
+    file.time = fileWatchTime(path);
+    watcher.files.push_back(file);
+
+#ifdef __linux__
+    if (watcher.inotify < 0)
+        return;
+    for (const auto &directory : watcher.directories)
+        if (directory.second == file.directory)
+            return;
+    int watch = inotify_add_watch(watcher.inotify, file.directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch >= 0)
+        watcher.directories.push_back({watch, file.directory});
+    else
+    {
+        // Sem watch para esta pasta: volta para a consulta periódica
+        close(watcher.inotify);
+        watcher.inotify = -1;
+        watcher.directories.clear();
+    }
+#endif
+}
+
+inline void markFileChanged(WatchedFile &file, std::chrono::steady_clock::time_point now)
+{
+    file.pending = true;
+    file.changedAt = now;
+}
+
+// Devolve os arquivos alterados desde a última chamada (já estáveis há FILE_WATCH_SETTLE_MS)
+inline std::vector<std::string> pollFileWatcher(FileWatcher &watcher)
+{
+    std::vector<std::string> changed;
+    if (watcher.files.empty())
+        return changed;
+    auto now = std::chrono::steady_clock::now();
+
+#ifdef __linux__
+    if (watcher.inotify >= 0)
+    {
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(watcher.inotify, buffer, sizeof(buffer))) > 0)
+            for (char *p = buffer; p < buffer + length;)
+            {
+                const inotify_event *event = (const inotify_event *)p;
+                p += sizeof(inotify_event) + event->len;
+                if (event->len == 0)
+                    continue;
+                for (const auto &directory : watcher.directories)
+                    if (directory.first == event->wd)
+                        for (WatchedFile &file : watcher.files)
+                            if (file.directory == directory.second && file.name == event->name)
+                                markFileChanged(file, now);
+            }
+    }
+#endif
+
+    std::chrono::duration<double, std::milli> sincePoll = now - watcher.lastPoll;
+    if (watcher.inotify < 0 && sincePoll.count() >= FILE_WATCH_POLL_MS)
+    {
+        watcher.lastPoll = now;
+        for (WatchedFile &file : watcher.files)
+        {
+            std::filesystem::file_time_type time = fileWatchTime(file.path);
+            if (time != file.time)
+            {
+                file.time = time;
+                markFileChanged(file, now);
+            }
+        }
+    }
+
+    for (WatchedFile &file : watcher.files)
+    {
+        std::chrono::duration<double, std::milli> settled = now - file.changedAt;
+        if (file.pending && settled.count() >= FILE_WATCH_SETTLE_MS)
+        {
+            file.pending = false;
+            changed.push_back(file.path);
+        }
+    }
+    return changed;
+}
+
+inline void closeFileWatcher(FileWatcher &watcher)
+{
+#ifdef __linux__
+    if (watcher.inotify >= 0)
+        close(watcher.inotify);
+#endif
+    watcher = FileWatcher();
+}
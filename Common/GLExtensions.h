@@ -0,0 +1,100 @@
+/*
+ *  GLExtensions.h
+ *
+ *  Funções da OpenGL mais novas que o glad do projeto (gerado para o núcleo
+ *  4.0, sem extensões). Elas são carregadas à parte, com o mesmo loader passado
+ *  ao glad, e ficam nulas quando o driver não tem a versão nem a extensão
+ *  correspondente; quem as usa confere o ponteiro e segue pelo caminho antigo.
+ *
+ *  glTexStorage2D/3D   4.2 ou GL_ARB_texture_storage (texturas imutáveis)
+ *  glBufferStorage     4.4 ou GL_ARB_buffer_storage (mapeamento persistente)
+ *  glMultiDrawElementsIndirect
+ *                      4.3 ou GL_ARB_multi_draw_indirect com baseInstance
+ *                      (4.2 ou GL_ARB_base_instance)
+ *
+ *  Forma de uso
+ *  -----------------
+ *  gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+ *  loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+ *  if (glExtensions().texStorage2D)
+ *      glExtensions().texStorage2D(GL_TEXTURE_2D, niveis, GL_RGBA8, largura, altura);
+ *
+ */
+
+#pragma once
+
+#include <cstring>
+
+#include <glad/glad.h>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_TEXTURE_IMMUTABLE_FORMAT
+#define GL_TEXTURE_IMMUTABLE_FORMAT 0x912F
+#endif
+
+typedef void(APIENTRYP GLTexStorage2DFunction)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width,
+                                               GLsizei height);
+typedef void(APIENTRYP GLTexStorage3DFunction)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width,
+                                               GLsizei height, GLsizei depth);
+typedef void(APIENTRYP GLBufferStorageFunction)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef void(APIENTRYP GLMultiDrawElementsIndirectFunction)(GLenum mode, GLenum type, const void *indirect,
+                                                            GLsizei drawcount, GLsizei stride);
+
+struct GLExtensionFunctions
+{
+    GLTexStorage2DFunction texStorage2D = nullptr;
+    GLTexStorage3DFunction texStorage3D = nullptr;
+    GLBufferStorageFunction bufferStorage = nullptr;
+    GLMultiDrawElementsIndirectFunction multiDrawElementsIndirect = nullptr;
+};
+
+inline GLExtensionFunctions &glExtensions()
+{
+    static GLExtensionFunctions functions;
+    return functions;
+}
+
+inline bool hasGLExtension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        const char *extension = (const char *)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (extension && strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Versão do contexto atual é pelo menos major.minor
+inline bool hasGLVersion(GLint major, GLint minor)
+{
+    GLint currentMajor = 0, currentMinor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &currentMajor);
+    glGetIntegerv(GL_MINOR_VERSION, &currentMinor);
+    return currentMajor > major || (currentMajor == major && currentMinor >= minor);
+}
+
+// Precisa de um contexto da OpenGL atual (depois de gladLoadGLLoader)
+inline void loadGLExtensions(GLADloadproc load)
+{
+    GLExtensionFunctions &functions = glExtensions();
+    functions = GLExtensionFunctions();
+    if (hasGLVersion(4, 2) || hasGLExtension("GL_ARB_texture_storage"))
+    {
+        functions.texStorage2D = (GLTexStorage2DFunction)load("glTexStorage2D");
+        functions.texStorage3D = (GLTexStorage3DFunction)load("glTexStorage3D");
+    }
+    if (hasGLVersion(4, 4) || hasGLExtension("GL_ARB_buffer_storage"))
+        functions.bufferStorage = (GLBufferStorageFunction)load("glBufferStorage");
+    // O caminho indireto (IndirectDraw.h) usa baseInstance para achar os dados de cada objeto
+    if (hasGLVersion(4, 3) ||
+        (hasGLExtension("GL_ARB_multi_draw_indirect") &&
+         (hasGLVersion(4, 2) || hasGLExtension("GL_ARB_base_instance"))))
+        functions.multiDrawElementsIndirect =
+            (GLMultiDrawElementsIndirectFunction)load("glMultiDrawElementsIndirect");
+}
@@ -0,0 +1,226 @@
+/*
+ *  ImageCache.h
+ *
+ *  Imagens decodificadas guardadas no cache compartilhado (AssetCache.h). Na
+ *  primeira carga a imagem passa pelo decodificador (ex.: stbi_load), ganha a
+ *  cadeia de mipmaps gerada na CPU (Mipmap.h) e tudo é gravado sem compressão;
+ *  nas seguintes a entrada é mapeada em memória e cada nível vai direto para
+ *  glTexImage2D/glTexSubImage2D, sem decodificar o .PNG nem chamar
+ *  glGenerateMipmap.
+ *
+ *  A chave inclui as opções que mudam os pixels decodificados (ex.: "flip" quando
+ *  stbi_set_flip_vertically_on_load(true) está ativo) e o filtro dos mipmaps,
+ *  então quem carrega a mesma imagem com outras opções ganha outra entrada.
+ *
+ *  Formato (versão 2)
+ *  -----------------
+ *  ImageCacheHeader  identificação, dimensões, canais, número de níveis e hash da origem
+ *  pixels            os níveis do maior (width x height) até 1x1, cada um com
+ *                    largura * altura * channels bytes, linha a linha, a partir de
+ *                    sizeof(ImageCacheHeader)
+ *
+ *  Forma de uso
+ *  -----------------
+ *  ImageStaging image;
+ *  if (loadImageStaging("../assets/tex/pixelWall.png", loadImage, stbi_image_free, image))
+ *      for (size_t level = 0; level < image.levels.size(); level++)
+ *          glTexImage2D(GL_TEXTURE_2D, level, GL_RGB, image.levels[level].width, image.levels[level].height, 0,
+ *                       GL_RGB, GL_UNSIGNED_BYTE, image.levels[level].pixels);
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "AssetCache.h"
+#include "MappedFile.h"
+#include "Mipmap.h"
+
+const char IMAGE_CACHE_MAGIC[4] = {'C', 'G', 'I', 'M'};
+const uint32_t IMAGE_CACHE_VERSION = 2;
+
+// Decodificador de imagens (ex.: stbi_load com 0 canais pedidos) e a função que libera o resultado
+typedef unsigned char *(*ImageLoadFunction)(const char *path, int *width, int *height, int *channels);
+typedef void (*ImageFreeFunction)(void *pixels);
+
+struct ImageCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t levels;  // níveis de mipmap gravados, contando o maior
+    uint64_t sourceHash;
+};
+
+static_assert(std::is_trivially_copyable<ImageCacheHeader>::value, "ImageCacheHeader deve ser copiavel byte a byte");
+
+// Um nível de mipmap dentro de ImageStaging
+struct ImageLevel
+{
+    int width = 0;
+    int height = 0;
+    const unsigned char *pixels = nullptr;
+};
+
+// Pixels prontos para a GPU: apontam para a entrada mapeada em file ou para owned
+// quando a imagem acabou de ser decodificada. pixels é o nível 0; levels tem a
+// cadeia inteira (só o nível 0 enquanto os mipmaps não foram gerados)
+struct ImageStaging
+{
+    MappedFile file;
+    std::vector<unsigned char> owned;
+    const unsigned char *pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<ImageLevel> levels;
+};
+
+inline std::string imageCachePath(uint64_t sourceHash, const std::string &settings, const MipSettings &mips)
+{
+    return assetCachePath(assetCacheKey(sourceHash, "image " + std::to_string(IMAGE_CACHE_VERSION) + " " + settings +
+                                                        " " + mipSettingsKey(mips)),
+                          ".image");
+}
+
+inline size_t imageLevelBytes(const ImageStaging &image, size_t level)
+{
+    return (size_t)image.levels[level].width * image.levels[level].height * image.channels;
+}
+
+// Aponta levels para levelCount níveis guardados um depois do outro a partir de image.pixels
+inline void setImageLevels(ImageStaging &image, int levelCount)
+{
+    image.levels.clear();
+    const unsigned char *pixels = image.pixels;
+    for (int level = 0; level < levelCount; level++)
+    {
+        ImageLevel view;
+        view.width = mipLevelWidth(image.width, level);
+        view.height = mipLevelHeight(image.height, level);
+        view.pixels = pixels;
+        image.levels.push_back(view);
+        pixels += (size_t)view.width * view.height * image.channels;
+    }
+}
+
+// Acrescenta a cadeia de mipmaps ao nível 0 decodificado em owned
+inline void generateImageMips(ImageStaging &image, const MipSettings &mips)
+{
+    std::vector<unsigned char> chain = buildMipChain(image.pixels, image.width, image.height, image.channels, mips);
+    image.owned.insert(image.owned.end(), chain.begin(), chain.end());
+    image.pixels = image.owned.data();
+    setImageLevels(image, mipLevelCount(image.width, image.height));
+}
+
+inline bool writeImageCache(const std::string &cachePath, const ImageStaging &image, uint64_t sourceHash)
+{
+    ImageCacheHeader header = {};
+    memcpy(header.magic, IMAGE_CACHE_MAGIC, sizeof(header.magic));
+    header.version = IMAGE_CACHE_VERSION;
+    header.width = (uint32_t)image.width;
+    header.height = (uint32_t)image.height;
+    header.channels = (uint32_t)image.channels;
+    header.levels = (uint32_t)image.levels.size();
+    header.sourceHash = sourceHash;
+
+    std::string tempPath = assetCacheTempPath(cachePath);
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+        out.write((const char *)&header, sizeof(header));
+        out.write((const char *)image.pixels, (std::streamsize)image.owned.size());
+        if (!out)
+        {
+            out.close();
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+    return commitAssetCacheFile(tempPath, cachePath);
+}
+
+// Mapeia a entrada cachePath em image se ela é válida e veio da origem sourceHash
+inline bool openImageCache(const std::string &cachePath, uint64_t sourceHash, ImageStaging &image)
+{
+    if (image.file.open(cachePath) && image.file.size >= sizeof(ImageCacheHeader))
+    {
+        const ImageCacheHeader *header = (const ImageCacheHeader *)image.file.data;
+        if (memcmp(header->magic, IMAGE_CACHE_MAGIC, 4) == 0 && header->version == IMAGE_CACHE_VERSION &&
+            header->sourceHash == sourceHash && header->channels >= 1 && header->channels <= 4 &&
+            header->width >= 1 && header->height >= 1 && header->width <= 0x10000 && header->height <= 0x10000 &&
+            header->levels == (uint32_t)mipLevelCount((int)header->width, (int)header->height) &&
+            image.file.size >= sizeof(ImageCacheHeader) +
+                                   mipChainBytes((int)header->width, (int)header->height, (int)header->channels))
+        {
+            image.pixels = (const unsigned char *)image.file.data + sizeof(ImageCacheHeader);
+            image.width = (int)header->width;
+            image.height = (int)header->height;
+            image.channels = (int)header->channels;
+            setImageLevels(image, (int)header->levels);
+            touchAssetCacheEntry(cachePath);
+            return true;
+        }
+    }
+    image.file.close();
+    return false;
+}
+
+// Decodifica path para image.owned (só o nível 0), sem passar pelo cache
+inline bool decodeImageStaging(const std::string &path, ImageLoadFunction decode, ImageFreeFunction freeImage,
+                               ImageStaging &image)
+{
+    unsigned char *pixels = decode ? decode(path.c_str(), &image.width, &image.height, &image.channels) : nullptr;
+    if (!pixels || image.channels < 1 || image.channels > 4)
+    {
+        if (pixels && freeImage)
+            freeImage(pixels);
+        std::cerr << "Erro ao tentar ler o arquivo " << path << std::endl;
+        return false;
+    }
+    image.owned.assign(pixels, pixels + (size_t)image.width * image.height * image.channels);
+    if (freeImage)
+        freeImage(pixels);
+    image.pixels = image.owned.data();
+    setImageLevels(image, 1);
+    return true;
+}
+
+// Parte do carregamento que não usa OpenGL (pode rodar nas threads de AssetLoader.h):
+// usa a entrada do cache quando existe; senão decodifica com decode, gera os mipmaps
+// e grava a entrada. settings descreve as opções do decodificador que mudam os pixels
+// (ex.: "flip"); mips, o filtro da cadeia
+inline bool loadImageStaging(const std::string &path, ImageLoadFunction decode, ImageFreeFunction freeImage,
+                             ImageStaging &image, const std::string &settings = "",
+                             const MipSettings &mips = MipSettings())
+{
+    AssetSource source;
+    if (!statAssetSource(path, source))
+    {
+        std::cerr << "Erro ao tentar ler o arquivo " << path << std::endl;
+        return false;
+    }
+
+    std::string cachePath = imageCachePath(source.hash, settings, mips);
+    if (openImageCache(cachePath, source.hash, image))
+        return true;
+
+    if (!decodeImageStaging(path, decode, freeImage, image))
+        return false;
+    generateImageMips(image, mips);
+    if (!writeImageCache(cachePath, image, source.hash))
+        std::cerr << "Nao foi possivel gravar o cache de imagem " << cachePath << std::endl;
+    return true;
+}
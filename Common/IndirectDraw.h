@@ -0,0 +1,258 @@
+/*
+ *  IndirectDraw.h
+ *
+ *  Desenho dirigido por buffers: em vez de bindObject + glDrawElements por
+ *  objeto, flushDrawQueueIndirect escreve um DrawElementsIndirectCommand por
+ *  faixa da DrawQueue e envia cada sequência com o mesmo material e o mesmo VAO
+ *  em um único glMultiDrawElementsIndirect. Com as malhas em uma MeshArena
+ *  (mesmo VAO), são um comando de desenho por material para a cena inteira,
+ *  não importa quantas malhas e objetos diferentes ela tenha.
+ *
+ *  Os dados de cada objeto (matriz model e cor, InstanceData) vão para um VBO
+ *  de instâncias, como em InstanceBuffer.h, e cada comando leva o índice do
+ *  objeto em baseInstance: com instanceCount = 1 e divisor 1, o atributo lido
+ *  pelo vertex shader é exatamente o do objeto. Isso faz o papel de gl_DrawID +
+ *  SSBO sem exigir GLSL 4.3/4.6 (os shaders do projeto são #version 400):
+ *
+ *  layout (location = N) in mat4 model;           // N .. N+3
+ *  layout (location = N + 4) in vec4 objectColor;
+ *
+ *  Os comandos ficam em um buffer mapeado de forma persistente (glBufferStorage)
+ *  dividido em INDIRECT_DRAW_FRAMES partes: a CPU escreve a parte de um quadro
+ *  enquanto a GPU ainda lê as dos quadros anteriores, e uma fence por parte
+ *  impede que ela seja reescrita antes da hora. Sem glBufferStorage, o buffer é
+ *  reenviado com glBufferData + glBufferSubData a cada quadro.
+ *
+ *  glMultiDrawElementsIndirect é carregado por GLExtensions.h; quando o driver
+ *  não tem a função, indirectDrawSupported devolve false e o programa continua
+ *  com flushDrawQueue, passando os dados do objeto em bindObject com
+ *  setObjectAttributes. Só malhas com EBO entram no caminho indireto.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  IndirectDrawBuffer indirect;
+ *  createIndirectDrawBuffer(indirect, 4);  // localizações 4..8
+ *  ...
+ *  objects.push_back({model, color});      // vector<InstanceData>; índice = objeto da fila
+ *  submitMeshLOD(queue, mesh, lod, (uint32_t)objects.size() - 1);
+ *  if (indirectDrawSupported())
+ *      flushDrawQueueIndirect(queue, materials, indirect, objects, bindMaterial);
+ *  else
+ *      flushDrawQueue(queue, materials, bindMaterial,
+ *                     [&](uint32_t object) { setObjectAttributes(4, objects[object]); });
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "DrawQueue.h"
+#include "GLExtensions.h"
+#include "InstanceBuffer.h"
+
+const int INDIRECT_DRAW_FRAMES = 3;
+const size_t INDIRECT_DRAW_MIN_COMMANDS = 1024;
+
+// Layout fixo lido pela GPU (glDrawElementsIndirect)
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Sequência de comandos com o mesmo estado, enviada em um glMultiDrawElementsIndirect
+struct IndirectDrawRun
+{
+    uint32_t material;
+    const GPUMesh *mesh;
+    size_t first;
+    size_t count;
+};
+
+struct IndirectDrawBuffer
+{
+    GLuint buffer = 0;
+    DrawElementsIndirectCommand *mapped = nullptr;  // mapeamento persistente (nulo sem glBufferStorage)
+    size_t capacity = 0;  // comandos por quadro
+    int frame = 0;        // parte do buffer usada no próximo quadro
+    GLsync fences[INDIRECT_DRAW_FRAMES] = {};
+    InstanceBuffer objects;
+    GLuint objectLocation = 0;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<IndirectDrawRun> runs;
+    std::vector<GLuint> attachedVAOs;  // VAOs já ligados aos objetos neste quadro
+};
+
+inline bool indirectDrawSupported()
+{
+    return glExtensions().multiDrawElementsIndirect != nullptr;
+}
+
+// Valor constante dos atributos do objeto (arrays desligados): caminho sem desenho indireto
+inline void setObjectAttributes(GLuint firstLocation, const InstanceData &object)
+{
+    for (GLuint column = 0; column < 4; column++)
+        glVertexAttrib4fv(firstLocation + column, glm::value_ptr(object.model[column]));
+    glVertexAttrib4fv(firstLocation + 4, glm::value_ptr(object.color));
+}
+
+inline void releaseIndirectCommands(IndirectDrawBuffer &indirect)
+{
+    for (GLsync &fence : indirect.fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    // Apagar o buffer também desfaz o mapeamento; a GPU termina de usar o antigo por conta própria
+    glDeleteBuffers(1, &indirect.buffer);
+    indirect.buffer = 0;
+    indirect.mapped = nullptr;
+}
+
+inline void allocateIndirectCommands(IndirectDrawBuffer &indirect, size_t capacity)
+{
+    releaseIndirectCommands(indirect);
+    indirect.capacity = capacity;
+    indirect.frame = 0;
+    GLsizeiptr bytes = (GLsizeiptr)(capacity * INDIRECT_DRAW_FRAMES * sizeof(DrawElementsIndirectCommand));
+    glGenBuffers(1, &indirect.buffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect.buffer);
+    GLBufferStorageFunction bufferStorage = glExtensions().bufferStorage;
+    if (bufferStorage)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(GL_DRAW_INDIRECT_BUFFER, bytes, nullptr, flags);
+        indirect.mapped = (DrawElementsIndirectCommand *)glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, bytes, flags);
+    }
+    else
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+inline void createIndirectDrawBuffer(IndirectDrawBuffer &indirect, GLuint objectLocation)
+{
+    indirect.objectLocation = objectLocation;
+    glGenBuffers(1, &indirect.objects.buffer);
+    allocateIndirectCommands(indirect, INDIRECT_DRAW_MIN_COMMANDS);
+}
+
+// Copia indirect.commands para a parte do quadro e devolve seu deslocamento em bytes
+inline size_t writeIndirectCommands(IndirectDrawBuffer &indirect)
+{
+    size_t count = indirect.commands.size();
+    if (count > indirect.capacity)
+        allocateIndirectCommands(indirect, std::max(count, indirect.capacity * 2));
+
+    size_t bytes = count * sizeof(DrawElementsIndirectCommand);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect.buffer);
+    if (!indirect.mapped)
+    {
+        GLsizeiptr total = (GLsizeiptr)(indirect.capacity * INDIRECT_DRAW_FRAMES * sizeof(DrawElementsIndirectCommand));
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, total, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, (GLsizeiptr)bytes, indirect.commands.data());
+        return 0;
+    }
+
+    // A parte foi usada há INDIRECT_DRAW_FRAMES quadros; normalmente a fence já sinalizou
+    GLsync &fence = indirect.fences[indirect.frame];
+    if (fence)
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    size_t first = (size_t)indirect.frame * indirect.capacity;
+    memcpy(indirect.mapped + first, indirect.commands.data(), bytes);
+    return first * sizeof(DrawElementsIndirectCommand);
+}
+
+inline void attachObjectAttributes(IndirectDrawBuffer &indirect, GLuint vao)
+{
+    if (std::find(indirect.attachedVAOs.begin(), indirect.attachedVAOs.end(), vao) != indirect.attachedVAOs.end())
+        return;
+    attachInstanceBuffer(indirect.objects, vao, indirect.objectLocation);
+    indirect.attachedVAOs.push_back(vao);
+}
+
+// objects[i] são os dados do objeto i da fila (DrawItem::object)
+template <typename BindMaterial>
+void flushDrawQueueIndirect(DrawQueue &queue, const MaterialLibrary &library, IndirectDrawBuffer &indirect,
+                            const std::vector<InstanceData> &objects, BindMaterial bindMaterial)
+{
+    sortDrawQueue(queue);
+    uploadInstances(indirect.objects, objects);
+
+    indirect.commands.clear();
+    indirect.runs.clear();
+    for (const DrawItem &item : queue.items)
+    {
+        if (item.mesh->EBO == 0)
+            continue;
+        size_t indexSize = item.mesh->indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        bool sameRun = !indirect.runs.empty() && indirect.runs.back().material == item.material &&
+                       indirect.runs.back().mesh->VAO == item.mesh->VAO &&
+                       indirect.runs.back().mesh->indexType == item.mesh->indexType;
+        if (!sameRun)
+            indirect.runs.push_back({item.material, item.mesh, indirect.commands.size(), 0});
+        indirect.runs.back().count++;
+        indirect.commands.push_back({(GLuint)item.count, 1, (GLuint)((uintptr_t)item.offset / indexSize), 0,
+                                     item.object});
+    }
+
+    queue.materialBinds = 0;
+    queue.drawCalls = 0;
+    if (indirect.commands.empty())
+        return;
+
+    size_t base = writeIndirectCommands(indirect);
+    indirect.attachedVAOs.clear();
+    const uint32_t none = ~0u;
+    uint32_t material = none;
+    GLuint vao = 0;
+    for (const IndirectDrawRun &run : indirect.runs)
+    {
+        if (run.material != material)
+        {
+            material = run.material;
+            bindMaterial(library.materials[material < library.materials.size() ? material : 0]);
+            queue.materialBinds++;
+        }
+        if (run.mesh->VAO != vao)
+        {
+            vao = run.mesh->VAO;
+            attachObjectAttributes(indirect, vao);
+            glBindVertexArray(vao);
+        }
+        glExtensions().multiDrawElementsIndirect(
+            GL_TRIANGLES, run.mesh->indexType,
+            (const void *)(uintptr_t)(base + run.first * sizeof(DrawElementsIndirectCommand)), (GLsizei)run.count, 0);
+        queue.drawCalls++;
+    }
+    glBindVertexArray(0);
+
+    if (indirect.mapped)
+    {
+        indirect.fences[indirect.frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        indirect.frame = (indirect.frame + 1) % INDIRECT_DRAW_FRAMES;
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+inline void destroyIndirectDrawBuffer(IndirectDrawBuffer &indirect)
+{
+    releaseIndirectCommands(indirect);
+    destroyInstanceBuffer(indirect.objects);
+    indirect = IndirectDrawBuffer();
+}
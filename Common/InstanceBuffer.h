@@ -0,0 +1,115 @@
+/*
+ *  InstanceBuffer.h
+ *
+ *  Desenho instanciado de objetos repetidos. Em vez de um glUniformMatrix4fv e
+ *  um glDrawArrays por objeto, a matriz model e a cor de cada objeto vão para
+ *  um VBO de instâncias (glVertexAttribDivisor 1) e o conjunto inteiro sai em
+ *  um único glDrawArraysInstanced/glDrawElementsInstanced. O custo de CPU por
+ *  objeto passa a ser só escrever 80 bytes em um vetor, o que permite centenas
+ *  de milhares de cópias por quadro.
+ *
+ *  A matriz ocupa quatro localizações de atributo seguidas (uma coluna vec4 em
+ *  cada) e a cor a quinta, a partir da localização passada a
+ *  createInstanceBuffer. O vertex shader declara:
+ *
+ *  layout (location = N) in mat4 instanceModel;      // N .. N+3
+ *  layout (location = N + 4) in vec4 instanceColor;  // opcional
+ *
+ *  uploadInstances reenvia tudo a cada quadro; o glBufferData com nullptr antes
+ *  do glBufferSubData descarta o conteúdo anterior ("orphaning"), então o
+ *  driver não espera a GPU terminar de ler o quadro passado.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  InstanceBuffer instances;
+ *  createInstanceBuffer(instances, VAO, 2);  // localizações 2..6
+ *  vector<InstanceData> data;
+ *  ...
+ *  data.push_back({model, vec4(color, 1.0f)});
+ *  uploadInstances(instances, data);
+ *  glBindVertexArray(VAO);
+ *  drawInstancedArrays(instances, GL_TRIANGLES, 0, 36);
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+struct InstanceData
+{
+    glm::mat4 model;
+    glm::vec4 color;
+};
+
+struct InstanceBuffer
+{
+    GLuint buffer = 0;
+    size_t capacity = 0;  // instâncias que cabem no buffer alocado
+    size_t count = 0;     // instâncias enviadas no último uploadInstances
+};
+
+// Liga os atributos de instância de um VAO (que já tem os atributos por vértice) ao buffer
+inline void attachInstanceBuffer(const InstanceBuffer &instances, GLuint vao, GLuint firstLocation)
+{
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instances.buffer);
+    for (GLuint column = 0; column < 4; column++)
+    {
+        GLuint location = firstLocation + column;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                              (void *)(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    glVertexAttribPointer(firstLocation + 4, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                          (void *)offsetof(InstanceData, color));
+    glEnableVertexAttribArray(firstLocation + 4);
+    glVertexAttribDivisor(firstLocation + 4, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+inline void createInstanceBuffer(InstanceBuffer &instances, GLuint vao, GLuint firstLocation)
+{
+    glGenBuffers(1, &instances.buffer);
+    attachInstanceBuffer(instances, vao, firstLocation);
+}
+
+inline void uploadInstances(InstanceBuffer &instances, const std::vector<InstanceData> &data)
+{
+    // Cresce dobrando para não realocar a cada objeto novo
+    if (data.size() > instances.capacity)
+        instances.capacity = std::max(data.size(), instances.capacity * 2);
+    glBindBuffer(GL_ARRAY_BUFFER, instances.buffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(instances.capacity * sizeof(InstanceData)), nullptr, GL_STREAM_DRAW);
+    if (!data.empty())
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(data.size() * sizeof(InstanceData)), data.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instances.count = data.size();
+}
+
+// Com o VAO de createInstanceBuffer ligado
+inline void drawInstancedArrays(const InstanceBuffer &instances, GLenum mode, GLint first, GLsizei vertexCount)
+{
+    if (instances.count > 0)
+        glDrawArraysInstanced(mode, first, vertexCount, (GLsizei)instances.count);
+}
+
+inline void drawInstancedElements(const InstanceBuffer &instances, GLenum mode, GLsizei indexCount, GLenum type,
+                                  const void *offset)
+{
+    if (instances.count > 0)
+        glDrawElementsInstanced(mode, indexCount, type, offset, (GLsizei)instances.count);
+}
+
+inline void destroyInstanceBuffer(InstanceBuffer &instances)
+{
+    glDeleteBuffers(1, &instances.buffer);
+    instances = InstanceBuffer();
+}
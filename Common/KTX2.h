@@ -0,0 +1,343 @@
+/*
+ *  KTX2.h
+ *
+ *  Leitura e gravação de texturas comprimidas em blocos (TextureCompression.h)
+ *  no contêiner KTX 2.0 (Khronos), o mesmo aceito por ferramentas como toktx e
+ *  PVRTexTool: cabeçalho, índice dos níveis, descritor de formato (DFD) e os
+ *  níveis de mipmap do menor para o maior. Só texturas 2D simples, sem
+ *  supercompressão, nos formatos BC1, BC3 e BC7 (UNORM ou sRGB).
+ *
+ *  loadCompressedTextureStaging lê um .ktx2 direto ou, para uma imagem comum,
+ *  usa o cache compartilhado (AssetCache.h): na primeira carga a imagem é
+ *  decodificada, ganha a cadeia de mipmaps comprimida (BC3 se tiver alfa, BC1 se
+ *  não) e é gravada como entrada .ktx2; nas seguintes a entrada é mapeada em
+ *  memória e os blocos vão direto para glCompressedTexImage2D.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  CompressedTextureStaging texture;
+ *  if (loadCompressedTextureStaging("../assets/Modelos3D/SuzanneUV.png", loadImage, stbi_image_free, texture))
+ *      for (const CompressedLevelView &level : texture.levels)
+ *          ...;  // glCompressedTexImage2D(GL_TEXTURE_2D, nivel, ...)
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "AssetCache.h"
+#include "ImageCache.h"
+#include "MappedFile.h"
+#include "TextureCompression.h"
+
+const unsigned char KTX2_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+const uint32_t KTX2_CACHE_VERSION = 2;
+
+// Valores de VkFormat usados no campo vkFormat
+const uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+const uint32_t VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132;
+const uint32_t VK_FORMAT_BC1_RGBA_UNORM_BLOCK = 133;
+const uint32_t VK_FORMAT_BC1_RGBA_SRGB_BLOCK = 134;
+const uint32_t VK_FORMAT_BC3_UNORM_BLOCK = 137;
+const uint32_t VK_FORMAT_BC3_SRGB_BLOCK = 138;
+const uint32_t VK_FORMAT_BC7_UNORM_BLOCK = 145;
+const uint32_t VK_FORMAT_BC7_SRGB_BLOCK = 146;
+
+struct KTX2Header
+{
+    unsigned char identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+
+struct KTX2LevelIndex
+{
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+static_assert(sizeof(KTX2Header) == 80, "KTX2Header deve ter o tamanho do formato");
+static_assert(std::is_trivially_copyable<KTX2Header>::value, "KTX2Header deve ser copiavel byte a byte");
+
+// Um nível dentro de CompressedTextureStaging (aponta para o arquivo mapeado ou para owned)
+struct CompressedLevelView
+{
+    int width = 0;
+    int height = 0;
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+};
+
+struct CompressedTextureStaging
+{
+    MappedFile file;
+    std::vector<unsigned char> owned;
+    BlockFormat format = BLOCK_BC1;
+    bool srgb = false;
+    std::vector<CompressedLevelView> levels;  // levels[0] é o maior
+};
+
+inline bool isKTX2Path(const std::string &path)
+{
+    std::string extension = std::filesystem::path(path).extension().string();
+    return extension == ".ktx2" || extension == ".KTX2";
+}
+
+inline uint32_t ktx2VkFormat(BlockFormat format, bool srgb)
+{
+    if (format == BLOCK_BC1)
+        return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+    if (format == BLOCK_BC3)
+        return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+    return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+}
+
+inline bool ktx2BlockFormat(uint32_t vkFormat, BlockFormat &format, bool &srgb)
+{
+    switch (vkFormat)
+    {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        format = BLOCK_BC1;
+        break;
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+        format = BLOCK_BC3;
+        break;
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        format = BLOCK_BC7;
+        break;
+    default:
+        return false;
+    }
+    srgb = vkFormat == VK_FORMAT_BC1_RGB_SRGB_BLOCK || vkFormat == VK_FORMAT_BC1_RGBA_SRGB_BLOCK ||
+           vkFormat == VK_FORMAT_BC3_SRGB_BLOCK || vkFormat == VK_FORMAT_BC7_SRGB_BLOCK;
+    return true;
+}
+
+inline void appendUint32(std::vector<unsigned char> &out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        out.push_back((unsigned char)(value >> (i * 8)));
+}
+
+// Descritor de formato básico (Khronos Data Format, versão 2) de um formato em blocos 4x4
+inline std::vector<unsigned char> ktx2FormatDescriptor(BlockFormat format, bool srgb)
+{
+    // Modelos de cor do DFD: BC1A = 128, BC3 = 130, BC7 = 134
+    const unsigned char colorModels[3] = {128, 130, 134};
+    uint32_t samples = format == BLOCK_BC3 ? 2 : 1;
+    uint32_t blockSize = 24 + 16 * samples;
+    std::vector<unsigned char> dfd;
+    appendUint32(dfd, 4 + blockSize);                   // dfdTotalSize
+    appendUint32(dfd, 0);                               // vendorId = 0 (Khronos), descriptorType = 0
+    appendUint32(dfd, 2 | (blockSize << 16));           // versionNumber = 2, descriptorBlockSize
+    dfd.push_back(colorModels[format]);
+    dfd.push_back(1);                                   // primárias BT.709
+    dfd.push_back(srgb ? 2 : 1);                        // transferência sRGB ou linear
+    dfd.push_back(0);                                   // alfa não pré-multiplicado
+    const unsigned char blockDimensions[4] = {3, 3, 0, 0};  // 4x4x1x1, cada valor menos 1
+    dfd.insert(dfd.end(), blockDimensions, blockDimensions + 4);
+    unsigned char bytesPlane[8] = {(unsigned char)blockBytes(format)};
+    dfd.insert(dfd.end(), bytesPlane, bytesPlane + 8);
+
+    auto appendSample = [&](uint32_t bitOffset, uint32_t bitLength, uint32_t channel)
+    {
+        appendUint32(dfd, bitOffset | ((bitLength - 1) << 16) | (channel << 24));
+        appendUint32(dfd, 0);                           // samplePosition
+        appendUint32(dfd, 0);                           // sampleLower
+        appendUint32(dfd, 0xFFFFFFFF);                  // sampleUpper
+    };
+    if (format == BLOCK_BC3)
+    {
+        appendSample(0, 64, 15);                        // alfa
+        appendSample(64, 64, 0);                        // cor
+    }
+    else
+        appendSample(0, (uint32_t)blockBytes(format) * 8, 0);
+    return dfd;
+}
+
+// Arquivo .ktx2 completo em memória; levels[0] é o maior nível
+inline std::vector<unsigned char> buildKTX2(BlockFormat format, bool srgb, const std::vector<CompressedLevel> &levels)
+{
+    std::vector<unsigned char> dfd = ktx2FormatDescriptor(format, srgb);
+    size_t indexEnd = sizeof(KTX2Header) + levels.size() * sizeof(KTX2LevelIndex);
+
+    KTX2Header header = {};
+    memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+    header.vkFormat = ktx2VkFormat(format, srgb);
+    header.typeSize = 1;
+    header.pixelWidth = (uint32_t)levels[0].width;
+    header.pixelHeight = (uint32_t)levels[0].height;
+    header.faceCount = 1;
+    header.levelCount = (uint32_t)levels.size();
+    header.dfdByteOffset = (uint32_t)indexEnd;
+    header.dfdByteLength = (uint32_t)dfd.size();
+
+    // Níveis do menor para o maior, cada um alinhado ao tamanho do bloco (mipPadding)
+    size_t alignment = blockBytes(format);
+    std::vector<KTX2LevelIndex> index(levels.size());
+    size_t offset = indexEnd + dfd.size();
+    for (size_t i = levels.size(); i-- > 0;)
+    {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        index[i] = {offset, levels[i].data.size(), levels[i].data.size()};
+        offset += levels[i].data.size();
+    }
+
+    std::vector<unsigned char> file(offset, 0);
+    memcpy(file.data(), &header, sizeof(header));
+    memcpy(file.data() + sizeof(header), index.data(), index.size() * sizeof(KTX2LevelIndex));
+    memcpy(file.data() + indexEnd, dfd.data(), dfd.size());
+    for (size_t i = 0; i < levels.size(); i++)
+        memcpy(file.data() + index[i].byteOffset, levels[i].data.data(), levels[i].data.size());
+    return file;
+}
+
+// Preenche texture.levels com ponteiros para dentro de data (que precisa continuar vivo)
+inline bool parseKTX2(const unsigned char *data, size_t size, CompressedTextureStaging &texture)
+{
+    if (size < sizeof(KTX2Header))
+        return false;
+    KTX2Header header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0 ||
+        !ktx2BlockFormat(header.vkFormat, texture.format, texture.srgb) || header.supercompressionScheme != 0 ||
+        header.pixelWidth == 0 || header.pixelHeight > 0x10000 || header.pixelWidth > 0x10000 ||
+        header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 || header.levelCount > 32)
+        return false;
+    uint32_t levelCount = std::max(1u, header.levelCount);  // 0: o leitor deveria gerar os mipmaps
+    if (size < sizeof(KTX2Header) + levelCount * sizeof(KTX2LevelIndex))
+        return false;
+
+    texture.levels.clear();
+    int width = (int)header.pixelWidth, height = (int)std::max(1u, header.pixelHeight);
+    for (uint32_t i = 0; i < levelCount; i++)
+    {
+        KTX2LevelIndex index;
+        memcpy(&index, data + sizeof(KTX2Header) + i * sizeof(KTX2LevelIndex), sizeof(index));
+        CompressedLevelView level;
+        level.width = std::max(1, width >> i);
+        level.height = std::max(1, height >> i);
+        level.size = compressedLevelBytes(texture.format, level.width, level.height);
+        if (index.byteLength < level.size || index.byteOffset > size || size - index.byteOffset < level.size)
+            return false;
+        level.data = data + index.byteOffset;
+        texture.levels.push_back(level);
+    }
+    return true;
+}
+
+inline bool loadKTX2File(const std::string &path, CompressedTextureStaging &texture)
+{
+    if (!texture.file.open(path) || !parseKTX2((const unsigned char *)texture.file.data, texture.file.size, texture))
+    {
+        texture.file.close();
+        std::cerr << "Erro ao tentar ler a textura KTX2 " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+inline std::string compressedTextureCachePath(uint64_t sourceHash, const std::string &settings,
+                                              const MipSettings &mips)
+{
+    return assetCachePath(assetCacheKey(sourceHash, "ktx2 " + std::to_string(KTX2_CACHE_VERSION) + " " + settings +
+                                                        " " + mipSettingsKey(mips)),
+                          ".ktx2");
+}
+
+inline bool writeCompressedTextureCache(const std::string &cachePath, const std::vector<unsigned char> &file)
+{
+    std::string tempPath = assetCacheTempPath(cachePath);
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+        out.write((const char *)file.data(), (std::streamsize)file.size());
+        if (!out)
+        {
+            out.close();
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+    return commitAssetCacheFile(tempPath, cachePath);
+}
+
+// Mapeia a entrada .ktx2 cachePath em texture se ela existe e é válida
+inline bool openCompressedTextureCache(const std::string &cachePath, CompressedTextureStaging &texture)
+{
+    if (texture.file.open(cachePath) &&
+        parseKTX2((const unsigned char *)texture.file.data, texture.file.size, texture))
+    {
+        touchAssetCacheEntry(cachePath);
+        return true;
+    }
+    texture.file.close();
+    return false;
+}
+
+// Parte do carregamento que não usa OpenGL (pode rodar nas threads de AssetLoader.h).
+// Um .ktx2 é lido como está; outra imagem vem da entrada comprimida do cache ou é
+// decodificada, comprimida e gravada nele. settings e mips como em loadImageStaging
+inline bool loadCompressedTextureStaging(const std::string &path, ImageLoadFunction decode,
+                                         ImageFreeFunction freeImage, CompressedTextureStaging &texture,
+                                         const std::string &settings = "", const MipSettings &mips = MipSettings())
+{
+    if (isKTX2Path(path))
+        return loadKTX2File(path, texture);
+
+    AssetSource source;
+    if (!statAssetSource(path, source))
+    {
+        std::cerr << "Erro ao tentar ler o arquivo " << path << std::endl;
+        return false;
+    }
+
+    std::string cachePath = compressedTextureCachePath(source.hash, settings, mips);
+    if (openCompressedTextureCache(cachePath, texture))
+        return true;
+
+    ImageStaging image;
+    if (!decodeImageStaging(path, decode, freeImage, image))
+        return false;
+    std::vector<unsigned char> rgba = expandToRGBA(image.pixels, image.width, image.height, image.channels);
+    texture.format = imageHasAlpha(rgba) ? BLOCK_BC3 : BLOCK_BC1;
+    texture.srgb = false;
+    texture.owned = buildKTX2(texture.format, texture.srgb,
+                              compressMipChain(rgba, image.width, image.height, texture.format, mips));
+    parseKTX2(texture.owned.data(), texture.owned.size(), texture);
+
+    if (!writeCompressedTextureCache(cachePath, texture.owned))
+        std::cerr << "Nao foi possivel gravar o cache de textura " << cachePath << std::endl;
+    return true;
+}
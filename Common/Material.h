@@ -0,0 +1,233 @@
+/*
+ *  Material.h
+ *
+ *  Materiais dos arquivos Wavefront .MTL (registros newmtl, Ka, Kd, Ks, Ns, d/Tr
+ *  e map_Kd) e a tabela de materiais compartilhada pelos objetos da cena.
+ *
+ *  Os .MTL são lidos a partir dos registros mtllib do .OBJ, relativos à pasta do
+ *  .OBJ, e cada arquivo é lido uma única vez por MaterialLibrary. Cada malha
+ *  guarda em materialIds o índice na tabela de cada um dos seus materiais; nomes
+ *  não encontrados (e faces sem usemtl) usam o material padrão, materials[0].
+ *
+ *  Forma de uso
+ *  -----------------
+ *  MaterialLibrary materials;
+ *  GPUMesh mesh = loadMeshCached("../assets/Modelos3D/Suzanne.obj");
+ *  registerMeshMaterials(materials, mesh, "../assets/Modelos3D/Suzanne.obj");
+ *  loadMaterialTextures(materials, loadTexture);  // GLuint loadTexture(string)
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "MappedFile.h"
+#include "Mesh.h"
+#include "ObjLoader.h"
+
+// Valores usados quando o .MTL não informa o registro (o Blender omite Kd, por exemplo)
+struct Material
+{
+    std::string name;
+    glm::vec3 ambient = glm::vec3(1.0f);   // Ka, multiplicado pela luz ambiente da cena
+    glm::vec3 diffuse = glm::vec3(0.7f);   // Kd
+    glm::vec3 specular = glm::vec3(0.5f);  // Ks
+    float shininess = 32.0f;               // Ns
+    float opacity = 1.0f;                  // d (ou 1 - Tr)
+    std::string diffuseMap;                // map_Kd, caminho relativo ao executável
+    GLuint diffuseTexture = 0;
+    int diffuseLayer = -1;                 // camada quando diffuseTexture é um GL_TEXTURE_2D_ARRAY (TextureArray.h)
+};
+
+struct MaterialLibrary
+{
+    std::vector<Material> materials = {Material()};  // materials[0]: material padrão
+    std::vector<std::string> files;                  // .MTL já lidos
+};
+
+// Índice do material pelo nome; 0 (padrão) quando não existe
+inline uint32_t findMaterial(const MaterialLibrary &library, const std::string &name)
+{
+    for (size_t i = 1; i < library.materials.size(); i++)
+        if (library.materials[i].name == name)
+            return (uint32_t)i;
+    return 0;
+}
+
+inline const char *mtlParseColor(const char *p, const char *end, glm::vec3 &color)
+{
+    p = objParseFloat(p, end, color.r);
+    p = objParseFloat(p, end, color.g);
+    p = objParseFloat(p, end, color.b);
+    return p;
+}
+
+// Interpreta um .MTL já mapeado. Materiais com nome repetido substituem os anteriores;
+// caminhos de textura são resolvidos em relação a directory
+inline void parseMTL(const char *p, const char *end, const std::string &directory, MaterialLibrary &library)
+{
+    Material *material = nullptr;
+    while (p < end)
+    {
+        p = objSkipSpaces(p, end);
+        if (p + 1 >= end)
+            break;
+
+        if (objIsKeyword(p, end, "newmtl", 6))
+        {
+            std::string name;
+            p = objParseName(p + 7, end, name);
+            uint32_t index = findMaterial(library, name);
+            if (index == 0)
+            {
+                library.materials.push_back(Material());
+                index = (uint32_t)library.materials.size() - 1;
+            }
+            material = &library.materials[index];
+            *material = Material();
+            material->name = name;
+        }
+        else if (material && objIsKeyword(p, end, "Ka", 2))
+            p = mtlParseColor(p + 3, end, material->ambient);
+        else if (material && objIsKeyword(p, end, "Kd", 2))
+            p = mtlParseColor(p + 3, end, material->diffuse);
+        else if (material && objIsKeyword(p, end, "Ks", 2))
+            p = mtlParseColor(p + 3, end, material->specular);
+        else if (material && objIsKeyword(p, end, "Ns", 2))
+            p = objParseFloat(p + 3, end, material->shininess);
+        else if (material && objIsKeyword(p, end, "d", 1))
+            p = objParseFloat(p + 2, end, material->opacity);
+        else if (material && objIsKeyword(p, end, "Tr", 2))
+        {
+            float transparency = 0.0f;
+            p = objParseFloat(p + 3, end, transparency);
+            material->opacity = 1.0f - transparency;
+        }
+        else if (material && objIsKeyword(p, end, "map_Kd", 6))
+        {
+            // Opções (-s, -o, -bm ...) são ignoradas: o arquivo é o último item da linha
+            std::string file;
+            p = objParseName(p + 7, end, file);
+            if (!file.empty() && file[0] == '-')
+                file = file.substr(file.find_last_of(" \t") + 1);
+            material->diffuseMap = (std::filesystem::path(directory) / file).string();
+        }
+
+        p = objSkipLine(p, end);
+    }
+}
+
+inline bool loadMTL(const std::string &filePath, MaterialLibrary &library)
+{
+    MappedFile file;
+    if (!file.open(filePath))
+    {
+        std::cerr << "Erro ao tentar ler o arquivo " << filePath << std::endl;
+        return false;
+    }
+
+    size_t before = library.materials.size();
+    parseMTL(file.data, file.data + file.size, std::filesystem::path(filePath).parent_path().string(), library);
+    library.files.push_back(filePath);
+    std::cout << "MTL " << filePath << ": " << library.materials.size() - before << " materiais novos" << std::endl;
+    return true;
+}
+
+inline bool hasMaterialFile(const MaterialLibrary &library, const std::string &filePath)
+{
+    for (const std::string &file : library.files)
+        if (file == filePath)
+            return true;
+    return false;
+}
+
+// Lê os .MTL citados pela malha que ainda não estão na tabela
+inline void loadMeshMaterialFiles(MaterialLibrary &library, const GPUMesh &mesh, const std::string &objPath)
+{
+    std::filesystem::path directory = std::filesystem::path(objPath).parent_path();
+    for (const std::string &name : mesh.materialLibraries)
+    {
+        std::string filePath = (directory / name).string();
+        if (!hasMaterialFile(library, filePath))
+            loadMTL(filePath, library);
+    }
+}
+
+// Acrescenta os materiais lidos em outra tabela (por exemplo, em uma thread de carga).
+// Nada muda se todos os arquivos de other já tinham sido lidos
+inline void mergeMaterialLibrary(MaterialLibrary &library, const MaterialLibrary &other)
+{
+    bool changed = false;
+    for (const std::string &file : other.files)
+        if (!hasMaterialFile(library, file))
+        {
+            library.files.push_back(file);
+            changed = true;
+        }
+    if (!changed)
+        return;
+
+    for (size_t i = 1; i < other.materials.size(); i++)
+    {
+        const Material &material = other.materials[i];
+        uint32_t index = findMaterial(library, material.name);
+        if (index == 0)
+        {
+            library.materials.push_back(material);
+            continue;
+        }
+        bool sameMap = library.materials[index].diffuseMap == material.diffuseMap;
+        GLuint texture = sameMap ? library.materials[index].diffuseTexture : 0;
+        int layer = sameMap ? library.materials[index].diffuseLayer : -1;
+        library.materials[index] = material;
+        library.materials[index].diffuseTexture = texture;
+        library.materials[index].diffuseLayer = layer;
+    }
+}
+
+// Preenche mesh.materialIds com os índices dos materiais da malha na tabela
+inline void assignMeshMaterials(const MaterialLibrary &library, GPUMesh &mesh)
+{
+    mesh.materialIds.clear();
+    for (const std::string &name : mesh.materialNames)
+    {
+        uint32_t index = name.empty() ? 0 : findMaterial(library, name);
+        if (index == 0 && !name.empty())
+            std::cerr << "Material " << name << " nao encontrado, usando o material padrao" << std::endl;
+        mesh.materialIds.push_back(index);
+    }
+}
+
+// Lê os .MTL citados pela malha (uma vez por arquivo) e preenche mesh.materialIds
+inline void registerMeshMaterials(MaterialLibrary &library, GPUMesh &mesh, const std::string &objPath)
+{
+    loadMeshMaterialFiles(library, mesh, objPath);
+    assignMeshMaterials(library, mesh);
+}
+
+// Carrega as texturas map_Kd com loader(caminho); materiais com o mesmo arquivo
+// compartilham a textura
+template <typename Loader>
+void loadMaterialTextures(MaterialLibrary &library, Loader loader)
+{
+    for (size_t i = 0; i < library.materials.size(); i++)
+    {
+        Material &material = library.materials[i];
+        if (material.diffuseMap.empty() || material.diffuseTexture != 0)
+            continue;
+        for (size_t j = 0; j < i && material.diffuseTexture == 0; j++)
+            if (library.materials[j].diffuseMap == material.diffuseMap)
+                material.diffuseTexture = library.materials[j].diffuseTexture;
+        if (material.diffuseTexture == 0)
+            material.diffuseTexture = loader(material.diffuseMap);
+    }
+}
@@ -0,0 +1,342 @@
+/*
+ *  Mesh.h
+ *
+ *  Malha indexada gerada a partir de um ObjData e seu envio para a GPU.
+ *
+ *  Cada combinação única de índices (posição, coordenada de textura, normal) dos
+ *  cantos das faces vira um único vértice; as faces passam a referenciar esses
+ *  vértices por um buffer de índices (EBO). Quando a malha tem até 65535 vértices,
+ *  os índices são enviados com 16 bits.
+ *
+ *  Os triângulos são agrupados por material (registros usemtl): cada material
+ *  ocupa uma faixa contígua do buffer de índices (MeshSubset), o que permite
+ *  desenhar a malha com um glDrawElements por material (ver DrawQueue.h).
+ *
+ *  Forma de uso
+ *  -----------------
+ *  ObjData obj;
+ *  loadOBJ("../assets/Modelos3D/Suzanne.obj", obj);
+ *  GPUMesh mesh = uploadMesh(buildIndexedMesh(obj));
+ *  ...
+ *  drawMesh(mesh);  // glDrawElements
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "ObjLoader.h"
+
+struct Vertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+};
+
+// Grupo de triângulos contíguos no buffer de índices (ver Meshlet.h)
+struct Meshlet
+{
+    uint32_t indexOffset;  // primeiro índice do grupo
+    uint32_t indexCount;
+    glm::vec3 center;      // esfera envolvente, no espaço do objeto
+    float radius;
+    glm::vec3 coneAxis;    // cone das normais: eixo e cutoff (1 = nunca descartado)
+    float coneCutoff;
+    uint32_t subset;       // MeshSubset (material) ao qual o grupo pertence
+};
+
+// Nível de detalhe: faixa do buffer de índices e erro relativo à maior dimensão (ver MeshLOD.h)
+struct MeshLOD
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    float error;
+};
+
+// Faixa do buffer de índices com os triângulos de um material em um nível de detalhe.
+// material indexa materialNames da malha
+struct MeshSubset
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    uint32_t material;
+    uint32_t lod;
+};
+
+struct Mesh
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshLOD> lods;  // vazio: só existe a malha completa
+    std::vector<MeshSubset> subsets;  // ordenados por nível e material
+    std::vector<std::string> materialLibraries;
+    std::vector<std::string> materialNames;  // "" = faces sem usemtl
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+};
+
+// Descrição de um atributo de vértice (argumentos de glVertexAttribPointer)
+struct VertexAttribute
+{
+    uint32_t location;
+    uint32_t components;
+    uint32_t type;
+    uint32_t normalized;
+    uint32_t offset;
+};
+
+// Layout dos atributos usado em M4/M5: 0 = posição, 1 e 2 = normal, 3 = coordenada de textura
+const VertexAttribute VERTEX_LAYOUT[] = {
+    {0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, position)},
+    {1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, normal)},
+    {2, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, normal)},
+    {3, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, texCoord)},
+};
+const uint32_t VERTEX_LAYOUT_SIZE = sizeof(VERTEX_LAYOUT) / sizeof(VERTEX_LAYOUT[0]);
+
+struct GPUMesh
+{
+    GLuint VAO = 0;
+    GLuint VBO = 0;
+    GLuint EBO = 0;
+    GLsizei indexCount = 0;  // sem EBO: número de vértices
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    // Posição no espaço do objeto = positionOffset + atributo * positionScale
+    // (diferente da identidade apenas para vértices quantizados, ver PackedVertex.h)
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    std::vector<Meshlet> meshlets;  // vazio: a malha é sempre desenhada inteira
+    std::vector<MeshLOD> lods;      // lods[0] é a malha completa; indexCount = lods[0].indexCount
+    std::vector<MeshSubset> subsets;  // vazio: um único material cobre a malha
+    std::vector<std::string> materialLibraries;
+    std::vector<std::string> materialNames;
+    std::vector<uint32_t> materialIds;  // índice na MaterialLibrary de cada nome (ver Material.h)
+};
+
+inline uint32_t hashObjCorner(const ObjCorner &corner)
+{
+    uint32_t h = (uint32_t)corner.v * 0x9E3779B1u;
+    h ^= (uint32_t)corner.vt * 0x85EBCA77u + (h << 6) + (h >> 2);
+    h ^= (uint32_t)corner.vn * 0xC2B2AE3Du + (h << 6) + (h >> 2);
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h;
+}
+
+inline Vertex makeVertex(const ObjData &obj, const ObjCorner &corner)
+{
+    Vertex vertex{};
+    if (corner.v >= 0 && corner.v < (int)obj.positions.size())
+        vertex.position = obj.positions[corner.v];
+    if (corner.vt >= 0 && corner.vt < (int)obj.texCoords.size())
+        vertex.texCoord = obj.texCoords[corner.vt];
+    if (corner.vn >= 0 && corner.vn < (int)obj.normals.size())
+        vertex.normal = obj.normals[corner.vn];
+    return vertex;
+}
+
+inline void computeBounds(Mesh &mesh)
+{
+    if (mesh.vertices.empty())
+    {
+        mesh.boundsMin = mesh.boundsMax = glm::vec3(0.0f);
+        return;
+    }
+    mesh.boundsMin = mesh.boundsMax = mesh.vertices[0].position;
+    for (const Vertex &vertex : mesh.vertices)
+    {
+        mesh.boundsMin = glm::min(mesh.boundsMin, vertex.position);
+        mesh.boundsMax = glm::max(mesh.boundsMax, vertex.position);
+    }
+}
+
+// Gera a malha indexada: tabela hash (endereçamento aberto) das triplas v/vt/vn já vistas.
+// Os triângulos de cada material são juntados em uma faixa própria, na ordem de materialNames
+inline Mesh buildIndexedMesh(const ObjData &obj)
+{
+    Mesh mesh;
+    mesh.materialLibraries = obj.materialLibraries;
+
+    size_t tableSize = 16;
+    while (tableSize < obj.corners.size() * 2)
+        tableSize <<= 1;
+    std::vector<uint32_t> table(tableSize, 0);  // índice do vértice + 1; 0 = vazio
+    std::vector<ObjCorner> uniqueCorners;
+
+    std::vector<std::vector<uint32_t>> materialIndices(obj.materialNames.size() + 1);
+    auto addCorner = [&](const ObjCorner &corner, std::vector<uint32_t> &indices) {
+        size_t slot = hashObjCorner(corner) & (tableSize - 1);
+        while (table[slot] != 0)
+        {
+            const ObjCorner &other = uniqueCorners[table[slot] - 1];
+            if (other.v == corner.v && other.vt == corner.vt && other.vn == corner.vn)
+            {
+                indices.push_back(table[slot] - 1);
+                return;
+            }
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        uint32_t index = (uint32_t)uniqueCorners.size();
+        table[slot] = index + 1;
+        uniqueCorners.push_back(corner);
+        mesh.vertices.push_back(makeVertex(obj, corner));
+        indices.push_back(index);
+    };
+
+    forEachMaterialTriangle(obj, [&](uint32_t material, const ObjCorner &a, const ObjCorner &b, const ObjCorner &c) {
+        addCorner(a, materialIndices[material]);
+        addCorner(b, materialIndices[material]);
+        addCorner(c, materialIndices[material]);
+    });
+
+    mesh.indices.reserve(obj.corners.size());
+    for (size_t material = 0; material < materialIndices.size(); material++)
+    {
+        const std::vector<uint32_t> &indices = materialIndices[material];
+        if (indices.empty())
+            continue;
+        mesh.subsets.push_back({(uint32_t)mesh.indices.size(), (uint32_t)indices.size(),
+                                (uint32_t)mesh.materialNames.size(), 0});
+        mesh.materialNames.push_back(material < obj.materialNames.size() ? obj.materialNames[material] : "");
+        mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+    }
+
+    computeBounds(mesh);
+    return mesh;
+}
+
+inline void setupVertexAttributes(const VertexAttribute *layout, uint32_t attributeCount, GLsizei stride)
+{
+    for (uint32_t i = 0; i < attributeCount; i++)
+    {
+        const VertexAttribute &attribute = layout[i];
+        glVertexAttribPointer(attribute.location, attribute.components, attribute.type,
+                              (GLboolean)attribute.normalized, stride, (void *)(uintptr_t)attribute.offset);
+        glEnableVertexAttribArray(attribute.location);
+    }
+}
+
+// Cria VAO, VBO e EBO a partir de blocos de vértices e índices já no formato final.
+// Sem índices (indexCount = 0) não há EBO e a malha é desenhada com glDrawArrays
+inline GPUMesh uploadMeshBuffers(const void *vertexData, size_t vertexBytes, const VertexAttribute *layout,
+                                 uint32_t attributeCount, GLsizei stride, const void *indexData,
+                                 size_t indexCount, GLenum indexType)
+{
+    GPUMesh gpu;
+    gpu.indexCount = (GLsizei)indexCount;
+    gpu.indexType = indexType;
+    size_t indexBytes = indexCount * (indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+
+    glGenVertexArrays(1, &gpu.VAO);
+    glGenBuffers(1, &gpu.VBO);
+
+    glBindVertexArray(gpu.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, gpu.VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexData, GL_STATIC_DRAW);
+    if (indexCount > 0)
+    {
+        glGenBuffers(1, &gpu.EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexData, GL_STATIC_DRAW);
+    }
+    else
+        gpu.indexCount = (GLsizei)(vertexBytes / stride);  // sem índices: triângulos em sequência
+
+    setupVertexAttributes(layout, attributeCount, stride);
+    glBindVertexArray(0);
+    return gpu;
+}
+
+inline bool fitsShortIndices(const Mesh &mesh)
+{
+    return mesh.vertices.size() <= 0xFFFF;
+}
+
+inline void printIndexedMesh(const Mesh &mesh, size_t vertexBytes, size_t indexBytes)
+{
+    bool shortIndices = indexBytes == mesh.indices.size() * sizeof(uint16_t);
+    std::cout << "Malha indexada: " << mesh.vertices.size() << " vertices unicos para "
+              << mesh.indices.size() << " indices (" << (shortIndices ? 16 : 32)
+              << " bits), " << (vertexBytes + indexBytes) / 1024 << " KB em vez de "
+              << mesh.indices.size() * sizeof(Vertex) / 1024 << " KB sem indices" << std::endl;
+}
+
+// Limites, meshlets, LODs e materiais da malha (tudo menos os buffers)
+inline void copyMeshMetadata(const Mesh &mesh, GPUMesh &gpu)
+{
+    gpu.boundsMin = mesh.boundsMin;
+    gpu.boundsMax = mesh.boundsMax;
+    gpu.meshlets = mesh.meshlets;
+    gpu.lods = mesh.lods;
+    gpu.subsets = mesh.subsets;
+    gpu.materialLibraries = mesh.materialLibraries;
+    gpu.materialNames = mesh.materialNames;
+    if (!gpu.lods.empty())
+        gpu.indexCount = (GLsizei)gpu.lods[0].indexCount;
+}
+
+// Envia vértices em qualquer layout junto com os índices da malha, em 16 bits quando couberem
+inline GPUMesh uploadMeshVertices(const Mesh &mesh, const void *vertexData, size_t vertexBytes,
+                                  const VertexAttribute *layout, uint32_t attributeCount, GLsizei stride)
+{
+    GPUMesh gpu;
+    size_t indexBytes;
+    if (fitsShortIndices(mesh))
+    {
+        std::vector<uint16_t> shortIndices(mesh.indices.begin(), mesh.indices.end());
+        indexBytes = shortIndices.size() * sizeof(uint16_t);
+        gpu = uploadMeshBuffers(vertexData, vertexBytes, layout, attributeCount, stride, shortIndices.data(),
+                                shortIndices.size(), GL_UNSIGNED_SHORT);
+    }
+    else
+    {
+        indexBytes = mesh.indices.size() * sizeof(uint32_t);
+        gpu = uploadMeshBuffers(vertexData, vertexBytes, layout, attributeCount, stride, mesh.indices.data(),
+                                mesh.indices.size(), GL_UNSIGNED_INT);
+    }
+
+    printIndexedMesh(mesh, vertexBytes, indexBytes);
+    copyMeshMetadata(mesh, gpu);
+    return gpu;
+}
+
+inline GPUMesh uploadMesh(const Mesh &mesh)
+{
+    return uploadMeshVertices(mesh, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex), VERTEX_LAYOUT,
+                              VERTEX_LAYOUT_SIZE, sizeof(Vertex));
+}
+
+inline void drawMesh(const GPUMesh &mesh)
+{
+    glBindVertexArray(mesh.VAO);
+    if (mesh.EBO != 0)
+        glDrawElements(GL_TRIANGLES, mesh.indexCount, mesh.indexType, 0);
+    else
+        glDrawArrays(GL_TRIANGLES, 0, mesh.indexCount);
+    glBindVertexArray(0);
+}
+
+inline void deleteMesh(GPUMesh &mesh)
+{
+    glDeleteVertexArrays(1, &mesh.VAO);
+    glDeleteBuffers(1, &mesh.VBO);
+    glDeleteBuffers(1, &mesh.EBO);
+    mesh = GPUMesh();
+}
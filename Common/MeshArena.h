@@ -0,0 +1,179 @@
+/*
+ *  MeshArena.h
+ *
+ *  Várias malhas diferentes em um único VBO, um único EBO e um único VAO. Cada
+ *  malha nova é acrescentada ao fim dos buffers; os índices são convertidos
+ *  para 32 bits e somados à posição do primeiro vértice da malha, e as faixas
+ *  de LOD, materiais e meshlets são deslocadas para a posição dos seus índices
+ *  no EBO compartilhado. O GPUMesh devolvido funciona com submitMeshLOD,
+ *  submitMeshlets e flushDrawQueue como qualquer outro, mas todas as malhas da
+ *  arena têm o mesmo VAO: flushDrawQueueIndirect (IndirectDraw.h) desenha os
+ *  objetos de todas elas com um glMultiDrawElementsIndirect por material.
+ *
+ *  Todas as malhas de uma arena usam o layout de vértice da primeira (completo
+ *  ou compacto, ver PackedVertex.h). Quando falta espaço os buffers dobram de
+ *  tamanho (glCopyBufferSubData); o VAO continua o mesmo. As malhas da arena
+ *  não são apagadas uma a uma (nada de deleteMesh): destroyMeshArena libera tudo.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  MeshArena arena;
+ *  MeshStaging staging;
+ *  if (loadMeshStaging("../assets/Modelos3D/Cube.obj", false, staging))
+ *      addArenaMesh(arena, staging, cube);  // GPUMesh cube
+ *  // ou nas threads de carga (AssetLoader.h), sem esperar o disco:
+ *  uint32_t suzanne = requestMesh(assets, "../assets/Modelos3D/Suzanne.obj", false, &arena);
+ *  ...
+ *  destroyMeshArena(arena);
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Mesh.h"
+#include "MeshCache.h"
+
+struct MeshArena
+{
+    GLuint VAO = 0;
+    GLuint VBO = 0;
+    GLuint EBO = 0;
+    VertexAttribute layout[MESH_CACHE_MAX_ATTRIBUTES] = {};
+    uint32_t attributeCount = 0;
+    GLsizei stride = 0;
+    size_t vertexCapacity = 0;  // em vértices
+    size_t indexCapacity = 0;
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    size_t meshCount = 0;
+};
+
+// Troca um buffer por outro maior com o mesmo conteúdo
+inline GLuint growArenaBuffer(GLuint buffer, size_t usedBytes, size_t newBytes)
+{
+    GLuint grown;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)newBytes, nullptr, GL_STATIC_DRAW);
+    if (buffer != 0 && usedBytes > 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (GLsizeiptr)usedBytes);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+    return grown;
+}
+
+inline void reserveMeshArena(MeshArena &arena, size_t vertexCount, size_t indexCount)
+{
+    bool grown = false;
+    if (vertexCount > arena.vertexCapacity)
+    {
+        size_t capacity = std::max(vertexCount, arena.vertexCapacity * 2);
+        arena.VBO = growArenaBuffer(arena.VBO, arena.vertexCount * arena.stride, capacity * arena.stride);
+        arena.vertexCapacity = capacity;
+        grown = true;
+    }
+    if (indexCount > arena.indexCapacity)
+    {
+        size_t capacity = std::max(indexCount, arena.indexCapacity * 2);
+        arena.EBO = growArenaBuffer(arena.EBO, arena.indexCount * sizeof(uint32_t), capacity * sizeof(uint32_t));
+        arena.indexCapacity = capacity;
+        grown = true;
+    }
+    if (!grown)
+        return;
+
+    // O VAO guarda os buffers: liga de novo os atributos e o EBO aos buffers novos
+    if (arena.VAO == 0)
+        glGenVertexArrays(1, &arena.VAO);
+    glBindVertexArray(arena.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, arena.VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena.EBO);
+    setupVertexAttributes(arena.layout, arena.attributeCount, arena.stride);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Acrescenta a malha do staging à arena; false se o layout de vértice for diferente do da arena
+inline bool addArenaMesh(MeshArena &arena, const MeshStaging &staging, GPUMesh &gpu)
+{
+    if (arena.meshCount == 0 && arena.vertexCapacity == 0)
+    {
+        std::copy(staging.layout, staging.layout + staging.attributeCount, arena.layout);
+        arena.attributeCount = staging.attributeCount;
+        arena.stride = staging.stride;
+    }
+    else if (staging.stride != arena.stride || staging.attributeCount != arena.attributeCount ||
+             memcmp(staging.layout, arena.layout, staging.attributeCount * sizeof(VertexAttribute)) != 0)
+    {
+        std::cerr << "Malha com layout de vertice diferente do da arena" << std::endl;
+        return false;
+    }
+
+    size_t vertexCount = staging.vertexBytes / staging.stride;
+    uint32_t baseVertex = (uint32_t)arena.vertexCount;
+    uint32_t firstIndex = (uint32_t)arena.indexCount;
+    reserveMeshArena(arena, arena.vertexCount + vertexCount, arena.indexCount + staging.indexCount);
+
+    std::vector<uint32_t> indices(staging.indexCount);
+    if (staging.mesh.indexType == GL_UNSIGNED_SHORT)
+    {
+        const uint16_t *source = (const uint16_t *)staging.indexData;
+        for (size_t i = 0; i < indices.size(); i++)
+            indices[i] = baseVertex + source[i];
+    }
+    else
+    {
+        const uint32_t *source = (const uint32_t *)staging.indexData;
+        for (size_t i = 0; i < indices.size(); i++)
+            indices[i] = baseVertex + source[i];
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, arena.VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(arena.vertexCount * arena.stride), (GLsizeiptr)staging.vertexBytes,
+                    staging.vertexData);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena.EBO);  // GL_ELEMENT_ARRAY_BUFFER mexeria no VAO ligado
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)(firstIndex * sizeof(uint32_t)),
+                    (GLsizeiptr)(indices.size() * sizeof(uint32_t)), indices.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    arena.vertexCount += vertexCount;
+    arena.indexCount += indices.size();
+    arena.meshCount++;
+
+    gpu = staging.mesh;
+    gpu.VAO = arena.VAO;
+    gpu.VBO = arena.VBO;
+    gpu.EBO = arena.EBO;
+    gpu.indexType = GL_UNSIGNED_INT;
+    gpu.indexCount = gpu.lods.empty() ? (GLsizei)staging.indexCount : (GLsizei)gpu.lods[0].indexCount;
+    for (MeshLOD &lod : gpu.lods)
+        lod.indexOffset += firstIndex;
+    for (MeshSubset &subset : gpu.subsets)
+        subset.indexOffset += firstIndex;
+    for (Meshlet &meshlet : gpu.meshlets)
+        meshlet.indexOffset += firstIndex;
+    // Sem LODs nem materiais submitMeshLOD começaria do índice 0 do EBO compartilhado
+    if (gpu.lods.empty())
+        gpu.lods.push_back({firstIndex, (uint32_t)staging.indexCount, 0.0f});
+    return true;
+}
+
+inline void destroyMeshArena(MeshArena &arena)
+{
+    glDeleteVertexArrays(1, &arena.VAO);
+    glDeleteBuffers(1, &arena.VBO);
+    glDeleteBuffers(1, &arena.EBO);
+    arena = MeshArena();
+}
@@ -0,0 +1,526 @@
+/*
+ *  MeshCache.h
+ *
+ *  Cache binário de malhas: na primeira carga o .OBJ é interpretado e a malha
+ *  indexada é gravada na pasta de cache compartilhada (AssetCache.h). Nas cargas
+ *  seguintes o arquivo binário é mapeado em memória e enviado direto para
+ *  glBufferData, sem converter texto em float. A malha é gravada já otimizada
+ *  (MeshOptimizer.h), dividida em meshlets (Meshlet.h) e com os níveis de detalhe
+ *  (MeshLOD.h), então esses passos só rodam quando o cache é refeito.
+ *  Com packed = true os vértices são gravados no formato compacto de
+ *  PackedVertex.h e a escala das posições é refeita a partir dos limites.
+ *
+ *  Formato (versão 8)
+ *  -----------------
+ *  MeshCacheHeader   identificação, contagens, layout dos atributos, limites e
+ *                    dados do .OBJ de origem (tamanho, data de modificação, hash)
+ *  vértices          vertexCount * vertexStride bytes, a partir de vertexOffset
+ *  índices           indexCount * indexSize bytes (2 ou 4), a partir de indexOffset;
+ *                    a malha completa seguida dos níveis simplificados
+ *  meshlets          meshletCount * sizeof(Meshlet) bytes, a partir de meshletOffset
+ *  LODs              lodCount * sizeof(MeshLOD) bytes, a partir de lodOffset
+ *  subsets           subsetCount * sizeof(MeshSubset) bytes, a partir de subsetOffset
+ *  nomes             stringSize bytes a partir de stringOffset: libraryCount arquivos
+ *                    mtllib seguidos de materialCount nomes de material, cada um
+ *                    terminado em '\0'
+ *
+ *  Caches gravados por streaming (writeMeshCacheStream) têm indexCount = 0: os
+ *  vértices formam triângulos em sequência e são desenhados com glDrawArrays.
+ *
+ *  A entrada é escolhida pelo hash do conteúdo do .OBJ, pela versão do formato e
+ *  pelo formato pedido (completo ou compacto): um .OBJ alterado ou outro formato
+ *  simplesmente cai em outra entrada, e cópias do mesmo .OBJ em pastas diferentes
+ *  usam a mesma.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "AssetCache.h"
+#include "MappedFile.h"
+#include "Mesh.h"
+#include "MeshLOD.h"
+#include "MeshNormals.h"
+#include "MeshRepair.h"
+#include "MeshOptimizer.h"
+#include "Meshlet.h"
+#include "ObjLoader.h"
+#include "ObjStream.h"
+#include "PackedVertex.h"
+
+const char MESH_CACHE_MAGIC[4] = {'C', 'G', 'M', 'B'};
+const uint32_t MESH_CACHE_VERSION = 8;
+const uint32_t MESH_CACHE_MAX_ATTRIBUTES = 8;
+const uint64_t MESH_CACHE_ALIGNMENT = 16;
+
+// Bits de MeshCacheHeader::flags
+const uint32_t MESH_CACHE_PACKED = 1u << 0;
+
+struct MeshCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t vertexStride;
+    uint32_t indexCount;
+    uint32_t indexSize;
+    uint32_t attributeCount;
+    uint32_t flags;
+    VertexAttribute attributes[MESH_CACHE_MAX_ATTRIBUTES];
+    float boundsMin[3];
+    float boundsMax[3];
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t sourceHash;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t meshletOffset;
+    uint64_t lodOffset;
+    uint32_t meshletCount;
+    uint32_t lodCount;
+    uint64_t subsetOffset;
+    uint64_t stringOffset;
+    uint32_t subsetCount;
+    uint32_t stringSize;
+    uint32_t libraryCount;
+    uint32_t materialCount;
+};
+
+static_assert(std::is_trivially_copyable<MeshCacheHeader>::value, "MeshCacheHeader deve ser copiavel byte a byte");
+static_assert(std::is_trivially_copyable<Meshlet>::value, "Meshlet deve ser copiavel byte a byte");
+static_assert(std::is_trivially_copyable<MeshLOD>::value, "MeshLOD deve ser copiavel byte a byte");
+static_assert(std::is_trivially_copyable<MeshSubset>::value, "MeshSubset deve ser copiavel byte a byte");
+
+// Entrada do cache compartilhado (AssetCache.h) para o conteúdo sourceHash no formato pedido
+inline std::string meshCachePath(uint64_t sourceHash, bool packed)
+{
+    std::string settings = "mesh " + std::to_string(MESH_CACHE_VERSION) + (packed ? " packed" : "");
+    return assetCachePath(assetCacheKey(sourceHash, settings), ".mesh");
+}
+
+inline uint64_t alignCacheOffset(uint64_t offset)
+{
+    return (offset + MESH_CACHE_ALIGNMENT - 1) & ~(MESH_CACHE_ALIGNMENT - 1);
+}
+
+// Valida cabeçalho e tamanhos; devolve nullptr se o arquivo não for um cache utilizável
+inline const MeshCacheHeader *readMeshCacheHeader(const MappedFile &file)
+{
+    if (file.size < sizeof(MeshCacheHeader))
+        return nullptr;
+
+    const MeshCacheHeader *header = (const MeshCacheHeader *)file.data;
+    if (memcmp(header->magic, MESH_CACHE_MAGIC, 4) != 0 || header->version != MESH_CACHE_VERSION)
+        return nullptr;
+    if (header->attributeCount > MESH_CACHE_MAX_ATTRIBUTES || (header->indexSize != 2 && header->indexSize != 4))
+        return nullptr;
+    if (header->vertexOffset + (uint64_t)header->vertexCount * header->vertexStride > file.size)
+        return nullptr;
+    if (header->indexOffset + (uint64_t)header->indexCount * header->indexSize > file.size)
+        return nullptr;
+    if (header->meshletOffset + (uint64_t)header->meshletCount * sizeof(Meshlet) > file.size)
+        return nullptr;
+    if (header->lodOffset + (uint64_t)header->lodCount * sizeof(MeshLOD) > file.size)
+        return nullptr;
+    if (header->subsetOffset + (uint64_t)header->subsetCount * sizeof(MeshSubset) > file.size)
+        return nullptr;
+    if (header->stringOffset + (uint64_t)header->stringSize > file.size)
+        return nullptr;
+    return header;
+}
+
+// Arquivos mtllib e nomes de material, separados por '\0'
+inline std::string packMeshCacheStrings(const std::vector<std::string> &libraries,
+                                        const std::vector<std::string> &materials)
+{
+    std::string strings;
+    for (const std::string &library : libraries)
+        strings.append(library).push_back('\0');
+    for (const std::string &material : materials)
+        strings.append(material).push_back('\0');
+    return strings;
+}
+
+inline void unpackMeshCacheStrings(const char *strings, size_t size, uint32_t libraryCount, uint32_t materialCount,
+                                   std::vector<std::string> &libraries, std::vector<std::string> &materials)
+{
+    const char *p = strings;
+    const char *end = strings + size;
+    for (uint32_t i = 0; i < libraryCount + materialCount && p < end; i++)
+    {
+        const char *terminator = (const char *)memchr(p, '\0', end - p);
+        if (!terminator)
+            break;
+        (i < libraryCount ? libraries : materials).emplace_back(p, terminator);
+        p = terminator + 1;
+    }
+}
+
+// Preenche identificação, formato dos vértices (completo ou compacto), limites e dados da origem
+inline MeshCacheHeader makeMeshCacheHeader(bool packed, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax,
+                                           uint64_t sourceSize, int64_t sourceTime, uint64_t sourceHash)
+{
+    MeshCacheHeader header{};
+    memcpy(header.magic, MESH_CACHE_MAGIC, 4);
+    header.version = MESH_CACHE_VERSION;
+    if (packed)
+    {
+        header.flags = MESH_CACHE_PACKED;
+        header.vertexStride = sizeof(PackedVertex);
+        header.attributeCount = PACKED_VERTEX_LAYOUT_SIZE;
+        memcpy(header.attributes, PACKED_VERTEX_LAYOUT, sizeof(PACKED_VERTEX_LAYOUT));
+    }
+    else
+    {
+        header.vertexStride = sizeof(Vertex);
+        header.attributeCount = VERTEX_LAYOUT_SIZE;
+        memcpy(header.attributes, VERTEX_LAYOUT, sizeof(VERTEX_LAYOUT));
+    }
+    memcpy(header.boundsMin, &boundsMin.x, sizeof(header.boundsMin));
+    memcpy(header.boundsMax, &boundsMax.x, sizeof(header.boundsMax));
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+    header.sourceHash = sourceHash;
+    header.vertexOffset = alignCacheOffset(sizeof(MeshCacheHeader));
+    return header;
+}
+
+inline bool writeMeshCache(const std::string &cachePath, const Mesh &mesh, uint64_t sourceSize, int64_t sourceTime,
+                           uint64_t sourceHash, bool packed = false)
+{
+    std::vector<PackedVertex> packedVertices;
+    const void *vertexData = mesh.vertices.data();
+    if (packed)
+    {
+        packedVertices = packVertices(mesh, quantizationParams(mesh.boundsMin, mesh.boundsMax));
+        vertexData = packedVertices.data();
+    }
+
+    MeshCacheHeader header = makeMeshCacheHeader(packed, mesh.boundsMin, mesh.boundsMax, sourceSize, sourceTime,
+                                                 sourceHash);
+    header.vertexCount = (uint32_t)mesh.vertices.size();
+    header.indexCount = (uint32_t)mesh.indices.size();
+    header.indexSize = fitsShortIndices(mesh) ? 2 : 4;
+    header.vertexOffset = alignCacheOffset(sizeof(MeshCacheHeader));
+    header.indexOffset = alignCacheOffset(header.vertexOffset + (uint64_t)header.vertexCount * header.vertexStride);
+    header.meshletCount = (uint32_t)mesh.meshlets.size();
+    header.meshletOffset = alignCacheOffset(header.indexOffset + (uint64_t)header.indexCount * header.indexSize);
+    header.lodCount = (uint32_t)mesh.lods.size();
+    header.lodOffset = alignCacheOffset(header.meshletOffset + (uint64_t)header.meshletCount * sizeof(Meshlet));
+    header.subsetCount = (uint32_t)mesh.subsets.size();
+    header.subsetOffset = alignCacheOffset(header.lodOffset + (uint64_t)header.lodCount * sizeof(MeshLOD));
+    std::string strings = packMeshCacheStrings(mesh.materialLibraries, mesh.materialNames);
+    header.stringSize = (uint32_t)strings.size();
+    header.stringOffset = header.subsetOffset + (uint64_t)header.subsetCount * sizeof(MeshSubset);
+    header.libraryCount = (uint32_t)mesh.materialLibraries.size();
+    header.materialCount = (uint32_t)mesh.materialNames.size();
+
+    std::string tempPath = assetCacheTempPath(cachePath);
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+
+        const char padding[MESH_CACHE_ALIGNMENT] = {};
+        out.write((const char *)&header, sizeof(header));
+        out.write(padding, header.vertexOffset - sizeof(header));
+        out.write((const char *)vertexData, (std::streamsize)header.vertexCount * header.vertexStride);
+        out.write(padding, header.indexOffset - (header.vertexOffset + (uint64_t)header.vertexCount * header.vertexStride));
+        if (header.indexSize == 2)
+        {
+            std::vector<uint16_t> shortIndices(mesh.indices.begin(), mesh.indices.end());
+            out.write((const char *)shortIndices.data(), shortIndices.size() * sizeof(uint16_t));
+        }
+        else
+        {
+            out.write((const char *)mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+        }
+        out.write(padding, header.meshletOffset - (header.indexOffset + (uint64_t)header.indexCount * header.indexSize));
+        out.write((const char *)mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+        out.write(padding, header.lodOffset - (header.meshletOffset + (uint64_t)header.meshletCount * sizeof(Meshlet)));
+        out.write((const char *)mesh.lods.data(), mesh.lods.size() * sizeof(MeshLOD));
+        out.write(padding, header.subsetOffset - (header.lodOffset + (uint64_t)header.lodCount * sizeof(MeshLOD)));
+        out.write((const char *)mesh.subsets.data(), mesh.subsets.size() * sizeof(MeshSubset));
+        out.write(strings.data(), strings.size());
+        if (!out)
+            return false;
+    }
+    return commitAssetCacheFile(tempPath, cachePath);
+}
+
+// Grava o cache a partir de um ObjStream, lote a lote: triângulos não indexados, sem
+// otimização, meshlets, LODs ou faixas por material, que precisariam da malha inteira na memória.
+// O arquivo gravado fica mapeado em mapped antes do commit, então a malha continua legível
+// mesmo que o trim do cache (ou outro processo) apague a entrada logo depois
+inline bool writeMeshCacheStream(const std::string &cachePath, const ObjStream &stream, uint64_t sourceSize,
+                                 int64_t sourceTime, uint64_t sourceHash, bool packed, MappedFile &mapped)
+{
+    uint64_t vertexCount = (uint64_t)stream.triangleCount * 3;
+    if (vertexCount > UINT32_MAX)
+        return false;
+
+    MeshCacheHeader header = makeMeshCacheHeader(packed, stream.boundsMin, stream.boundsMax, sourceSize, sourceTime,
+                                                 sourceHash);
+    header.vertexCount = (uint32_t)vertexCount;
+    header.indexSize = 4;
+    header.indexOffset = alignCacheOffset(header.vertexOffset + vertexCount * header.vertexStride);
+    header.meshletOffset = header.lodOffset = header.subsetOffset = header.stringOffset = header.indexOffset;
+
+    std::string tempPath = assetCacheTempPath(cachePath);
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+
+        const char padding[MESH_CACHE_ALIGNMENT] = {};
+        out.write((const char *)&header, sizeof(header));
+        out.write(padding, header.vertexOffset - sizeof(header));
+
+        QuantizationParams params = quantizationParams(stream.boundsMin, stream.boundsMax);
+        std::vector<PackedVertex> packedBatch;
+        Mesh batchMesh;
+        size_t written = streamOBJTriangles(stream, [&](const Vertex *vertices, size_t count) {
+            if (!packed)
+            {
+                out.write((const char *)vertices, count * sizeof(Vertex));
+                return;
+            }
+            batchMesh.vertices.assign(vertices, vertices + count);
+            packedBatch = packVertices(batchMesh, params);
+            out.write((const char *)packedBatch.data(), packedBatch.size() * sizeof(PackedVertex));
+        });
+        out.write(padding, header.indexOffset - (header.vertexOffset + vertexCount * header.vertexStride));
+        if (!out || written != vertexCount)
+        {
+            out.close();
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+    if (!mapped.open(tempPath))
+    {
+        std::error_code error;
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    if (!commitAssetCacheFile(tempPath, cachePath))
+        std::cerr << "Cache de malha " << cachePath << " descartado, usando a copia mapeada" << std::endl;
+    return true;
+}
+
+// Malha pronta para ir para a GPU, montada sem nenhuma chamada OpenGL (pode ser feita
+// em outra thread, ver AssetLoader.h). Os dados apontam para o cache mapeado em file
+// ou para ownedVertices/ownedIndices quando a malha não veio do cache
+struct MeshStaging
+{
+    GPUMesh mesh;  // metadados (limites, meshlets, LODs, materiais, escala), sem objetos GL
+    MappedFile file;
+    std::vector<char> ownedVertices;
+    std::vector<char> ownedIndices;
+    const char *vertexData = nullptr;
+    size_t vertexBytes = 0;
+    const char *indexData = nullptr;
+    size_t indexCount = 0;
+    VertexAttribute layout[MESH_CACHE_MAX_ATTRIBUTES] = {};
+    uint32_t attributeCount = 0;
+    GLsizei stride = 0;
+};
+
+inline size_t meshStagingIndexBytes(const MeshStaging &staging)
+{
+    return staging.indexCount * (staging.mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+}
+
+// Aponta o staging para os dados de staging.file, já validado por readMeshCacheHeader
+inline void stageMeshCache(const MeshCacheHeader &header, MeshStaging &staging)
+{
+    const char *data = staging.file.data;
+    staging.vertexData = data + header.vertexOffset;
+    staging.vertexBytes = (size_t)header.vertexCount * header.vertexStride;
+    staging.indexData = data + header.indexOffset;
+    staging.indexCount = header.indexCount;
+    memcpy(staging.layout, header.attributes, sizeof(header.attributes));
+    staging.attributeCount = header.attributeCount;
+    staging.stride = (GLsizei)header.vertexStride;
+
+    GPUMesh &gpu = staging.mesh;
+    gpu.indexType = header.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    const Meshlet *meshlets = (const Meshlet *)(data + header.meshletOffset);
+    gpu.meshlets.assign(meshlets, meshlets + header.meshletCount);
+    const MeshLOD *lods = (const MeshLOD *)(data + header.lodOffset);
+    gpu.lods.assign(lods, lods + header.lodCount);
+    const MeshSubset *subsets = (const MeshSubset *)(data + header.subsetOffset);
+    gpu.subsets.assign(subsets, subsets + header.subsetCount);
+    unpackMeshCacheStrings(data + header.stringOffset, header.stringSize, header.libraryCount,
+                           header.materialCount, gpu.materialLibraries, gpu.materialNames);
+    gpu.boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    gpu.boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    if (header.flags & MESH_CACHE_PACKED)
+    {
+        QuantizationParams params = quantizationParams(gpu.boundsMin, gpu.boundsMax);
+        gpu.positionOffset = params.offset;
+        gpu.positionScale = params.scale;
+    }
+}
+
+// Copia vértices (completos ou compactos) e índices de uma malha recém-gerada para o staging
+inline void stageMesh(const Mesh &mesh, bool packed, MeshStaging &staging)
+{
+    const char *vertexData = (const char *)mesh.vertices.data();
+    size_t vertexBytes = mesh.vertices.size() * sizeof(Vertex);
+    std::vector<PackedVertex> packedVertices;
+    if (packed)
+    {
+        QuantizationParams params = quantizationParams(mesh.boundsMin, mesh.boundsMax);
+        packedVertices = packVertices(mesh, params);
+        printQuantizationError(measureQuantizationError(mesh, packedVertices, params), mesh);
+        vertexData = (const char *)packedVertices.data();
+        vertexBytes = packedVertices.size() * sizeof(PackedVertex);
+        staging.mesh.positionOffset = params.offset;
+        staging.mesh.positionScale = params.scale;
+    }
+    staging.ownedVertices.assign(vertexData, vertexData + vertexBytes);
+
+    const VertexAttribute *layout = packed ? PACKED_VERTEX_LAYOUT : VERTEX_LAYOUT;
+    staging.attributeCount = packed ? PACKED_VERTEX_LAYOUT_SIZE : VERTEX_LAYOUT_SIZE;
+    std::copy(layout, layout + staging.attributeCount, staging.layout);
+    staging.stride = packed ? (GLsizei)sizeof(PackedVertex) : (GLsizei)sizeof(Vertex);
+
+    if (fitsShortIndices(mesh))
+    {
+        std::vector<uint16_t> shortIndices(mesh.indices.begin(), mesh.indices.end());
+        staging.ownedIndices.assign((const char *)shortIndices.data(),
+                                    (const char *)(shortIndices.data() + shortIndices.size()));
+        staging.mesh.indexType = GL_UNSIGNED_SHORT;
+    }
+    else
+    {
+        staging.ownedIndices.assign((const char *)mesh.indices.data(),
+                                    (const char *)(mesh.indices.data() + mesh.indices.size()));
+        staging.mesh.indexType = GL_UNSIGNED_INT;
+    }
+
+    staging.vertexData = staging.ownedVertices.data();
+    staging.vertexBytes = staging.ownedVertices.size();
+    staging.indexData = staging.ownedIndices.data();
+    staging.indexCount = mesh.indices.size();
+    copyMeshMetadata(mesh, staging.mesh);
+    printIndexedMesh(mesh, staging.vertexBytes, staging.ownedIndices.size());
+}
+
+// Copia os metadados do staging para a malha cujos buffers acabaram de ser criados
+inline void applyMeshStaging(const MeshStaging &staging, GPUMesh &gpu)
+{
+    GLuint VAO = gpu.VAO, VBO = gpu.VBO, EBO = gpu.EBO;
+    GLsizei indexCount = gpu.indexCount;
+    gpu = staging.mesh;
+    gpu.VAO = VAO;
+    gpu.VBO = VBO;
+    gpu.EBO = EBO;
+    gpu.indexCount = gpu.lods.empty() ? indexCount : (GLsizei)gpu.lods[0].indexCount;
+}
+
+inline GPUMesh uploadMeshStaging(const MeshStaging &staging)
+{
+    GPUMesh gpu = uploadMeshBuffers(staging.vertexData, staging.vertexBytes, staging.layout, staging.attributeCount,
+                                    staging.stride, staging.indexData, staging.indexCount, staging.mesh.indexType);
+    applyMeshStaging(staging, gpu);
+    return gpu;
+}
+
+// Parte do carregamento que não usa OpenGL: usa a entrada do cache compartilhado
+// (AssetCache.h) com o mesmo conteúdo e formato; senão interpreta o .OBJ, gera a malha
+// indexada e grava a entrada. Arquivos a partir de OBJ_STREAM_THRESHOLD bytes vão em
+// janelas direto para o cache (ObjStream.h). packed = true usa vértices quantizados
+// (PackedVertex.h)
+inline bool loadMeshStaging(const std::string &objPath, bool packed, MeshStaging &staging)
+{
+    AssetSource source;
+    if (!statAssetSource(objPath, source))
+    {
+        std::cerr << "Erro ao tentar ler o arquivo " << objPath << std::endl;
+        return false;
+    }
+    uint64_t sourceSize = source.size, sourceHash = source.hash;
+    int64_t sourceTime = source.time;
+
+    std::string cachePath = meshCachePath(sourceHash, packed);
+    {
+        auto start = std::chrono::steady_clock::now();
+        const MeshCacheHeader *header = staging.file.open(cachePath) ? readMeshCacheHeader(staging.file) : nullptr;
+        bool headerPacked = header && (header->flags & MESH_CACHE_PACKED) != 0;
+        if (header && headerPacked == packed && header->sourceSize == sourceSize && header->sourceHash == sourceHash)
+        {
+            stageMeshCache(*header, staging);
+            touchAssetCacheEntry(cachePath);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << "Cache de malha " << objPath << ": " << header->vertexCount << " vertices, "
+                      << header->indexCount << " indices, " << header->meshletCount << " meshlets, "
+                      << header->lodCount << " LODs, " << header->materialCount << " materiais, "
+                      << elapsed.count() * 1000.0 << " ms" << std::endl;
+            return true;
+        }
+        staging.file.close();
+    }
+
+    if (sourceSize >= OBJ_STREAM_THRESHOLD)
+    {
+        auto start = std::chrono::steady_clock::now();
+        ObjStream stream;
+        if (!openOBJStream(objPath, stream))
+            return false;
+        bool written =
+            writeMeshCacheStream(cachePath, stream, sourceSize, sourceTime, sourceHash, packed, staging.file);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        printOBJStreamStats(objPath, stream, elapsed.count());
+        closeOBJStream(stream);
+
+        const MeshCacheHeader *header =
+            written ? readMeshCacheHeader(staging.file) : nullptr;
+        if (!header)
+        {
+            std::cerr << "Nao foi possivel gravar o cache de malha " << cachePath << std::endl;
+            return false;
+        }
+        stageMeshCache(*header, staging);
+        return true;
+    }
+
+    ObjData obj;
+    if (!loadOBJ(objPath, obj))
+        return false;
+
+    repairMesh(obj);
+    generateNormals(obj);
+    Mesh mesh = buildIndexedMesh(obj);
+    optimizeMesh(mesh);
+    buildMeshlets(mesh);
+    buildMeshLODs(mesh);
+    if (!writeMeshCache(cachePath, mesh, sourceSize, sourceTime, sourceHash, packed))
+        std::cerr << "Nao foi possivel gravar o cache de malha " << cachePath << std::endl;
+
+    stageMesh(mesh, packed, staging);
+    return true;
+}
+
+// Carga completa na thread atual (a versão assíncrona fica em AssetLoader.h)
+inline GPUMesh loadMeshCached(const std::string &objPath, bool packed = false)
+{
+    MeshStaging staging;
+    if (!loadMeshStaging(objPath, packed, staging))
+        return GPUMesh();
+    return uploadMeshStaging(staging);
+}
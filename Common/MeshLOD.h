@@ -0,0 +1,141 @@
+/*
+ *  MeshLOD.h
+ *
+ *  Cadeia de níveis de detalhe gerada com MeshSimplifier.h. Cada nível tem
+ *  cerca de MESH_LOD_RATIO dos triângulos do anterior e é simplificado a partir
+ *  da malha completa, então o erro guardado em MeshLOD é o erro real em relação
+ *  ao original. Todos os níveis ficam no mesmo buffer de índices, depois da
+ *  malha completa, e usam o mesmo buffer de vértices.
+ *
+ *  Malhas com mais de um material são simplificadas material por material, com
+ *  as bordas entre eles fixas; cada nível ganha seus próprios MeshSubset.
+ *
+ *  Na hora de desenhar, selectMeshLOD projeta o erro de cada nível na tela
+ *  (usando a distância até a esfera envolvente do objeto) e escolhe o nível mais
+ *  simples cujo erro fica abaixo de MESH_LOD_PIXEL_ERROR pixels.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  buildMeshLODs(mesh);                     // depois de optimizeMesh/buildMeshlets
+ *  GPUMesh gpu = uploadMesh(mesh);
+ *  ...
+ *  size_t lod = selectMeshLOD(gpu, model, projection, camera.position, viewportHeight);
+ *  drawMeshLOD(gpu, lod);
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+
+const uint32_t MESH_LOD_COUNT = 4;          // incluindo a malha completa
+const float MESH_LOD_RATIO = 0.5f;          // fração dos triângulos mantida a cada nível
+const float MESH_LOD_MAX_ERROR = 0.05f;     // erro máximo aceito (fração da maior dimensão)
+const float MESH_LOD_PIXEL_ERROR = 1.0f;    // erro tolerado na tela, em pixels
+
+// Acrescenta os níveis simplificados ao buffer de índices (que deve conter só a malha completa)
+inline void buildMeshLODs(Mesh &mesh, uint32_t lodCount = MESH_LOD_COUNT, float ratio = MESH_LOD_RATIO,
+                          float maxError = MESH_LOD_MAX_ERROR)
+{
+    mesh.lods.clear();
+    if (mesh.indices.empty())
+        return;
+
+    size_t fullCount = mesh.indices.size();
+    mesh.lods.push_back({0, (uint32_t)fullCount, 0.0f});
+    if (mesh.subsets.empty())
+        mesh.subsets.push_back({0, (uint32_t)fullCount, 0, 0});
+    std::vector<MeshSubset> fullSubsets(mesh.subsets.begin(), mesh.subsets.end());
+    bool lockBorder = fullSubsets.size() > 1;
+
+    float levelRatio = 1.0f;
+    for (uint32_t level = 1; level < lodCount; level++)
+    {
+        levelRatio *= ratio;
+        float error = 0.0f;
+        std::vector<uint32_t> lod;
+        std::vector<MeshSubset> lodSubsets;
+        for (const MeshSubset &subset : fullSubsets)
+        {
+            size_t targetCount = (size_t)(subset.indexCount * levelRatio) / 3 * 3;
+            float subsetError = 0.0f;
+            std::vector<uint32_t> simplified = simplifyMesh(mesh, mesh.indices.data() + subset.indexOffset,
+                                                            subset.indexCount, targetCount, maxError, &subsetError,
+                                                            lockBorder);
+            if (simplified.empty())
+                continue;
+            optimizeVertexCache(simplified.data(), simplified.size(), mesh.vertices.size());
+            lodSubsets.push_back({(uint32_t)lod.size(), (uint32_t)simplified.size(), subset.material, level});
+            lod.insert(lod.end(), simplified.begin(), simplified.end());
+            error = std::max(error, subsetError);
+        }
+
+        // Parou antes de reduzir de verdade (vértices fixos ou erro máximo)
+        uint32_t previousCount = mesh.lods.back().indexCount;
+        if (lod.empty() || lod.size() > previousCount * 0.9)
+            break;
+
+        uint32_t offset = (uint32_t)mesh.indices.size();
+        for (MeshSubset &subset : lodSubsets)
+            subset.indexOffset += offset;
+        mesh.lods.push_back({offset, (uint32_t)lod.size(), error});
+        mesh.subsets.insert(mesh.subsets.end(), lodSubsets.begin(), lodSubsets.end());
+        mesh.indices.insert(mesh.indices.end(), lod.begin(), lod.end());
+    }
+
+    std::cout << "LODs:";
+    for (const MeshLOD &lod : mesh.lods)
+        std::cout << " " << lod.indexCount / 3 << " (erro " << lod.error << ")";
+    std::cout << " triangulos" << std::endl;
+}
+
+// Índice do nível mais simples cujo erro projetado fica abaixo de pixelError
+inline size_t selectMeshLOD(const GPUMesh &mesh, const glm::mat4 &model, const glm::mat4 &projection,
+                            const glm::vec3 &cameraPosition, float viewportHeight,
+                            float pixelError = MESH_LOD_PIXEL_ERROR)
+{
+    if (mesh.lods.size() <= 1)
+        return 0;
+
+    glm::vec3 extent = mesh.boundsMax - mesh.boundsMin;
+    float size = std::max(extent.x, std::max(extent.y, extent.z));
+    float modelScale = std::max(glm::length(glm::vec3(model[0])),
+                                std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    glm::vec3 center = glm::vec3(model * glm::vec4((mesh.boundsMin + mesh.boundsMax) * 0.5f, 1.0f));
+    float distance = glm::length(center - cameraPosition) - glm::length(extent) * 0.5f * modelScale;
+    if (distance <= 0.0f)
+        return 0;
+
+    // Pixels ocupados por uma unidade do objeto na distância da esfera envolvente
+    float pixelsPerUnit = projection[1][1] * viewportHeight * 0.5f * modelScale / distance;
+    size_t selected = 0;
+    for (size_t i = 1; i < mesh.lods.size(); i++)
+        if (mesh.lods[i].error * size * pixelsPerUnit <= pixelError)
+            selected = i;
+    return selected;
+}
+
+inline void drawMeshLOD(const GPUMesh &mesh, size_t lod)
+{
+    if (lod >= mesh.lods.size())
+    {
+        drawMesh(mesh);
+        return;
+    }
+
+    size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    glBindVertexArray(mesh.VAO);
+    glDrawElements(GL_TRIANGLES, (GLsizei)mesh.lods[lod].indexCount, mesh.indexType,
+                   (const void *)(uintptr_t)(mesh.lods[lod].indexOffset * indexSize));
+    glBindVertexArray(0);
+}
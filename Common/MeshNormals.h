@@ -0,0 +1,284 @@
+/*
+ *  MeshNormals.h
+ *
+ *  Geração de normais suaves para os cantos de face do .OBJ que não têm registro
+ *  vn (muitos exportadores omitem as normais). Roda sobre o ObjData, antes de
+ *  buildIndexedMesh, para que cantos com a mesma posição e a mesma normal gerada
+ *  continuem virando um único vértice.
+ *
+ *  1. Normal de cada face (soma dos produtos vetoriais do leque, que vale para
+ *     polígonos de qualquer tamanho), quatro triângulos por vez com SSE, e o peso
+ *     de cada canto: o ângulo interno (NORMAL_WEIGHT_ANGLE) ou a área da face
+ *     (NORMAL_WEIGHT_AREA).
+ *  2. Lista dos cantos de cada posição (ordenação por contagem).
+ *  3. Cada posição soma as normais das faces vizinhas lendo a sua lista: nenhuma
+ *     thread escreve na normal de outra posição, então não há atomics nem locks.
+ *     Com ângulo de vinco, um canto só soma as faces cuja normal difere da sua
+ *     por no máximo creaseAngle graus; cantos com o mesmo resultado dividem a normal.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  ObjData obj;
+ *  loadOBJ("../assets/Modelos3D/Suzanne.obj", obj);
+ *  generateNormals(obj);            // vinco de NORMAL_CREASE_ANGLE graus
+ *  generateNormals(obj, 180.0f);    // tudo suave
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ObjLoader.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define MESH_NORMALS_SSE 1
+#endif
+
+const float NORMAL_CREASE_ANGLE = 60.0f;   // graus; 180 ou mais desliga o vinco
+const size_t NORMALS_MIN_BATCH = 16384;    // faces/posições mínimas por thread
+
+enum NormalWeighting
+{
+    NORMAL_WEIGHT_ANGLE,  // ângulo interno do canto (independe da triangulação)
+    NORMAL_WEIGHT_AREA    // área da face
+};
+
+// Divide [0, count) em faixas contíguas, uma por thread
+template <typename Function>
+void normalsParallelFor(size_t count, unsigned threadCount, Function function)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    unsigned threads = (unsigned)std::min<size_t>(threadCount, std::max<size_t>(1, count / NORMALS_MIN_BATCH));
+    if (threads <= 1)
+    {
+        function((size_t)0, count);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; i++)
+        workers.emplace_back(function, count * i / threads, count * (i + 1) / threads);
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+inline bool objHasNormal(const ObjData &obj, const ObjCorner &corner)
+{
+    return corner.vn >= 0 && (size_t)corner.vn < obj.normals.size();
+}
+
+// Normal de quatro triângulos: (b - a) x (c - a) com os vértices em estrutura de arrays
+inline void triangleNormals4(const float *ax, const float *ay, const float *az, const float *bx, const float *by,
+                             const float *bz, const float *cx, const float *cy, const float *cz, glm::vec3 *normals)
+{
+#ifdef MESH_NORMALS_SSE
+    __m128 x = _mm_loadu_ps(ax), y = _mm_loadu_ps(ay), z = _mm_loadu_ps(az);
+    __m128 ux = _mm_sub_ps(_mm_loadu_ps(bx), x), uy = _mm_sub_ps(_mm_loadu_ps(by), y),
+           uz = _mm_sub_ps(_mm_loadu_ps(bz), z);
+    __m128 vx = _mm_sub_ps(_mm_loadu_ps(cx), x), vy = _mm_sub_ps(_mm_loadu_ps(cy), y),
+           vz = _mm_sub_ps(_mm_loadu_ps(cz), z);
+    float nx[4], ny[4], nz[4];
+    _mm_storeu_ps(nx, _mm_sub_ps(_mm_mul_ps(uy, vz), _mm_mul_ps(uz, vy)));
+    _mm_storeu_ps(ny, _mm_sub_ps(_mm_mul_ps(uz, vx), _mm_mul_ps(ux, vz)));
+    _mm_storeu_ps(nz, _mm_sub_ps(_mm_mul_ps(ux, vy), _mm_mul_ps(uy, vx)));
+    for (int i = 0; i < 4; i++)
+        normals[i] = glm::vec3(nx[i], ny[i], nz[i]);
+#else
+    for (int i = 0; i < 4; i++)
+        normals[i] = glm::cross(glm::vec3(bx[i] - ax[i], by[i] - ay[i], bz[i] - az[i]),
+                                glm::vec3(cx[i] - ax[i], cy[i] - ay[i], cz[i] - az[i]));
+#endif
+}
+
+// Soma dos produtos vetoriais do leque: o dobro da área vetorial do polígono
+inline glm::vec3 objFaceNormal(const ObjData &obj, const ObjCorner *corners, uint32_t faceSize)
+{
+    glm::vec3 normal(0.0f);
+    glm::vec3 origin = objCornerPosition(obj, corners[0]);
+    for (uint32_t i = 1; i + 1 < faceSize; i++)
+        normal += glm::cross(objCornerPosition(obj, corners[i]) - origin, objCornerPosition(obj, corners[i + 1]) - origin);
+    return normal;
+}
+
+// Devolve o número de cantos que receberam normais geradas (acrescentadas a obj.normals)
+inline size_t generateNormals(ObjData &obj, float creaseAngle = NORMAL_CREASE_ANGLE,
+                              NormalWeighting weighting = NORMAL_WEIGHT_ANGLE, unsigned threadCount = 0)
+{
+    std::vector<uint8_t> generated(obj.corners.size());
+    size_t missing = 0;
+    for (size_t c = 0; c < obj.corners.size(); c++)
+    {
+        generated[c] = !objHasNormal(obj, obj.corners[c]);
+        missing += generated[c];
+    }
+    if (missing == 0)
+        return 0;
+
+    auto start = std::chrono::steady_clock::now();
+    const size_t faceCount = obj.faceSizes.size();
+    const size_t cornerCount = obj.corners.size();
+    const size_t positionCount = obj.positions.size();
+
+    std::vector<uint32_t> faceFirst(faceCount + 1, 0);
+    for (size_t f = 0; f < faceCount; f++)
+        faceFirst[f + 1] = faceFirst[f] + obj.faceSizes[f];
+
+    // 1. Normais unitárias das faces, face de cada canto e peso de cada canto
+    std::vector<glm::vec3> faceNormals(faceCount);
+    std::vector<uint32_t> cornerFaces(cornerCount);
+    std::vector<float> cornerWeights(cornerCount);
+    normalsParallelFor(faceCount, threadCount, [&](size_t begin, size_t end) {
+        size_t f = begin;
+        while (f < end)
+        {
+            size_t batch = 0;
+            while (batch < 4 && f + batch < end && obj.faceSizes[f + batch] == 3)
+                batch++;
+            if (batch == 4)
+            {
+                float p[9][4];
+                for (int i = 0; i < 4; i++)
+                    for (int k = 0; k < 3; k++)
+                    {
+                        glm::vec3 position = objCornerPosition(obj, obj.corners[faceFirst[f + i] + k]);
+                        p[k * 3][i] = position.x;
+                        p[k * 3 + 1][i] = position.y;
+                        p[k * 3 + 2][i] = position.z;
+                    }
+                triangleNormals4(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], p[8], &faceNormals[f]);
+            }
+            else
+            {
+                batch = std::max<size_t>(batch, 1);
+                for (size_t i = 0; i < batch; i++)
+                    faceNormals[f + i] = objFaceNormal(obj, &obj.corners[faceFirst[f + i]], obj.faceSizes[f + i]);
+            }
+
+            for (size_t i = f; i < f + batch; i++)
+            {
+                float length = glm::length(faceNormals[i]);
+                faceNormals[i] = length > 0.0f ? faceNormals[i] / length : glm::vec3(0.0f);
+                uint32_t first = faceFirst[i];
+                uint32_t size = obj.faceSizes[i];
+                for (uint32_t k = 0; k < size; k++)
+                {
+                    cornerFaces[first + k] = (uint32_t)i;
+                    if (weighting == NORMAL_WEIGHT_AREA)
+                    {
+                        cornerWeights[first + k] = length;
+                        continue;
+                    }
+                    glm::vec3 position = objCornerPosition(obj, obj.corners[first + k]);
+                    glm::vec3 toPrevious = objCornerPosition(obj, obj.corners[first + (k + size - 1) % size]) - position;
+                    glm::vec3 toNext = objCornerPosition(obj, obj.corners[first + (k + 1) % size]) - position;
+                    cornerWeights[first + k] =
+                        std::atan2(glm::length(glm::cross(toPrevious, toNext)), glm::dot(toPrevious, toNext));
+                }
+            }
+            f += batch;
+        }
+    });
+
+    // 2. Cantos de cada posição (CSR: positionCorners[positionFirst[p] .. positionFirst[p + 1]])
+    std::vector<uint32_t> positionFirst(positionCount + 1, 0);
+    for (const ObjCorner &corner : obj.corners)
+        if (corner.v >= 0 && (size_t)corner.v < positionCount)
+            positionFirst[corner.v + 1]++;
+    for (size_t p = 0; p < positionCount; p++)
+        positionFirst[p + 1] += positionFirst[p];
+    std::vector<uint32_t> positionCorners(positionFirst[positionCount]);
+    {
+        std::vector<uint32_t> fill(positionFirst.begin(), positionFirst.end() - 1);
+        for (size_t c = 0; c < cornerCount; c++)
+        {
+            int v = obj.corners[c].v;
+            if (v >= 0 && (size_t)v < positionCount)
+                positionCorners[fill[v]++] = (uint32_t)c;
+        }
+    }
+
+    // 3. Normal de cada canto sem vn; cornerSlots numera as normais distintas de cada posição
+    const bool smooth = creaseAngle >= 180.0f;
+    const float creaseCos = std::cos(glm::radians(creaseAngle));
+    std::vector<glm::vec3> cornerNormals(cornerCount);
+    std::vector<uint32_t> cornerSlots(cornerCount);
+    std::vector<uint32_t> positionNormals(positionCount + 1, 0);
+    normalsParallelFor(positionCount, threadCount, [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; p++)
+        {
+            const uint32_t *first = positionCorners.data() + positionFirst[p];
+            const uint32_t *last = positionCorners.data() + positionFirst[p + 1];
+            uint32_t distinct = 0;
+            const uint32_t *shared = nullptr;  // sem vinco a soma é a mesma para todos os cantos
+            for (const uint32_t *c = first; c != last; c++)
+            {
+                if (!generated[*c])
+                    continue;
+                if (shared)
+                {
+                    cornerNormals[*c] = cornerNormals[*shared];
+                    cornerSlots[*c] = cornerSlots[*shared];
+                    continue;
+                }
+
+                glm::vec3 faceNormal = faceNormals[cornerFaces[*c]];
+                glm::vec3 sum(0.0f);
+                for (const uint32_t *d = first; d != last; d++)
+                {
+                    glm::vec3 other = faceNormals[cornerFaces[*d]];
+                    if (smooth || faceNormal == glm::vec3(0.0f) || glm::dot(faceNormal, other) >= creaseCos)
+                        sum += cornerWeights[*d] * other;
+                }
+                float length = glm::length(sum);
+                glm::vec3 normal = length > 0.0f ? sum / length
+                                   : faceNormal != glm::vec3(0.0f) ? faceNormal : glm::vec3(0.0f, 0.0f, 1.0f);
+                if (smooth && length > 0.0f)
+                    shared = c;
+
+                uint32_t slot = distinct;
+                for (const uint32_t *e = first; e != c && slot == distinct; e++)
+                    if (generated[*e] && cornerNormals[*e] == normal)
+                        slot = cornerSlots[*e];
+                cornerNormals[*c] = normal;
+                cornerSlots[*c] = slot;
+                distinct += slot == distinct;
+            }
+            positionNormals[p + 1] = distinct;
+        }
+    });
+
+    // 4. Acrescenta as normais distintas a obj.normals e aponta os cantos para elas
+    for (size_t p = 0; p < positionCount; p++)
+        positionNormals[p + 1] += positionNormals[p];
+    const size_t base = obj.normals.size();
+    obj.normals.resize(base + positionNormals[positionCount]);
+    normalsParallelFor(positionCount, threadCount, [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; p++)
+            for (uint32_t i = positionFirst[p]; i < positionFirst[p + 1]; i++)
+            {
+                uint32_t c = positionCorners[i];
+                if (!generated[c])
+                    continue;
+                size_t index = base + positionNormals[p] + cornerSlots[c];
+                obj.normals[index] = cornerNormals[c];
+                obj.corners[c].vn = (int)index;
+            }
+    });
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Normais geradas: " << missing << " cantos sem vn, " << obj.normals.size() - base
+              << " normais (vinco de " << (smooth ? 180.0f : creaseAngle) << " graus), " << elapsed.count() << " ms"
+              << std::endl;
+    return missing;
+}
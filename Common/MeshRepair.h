@@ -0,0 +1,273 @@
+/*
+ *  MeshRepair.h
+ *
+ *  Validação e reparo da topologia de um ObjData, logo depois da leitura e antes
+ *  de generateNormals/buildIndexedMesh:
+ *
+ *  1. Índices fora da faixa: faces com posição inválida são descartadas; vt/vn
+ *     inválidos são removidos do canto (o canto fica sem o atributo).
+ *  2. Solda de posições a menos de weldEpsilon * diagonal da caixa envolvente,
+ *     com hash espacial em células do tamanho do epsilon (só as 27 células
+ *     vizinhas são consultadas). Coordenadas de textura e normais repetidas
+ *     (valores idênticos) também passam a usar um único índice.
+ *  3. Triangulação dos polígonos por corte de orelhas (triangulatePolygon).
+ *  4. Remoção de triângulos degenerados: cantos com a mesma posição (depois da
+ *     solda) ou altura menor que o epsilon (área praticamente nula).
+ *
+ *  Depois do reparo todas as faces são triângulos e os grupos de material são
+ *  renumerados. As estatísticas são impressas no console.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  ObjData obj;
+ *  loadOBJ("../assets/Modelos3D/Suzanne.obj", obj);
+ *  repairMesh(obj);
+ *  Mesh mesh = buildIndexedMesh(obj);
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ObjLoader.h"
+
+const float MESH_WELD_EPSILON = 1e-6f;  // relativo à diagonal da caixa envolvente
+
+struct MeshRepairStats
+{
+    size_t invalidFaces = 0;         // faces descartadas: posição fora da faixa ou menos de 3 cantos
+    size_t invalidTexCoords = 0;     // índices vt fora da faixa, removidos
+    size_t invalidNormals = 0;       // índices vn fora da faixa, removidos
+    size_t weldedPositions = 0;
+    size_t weldedTexCoords = 0;
+    size_t weldedNormals = 0;
+    size_t polygons = 0;             // faces com mais de 3 cantos trianguladas
+    size_t degenerateTriangles = 0;
+    size_t triangles = 0;            // triângulos restantes
+};
+
+inline uint32_t repairHashCell(int64_t x, int64_t y, int64_t z)
+{
+    uint64_t h = (uint64_t)x * 0x9E3779B97F4A7C15ull ^ (uint64_t)y * 0xC2B2AE3D27D4EB4Full ^
+                 (uint64_t)z * 0x165667B19E3779F9ull;
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+// Solda posições a até epsilon (> 0) uma da outra; remap[i] recebe a posição que fica no lugar de i.
+// As células da grade têm lado epsilon, então vizinhos a até epsilon estão nas 27 células
+// em volta. Cada célula guarda uma lista encadeada (heads/next) das posições mantidas.
+inline size_t weldPositions(const std::vector<glm::vec3> &positions, float epsilon, std::vector<uint32_t> &remap)
+{
+    const uint32_t none = ~0u;
+    size_t tableSize = 16;
+    while (tableSize < positions.size() * 2)
+        tableSize <<= 1;
+    std::vector<uint32_t> heads(tableSize, none);
+    std::vector<uint32_t> next(positions.size(), none);
+    remap.resize(positions.size());
+
+    const float cell = epsilon;
+    const float epsilon2 = epsilon * epsilon;
+    size_t welded = 0;
+    for (uint32_t i = 0; i < positions.size(); i++)
+    {
+        const glm::vec3 &p = positions[i];
+        int64_t cx = (int64_t)std::floor(p.x / cell), cy = (int64_t)std::floor(p.y / cell),
+                cz = (int64_t)std::floor(p.z / cell);
+        uint32_t match = none;
+        for (int dz = -1; dz <= 1 && match == none; dz++)
+            for (int dy = -1; dy <= 1 && match == none; dy++)
+                for (int dx = -1; dx <= 1 && match == none; dx++)
+                {
+                    uint32_t slot = repairHashCell(cx + dx, cy + dy, cz + dz) & (tableSize - 1);
+                    for (uint32_t j = heads[slot]; j != none; j = next[j])
+                    {
+                        glm::vec3 d = positions[j] - p;
+                        if (glm::dot(d, d) <= epsilon2)
+                        {
+                            match = j;
+                            break;
+                        }
+                    }
+                }
+
+        if (match != none)
+        {
+            remap[i] = match;
+            welded++;
+            continue;
+        }
+        remap[i] = i;
+        uint32_t slot = repairHashCell(cx, cy, cz) & (tableSize - 1);
+        next[i] = heads[slot];
+        heads[slot] = i;
+    }
+    return welded;
+}
+
+// Valores idênticos (bit a bit) passam a usar o primeiro índice
+template <typename T>
+size_t weldExact(const std::vector<T> &values, std::vector<uint32_t> &remap)
+{
+    const uint32_t none = ~0u;
+    size_t tableSize = 16;
+    while (tableSize < values.size() * 2)
+        tableSize <<= 1;
+    std::vector<uint32_t> table(tableSize, none);
+    remap.resize(values.size());
+
+    size_t welded = 0;
+    for (uint32_t i = 0; i < values.size(); i++)
+    {
+        uint32_t words[sizeof(T) / 4];
+        memcpy(words, &values[i], sizeof(T));
+        uint32_t h = 2166136261u;
+        for (uint32_t word : words)
+            h = (h ^ word) * 16777619u;
+
+        size_t slot = h & (tableSize - 1);
+        while (table[slot] != none && memcmp(&values[table[slot]], &values[i], sizeof(T)) != 0)
+            slot = (slot + 1) & (tableSize - 1);
+        if (table[slot] == none)
+        {
+            table[slot] = i;
+            remap[i] = i;
+        }
+        else
+        {
+            remap[i] = table[slot];
+            welded++;
+        }
+    }
+    return welded;
+}
+
+inline void printMeshRepairStats(const MeshRepairStats &stats)
+{
+    std::cout << "Reparo de malha: " << stats.weldedPositions << " posicoes, " << stats.weldedTexCoords
+              << " coordenadas de textura e " << stats.weldedNormals << " normais soldadas; "
+              << stats.polygons << " poligonos triangulados; " << stats.degenerateTriangles
+              << " triangulos degenerados e " << stats.invalidFaces << " faces invalidas removidos; "
+              << stats.invalidTexCoords + stats.invalidNormals << " indices vt/vn fora da faixa; "
+              << stats.triangles << " triangulos" << std::endl;
+}
+
+inline MeshRepairStats repairMesh(ObjData &obj, float weldEpsilon = MESH_WELD_EPSILON)
+{
+    MeshRepairStats stats;
+
+    glm::vec3 minimum(0.0f), maximum(0.0f);
+    if (!obj.positions.empty())
+    {
+        minimum = maximum = obj.positions[0];
+        for (const glm::vec3 &p : obj.positions)
+        {
+            minimum = glm::min(minimum, p);
+            maximum = glm::max(maximum, p);
+        }
+    }
+    const float epsilon = weldEpsilon * glm::length(maximum - minimum);
+
+    std::vector<uint32_t> positionRemap, texCoordRemap, normalRemap;
+    stats.weldedPositions = epsilon > 0.0f ? weldPositions(obj.positions, epsilon, positionRemap)
+                                           : weldExact(obj.positions, positionRemap);
+    stats.weldedTexCoords = weldExact(obj.texCoords, texCoordRemap);
+    stats.weldedNormals = weldExact(obj.normals, normalRemap);
+
+    std::vector<ObjCorner> corners;
+    std::vector<uint32_t> faceSizes;
+    std::vector<ObjMaterialGroup> materialGroups;
+    corners.reserve(obj.corners.size());
+    faceSizes.reserve(obj.faceSizes.size());
+
+    auto position = [&](const ObjCorner &corner) { return obj.positions[corner.v]; };
+    PolygonScratch scratch;
+    std::vector<ObjCorner> face;
+    size_t group = 0;
+    size_t first = 0;
+    for (size_t f = 0; f < obj.faceSizes.size(); f++)
+    {
+        while (group < obj.materialGroups.size() && obj.materialGroups[group].firstFace <= f)
+            materialGroups.push_back({(uint32_t)faceSizes.size(), obj.materialGroups[group++].material});
+
+        uint32_t faceSize = obj.faceSizes[f];
+        face.assign(obj.corners.begin() + first, obj.corners.begin() + first + faceSize);
+        first += faceSize;
+
+        bool valid = faceSize >= 3;
+        for (ObjCorner &corner : face)
+        {
+            if (corner.v < 0 || (size_t)corner.v >= obj.positions.size())
+            {
+                valid = false;
+                break;
+            }
+            corner.v = (int)positionRemap[corner.v];
+            if (corner.vt >= 0 && (size_t)corner.vt < obj.texCoords.size())
+                corner.vt = (int)texCoordRemap[corner.vt];
+            else if (corner.vt != -1)
+            {
+                corner.vt = -1;
+                stats.invalidTexCoords++;
+            }
+            if (corner.vn >= 0 && (size_t)corner.vn < obj.normals.size())
+                corner.vn = (int)normalRemap[corner.vn];
+            else if (corner.vn != -1)
+            {
+                corner.vn = -1;
+                stats.invalidNormals++;
+            }
+        }
+        if (!valid)
+        {
+            stats.invalidFaces++;
+            continue;
+        }
+
+        stats.polygons += faceSize > 3;
+        const std::vector<uint32_t> &triangles = triangulatePolygon(face.data(), faceSize, position, scratch);
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            const ObjCorner &a = face[triangles[i]], &b = face[triangles[i + 1]], &c = face[triangles[i + 2]];
+            glm::vec3 pa = obj.positions[a.v], pb = obj.positions[b.v], pc = obj.positions[c.v];
+            float longest = std::max({glm::length(pb - pa), glm::length(pc - pb), glm::length(pa - pc)});
+            bool degenerate = a.v == b.v || b.v == c.v || c.v == a.v ||
+                              glm::length(glm::cross(pb - pa, pc - pa)) <= epsilon * longest;
+            if (degenerate)
+            {
+                stats.degenerateTriangles++;
+                continue;
+            }
+            corners.insert(corners.end(), {a, b, c});
+            faceSizes.push_back(3);
+        }
+    }
+
+    // Grupos que ficaram sem faces (ou repetem o material do último grupo mantido) não valem
+    // mais nada. Um grupo esvaziado é tirado antes da comparação, para que A, B vazio, A vire um só A
+    std::vector<ObjMaterialGroup> groups;
+    for (const ObjMaterialGroup &g : materialGroups)
+    {
+        if (g.firstFace >= faceSizes.size())
+            continue;
+        if (!groups.empty() && groups.back().firstFace == g.firstFace)
+            groups.pop_back();
+        if (groups.empty() || groups.back().material != g.material)
+            groups.push_back(g);
+    }
+
+    obj.corners.swap(corners);
+    obj.faceSizes.swap(faceSizes);
+    obj.materialGroups.swap(groups);
+    stats.triangles = obj.faceSizes.size();
+    printMeshRepairStats(stats);
+    return stats;
+}
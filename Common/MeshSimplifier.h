@@ -0,0 +1,430 @@
+/*
+ *  MeshSimplifier.h
+ *
+ *  Simplificação de malhas indexadas por colapso de arestas com métrica de erro
+ *  quádrica (Garland & Heckbert 1997). Cada vértice acumula as quádricas dos
+ *  planos dos seus triângulos; colapsar a aresta u -> v custa o erro quádrico de
+ *  u avaliado na posição de v. Os vértices só se movem para posições que já
+ *  existem, então normais e coordenadas de textura continuam válidas e todos os
+ *  níveis compartilham o mesmo buffer de vértices (só os índices mudam).
+ *
+ *  Costuras de UV: vértices com a mesma posição e atributos diferentes são
+ *  tratados como um só ponto. Um vértice de costura só pode colapsar ao longo da
+ *  própria costura, movendo os dois lados juntos, e as arestas de costura e de
+ *  borda recebem quádricas extras que as mantêm no lugar. Vértices em situações
+ *  mais complexas (mais de dois lados, borda e costura ao mesmo tempo) ficam fixos.
+ *
+ *  O erro devolvido é relativo à maior dimensão da caixa envolvente da malha.
+ *  Com lockBorder as bordas abertas ficam fixas: é o que permite simplificar cada
+ *  material separadamente sem abrir frestas entre eles.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+
+const float SIMPLIFY_BORDER_WEIGHT = 10.0f;  // peso das quádricas de borda/costura
+
+struct Quadric
+{
+    double a00 = 0.0, a11 = 0.0, a22 = 0.0, a10 = 0.0, a20 = 0.0, a21 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0, c = 0.0;
+    double weight = 0.0;
+};
+
+enum SimplifyVertexKind : uint8_t
+{
+    SIMPLIFY_MANIFOLD,  // interior, sem costura: colapsa para qualquer vizinho
+    SIMPLIFY_BORDER,    // borda aberta: colapsa só ao longo da borda
+    SIMPLIFY_SEAM,      // costura com dois lados: colapsa só ao longo da costura
+    SIMPLIFY_LOCKED     // fixo
+};
+
+// Plano a*x + b*y + c*z + d = 0 com (a, b, c) unitário
+inline Quadric makePlaneQuadric(const glm::vec3 &normal, float d, double weight)
+{
+    Quadric q;
+    q.a00 = normal.x * normal.x * weight;
+    q.a11 = normal.y * normal.y * weight;
+    q.a22 = normal.z * normal.z * weight;
+    q.a10 = normal.y * normal.x * weight;
+    q.a20 = normal.z * normal.x * weight;
+    q.a21 = normal.z * normal.y * weight;
+    q.b0 = normal.x * d * weight;
+    q.b1 = normal.y * d * weight;
+    q.b2 = normal.z * d * weight;
+    q.c = (double)d * d * weight;
+    q.weight = weight;
+    return q;
+}
+
+inline void addQuadric(Quadric &q, const Quadric &r)
+{
+    q.a00 += r.a00;
+    q.a11 += r.a11;
+    q.a22 += r.a22;
+    q.a10 += r.a10;
+    q.a20 += r.a20;
+    q.a21 += r.a21;
+    q.b0 += r.b0;
+    q.b1 += r.b1;
+    q.b2 += r.b2;
+    q.c += r.c;
+    q.weight += r.weight;
+}
+
+// Distância quadrática média ponderada dos planos acumulados até p
+inline double evaluateQuadric(const Quadric &q, const glm::vec3 &p)
+{
+    double x = p.x, y = p.y, z = p.z;
+    double rx = q.a00 * x + q.a10 * y + q.a20 * z;
+    double ry = q.a10 * x + q.a11 * y + q.a21 * z;
+    double rz = q.a20 * x + q.a21 * y + q.a22 * z;
+    double r = rx * x + ry * y + rz * z + 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+    return q.weight > 0.0 ? std::fabs(r) / q.weight : 0.0;
+}
+
+// Associa cada vértice ao primeiro vértice com a mesma posição (tabela hash com endereçamento aberto)
+inline std::vector<uint32_t> buildPositionRemap(const Mesh &mesh)
+{
+    size_t tableSize = 16;
+    while (tableSize < mesh.vertices.size() * 2)
+        tableSize <<= 1;
+    std::vector<uint32_t> table(tableSize, 0);  // índice do vértice + 1; 0 = vazio
+    std::vector<uint32_t> remap(mesh.vertices.size());
+
+    for (uint32_t v = 0; v < (uint32_t)mesh.vertices.size(); v++)
+    {
+        uint32_t bits[3];
+        memcpy(bits, &mesh.vertices[v].position.x, sizeof(bits));
+        uint32_t h = bits[0] * 0x9E3779B1u ^ bits[1] * 0x85EBCA77u ^ bits[2] * 0xC2B2AE3Du;
+        h ^= h >> 15;
+
+        size_t slot = h & (tableSize - 1);
+        while (table[slot] != 0 && mesh.vertices[table[slot] - 1].position != mesh.vertices[v].position)
+            slot = (slot + 1) & (tableSize - 1);
+        if (table[slot] == 0)
+            table[slot] = v + 1;
+        remap[v] = table[slot] - 1;
+    }
+    return remap;
+}
+
+inline uint64_t simplifyEdgeKey(uint32_t a, uint32_t b)
+{
+    return ((uint64_t)a << 32) | b;
+}
+
+inline bool hasSimplifyEdge(const std::vector<uint64_t> &sortedEdges, uint32_t a, uint32_t b)
+{
+    return std::binary_search(sortedEdges.begin(), sortedEdges.end(), simplifyEdgeKey(a, b));
+}
+
+// Simplifica os índices [indices, indices + indexCount) da malha até targetIndexCount
+// índices ou até o erro passar de maxError. Devolve os novos índices; resultError
+// (opcional) recebe o maior erro aceito.
+inline std::vector<uint32_t> simplifyMesh(const Mesh &mesh, const uint32_t *indices, size_t indexCount,
+                                          size_t targetIndexCount, float maxError, float *resultError = nullptr,
+                                          bool lockBorder = false)
+{
+    const uint32_t none = ~0u;
+    const uint32_t multiple = ~0u - 1;
+    size_t vertexCount = mesh.vertices.size();
+    std::vector<uint32_t> result(indices, indices + indexCount);
+    if (resultError)
+        *resultError = 0.0f;
+    if (indexCount <= targetIndexCount || vertexCount == 0)
+        return result;
+
+    // Posições normalizadas pela maior dimensão, para o erro ser relativo
+    glm::vec3 extent = mesh.boundsMax - mesh.boundsMin;
+    float scale = std::max(extent.x, std::max(extent.y, extent.z));
+    scale = scale > 0.0f ? 1.0f / scale : 1.0f;
+    std::vector<glm::vec3> positions(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        positions[v] = (mesh.vertices[v].position - mesh.boundsMin) * scale;
+
+    std::vector<uint32_t> remap = buildPositionRemap(mesh);
+    std::vector<uint32_t> wedge(vertexCount);  // anel dos vértices com a mesma posição
+    std::vector<uint32_t> wedgeCount(vertexCount, 0);
+    for (uint32_t v = 0; v < (uint32_t)vertexCount; v++)
+        wedge[v] = v;
+    for (uint32_t v = 0; v < (uint32_t)vertexCount; v++)
+    {
+        wedgeCount[remap[v]]++;
+        if (remap[v] != v)
+        {
+            wedge[v] = wedge[remap[v]];
+            wedge[remap[v]] = v;
+        }
+    }
+
+    // Arestas abertas: sem a aresta oposta em algum triângulo. loop[a] = b para a
+    // aresta aberta a -> b e loopback[b] = a (multiple se houver mais de uma)
+    std::vector<uint64_t> edges, positionEdges;
+    edges.reserve(indexCount);
+    positionEdges.reserve(indexCount);
+    for (size_t i = 0; i < indexCount; i += 3)
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t a = result[i + k], b = result[i + (k + 1) % 3];
+            edges.push_back(simplifyEdgeKey(a, b));
+            positionEdges.push_back(simplifyEdgeKey(remap[a], remap[b]));
+        }
+    std::sort(edges.begin(), edges.end());
+    std::sort(positionEdges.begin(), positionEdges.end());
+
+    std::vector<uint32_t> loop(vertexCount, none), loopback(vertexCount, none);
+    for (size_t i = 0; i < indexCount; i += 3)
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t a = result[i + k], b = result[i + (k + 1) % 3];
+            if (hasSimplifyEdge(edges, b, a))
+                continue;
+            loop[a] = loop[a] == none ? b : multiple;
+            loopback[b] = loopback[b] == none ? a : multiple;
+        }
+
+    auto validLink = [&](uint32_t link) { return link != none && link != multiple; };
+    std::vector<uint8_t> kind(vertexCount, SIMPLIFY_LOCKED);
+    for (uint32_t v = 0; v < (uint32_t)vertexCount; v++)
+    {
+        if (remap[v] != v)
+            continue;
+        if (wedgeCount[v] == 1)
+        {
+            if (loop[v] == none && loopback[v] == none)
+                kind[v] = SIMPLIFY_MANIFOLD;
+            else if (validLink(loop[v]) && validLink(loopback[v]) &&
+                     !hasSimplifyEdge(positionEdges, remap[loop[v]], v) &&
+                     !hasSimplifyEdge(positionEdges, v, remap[loopback[v]]))
+                kind[v] = SIMPLIFY_BORDER;
+        }
+        else if (wedgeCount[v] == 2)
+        {
+            uint32_t w0 = v, w1 = wedge[v];
+            if (validLink(loop[w0]) && validLink(loopback[w0]) && validLink(loop[w1]) && validLink(loopback[w1]) &&
+                remap[loop[w0]] == remap[loopback[w1]] && remap[loopback[w0]] == remap[loop[w1]])
+                kind[v] = SIMPLIFY_SEAM;
+        }
+    }
+    for (uint32_t v = 0; v < (uint32_t)vertexCount; v++)
+    {
+        kind[v] = kind[remap[v]];
+        if (lockBorder && kind[v] == SIMPLIFY_BORDER)
+            kind[v] = SIMPLIFY_LOCKED;
+    }
+
+    // Quádricas dos triângulos (peso = área) e das arestas abertas
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < indexCount; i += 3)
+    {
+        uint32_t v[3] = {remap[result[i]], remap[result[i + 1]], remap[result[i + 2]]};
+        glm::vec3 normal = glm::cross(positions[v[1]] - positions[v[0]], positions[v[2]] - positions[v[0]]);
+        float length = glm::length(normal);
+        if (length == 0.0f)
+            continue;
+        normal /= length;
+        Quadric q = makePlaneQuadric(normal, -glm::dot(normal, positions[v[0]]), length * 0.5);
+        for (int k = 0; k < 3; k++)
+            addQuadric(quadrics[v[k]], q);
+
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t a = result[i + k], b = result[i + (k + 1) % 3];
+            if (hasSimplifyEdge(edges, b, a))
+                continue;
+            glm::vec3 edge = positions[remap[b]] - positions[remap[a]];
+            glm::vec3 edgeNormal = glm::cross(edge, normal);
+            float edgeLength = glm::length(edgeNormal);
+            if (edgeLength == 0.0f)
+                continue;
+            edgeNormal /= edgeLength;
+            Quadric border = makePlaneQuadric(edgeNormal, -glm::dot(edgeNormal, positions[remap[a]]),
+                                              glm::dot(edge, edge) * SIMPLIFY_BORDER_WEIGHT);
+            addQuadric(quadrics[remap[a]], border);
+            addQuadric(quadrics[remap[b]], border);
+        }
+    }
+
+    struct Collapse
+    {
+        uint32_t source, target;            // vértices (não posições) da aresta
+        uint32_t otherSource, otherTarget;  // segundo lado da costura, ou none
+        double cost;
+    };
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> fanOffsets, fan, collapseRemap(vertexCount);
+    std::vector<uint8_t> locked(vertexCount);
+    size_t triangleCount = indexCount / 3;
+    size_t targetTriangles = targetIndexCount / 3;
+    double maxCost = (double)maxError * maxError;
+    double acceptedCost = 0.0;
+
+    // Colapso de a para b é permitido pelo tipo dos vértices? Preenche o segundo lado nas costuras
+    auto makeCollapse = [&](uint32_t a, uint32_t b, Collapse &collapse) {
+        uint32_t ra = remap[a], rb = remap[b];
+        collapse = {a, b, none, none, 0.0};
+        switch (kind[ra])
+        {
+        case SIMPLIFY_MANIFOLD:
+            break;
+        case SIMPLIFY_BORDER:
+            if (kind[rb] != SIMPLIFY_BORDER || (loop[a] != b && loopback[a] != b))
+                return false;
+            break;
+        case SIMPLIFY_SEAM:
+        {
+            if (kind[rb] != SIMPLIFY_SEAM || (loop[a] != b && loopback[a] != b))
+                return false;
+            uint32_t other = wedge[a];
+            uint32_t otherTarget = loop[a] == b ? loopback[other] : loop[other];
+            if (!validLink(otherTarget) || remap[otherTarget] != rb)
+                return false;
+            collapse.otherSource = other;
+            collapse.otherTarget = otherTarget;
+            break;
+        }
+        default:
+            return false;
+        }
+        collapse.cost = evaluateQuadric(quadrics[ra], positions[rb]);
+        return collapse.cost <= maxCost;
+    };
+
+    while (triangleCount > targetTriangles)
+    {
+        // Leque de triângulos de cada posição
+        fanOffsets.assign(vertexCount + 1, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            fanOffsets[remap[result[i]] + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            fanOffsets[v + 1] += fanOffsets[v];
+        fan.resize(triangleCount * 3);
+        {
+            std::vector<uint32_t> fill(fanOffsets.begin(), fanOffsets.end() - 1);
+            for (size_t i = 0; i < triangleCount * 3; i++)
+                fan[fill[remap[result[i]]]++] = (uint32_t)(i / 3);
+        }
+
+        collapses.clear();
+        for (size_t i = 0; i < triangleCount * 3; i += 3)
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t a = result[i + k], b = result[i + (k + 1) % 3];
+                Collapse collapse;
+                if (makeCollapse(a, b, collapse))
+                    collapses.push_back(collapse);
+                if (makeCollapse(b, a, collapse))
+                    collapses.push_back(collapse);
+            }
+        if (collapses.empty())
+            break;
+
+        // Cada aresta aparece uma vez por triângulo vizinho: mantém um candidato por par de posições
+        auto positionPair = [&](const Collapse &x) {
+            return simplifyEdgeKey(remap[x.source], remap[x.target]);
+        };
+        std::sort(collapses.begin(), collapses.end(),
+                  [&](const Collapse &x, const Collapse &y) { return positionPair(x) < positionPair(y); });
+        collapses.erase(std::unique(collapses.begin(), collapses.end(),
+                                    [&](const Collapse &x, const Collapse &y) { return positionPair(x) == positionPair(y); }),
+                        collapses.end());
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse &x, const Collapse &y) { return x.cost < y.cost; });
+
+        // Cada colapso remove cerca de 2 triângulos; nesta rodada só entram os mais
+        // baratos, para que arestas bloqueadas tenham chance na próxima
+        size_t goal = std::max<size_t>(1, (triangleCount - targetTriangles) / 2);
+        double costLimit = collapses[std::min(collapses.size(), goal + goal / 2) - 1].cost;
+
+        for (uint32_t v = 0; v < (uint32_t)vertexCount; v++)
+            collapseRemap[v] = v;
+        std::fill(locked.begin(), locked.end(), 0);
+        size_t removed = 0;
+        size_t applied = 0;
+
+        for (const Collapse &collapse : collapses)
+        {
+            if (collapse.cost > costLimit || triangleCount - removed <= targetTriangles)
+                break;
+            uint32_t rs = remap[collapse.source], rt = remap[collapse.target];
+            if (locked[rs] || locked[rt])
+                continue;
+
+            // Rejeita colapsos que invertem algum triângulo do leque
+            bool flips = false;
+            size_t degenerate = 0;
+            for (uint32_t f = fanOffsets[rs]; f < fanOffsets[rs + 1] && !flips; f++)
+            {
+                const uint32_t *t = &result[fan[f] * 3];
+                uint32_t r[3] = {remap[t[0]], remap[t[1]], remap[t[2]]};
+                if (r[0] == rt || r[1] == rt || r[2] == rt)
+                {
+                    degenerate++;
+                    continue;
+                }
+                glm::vec3 p[3] = {positions[r[0]], positions[r[1]], positions[r[2]]};
+                glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                for (int k = 0; k < 3; k++)
+                    if (r[k] == rs)
+                        p[k] = positions[rt];
+                glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+                flips = glm::dot(before, after) <= 0.0f;
+            }
+            if (flips)
+                continue;
+
+            collapseRemap[collapse.source] = collapse.target;
+            if (collapse.otherSource != none)
+                collapseRemap[collapse.otherSource] = collapse.otherTarget;
+            for (uint32_t f = fanOffsets[rs]; f < fanOffsets[rs + 1]; f++)
+                for (int k = 0; k < 3; k++)
+                    locked[remap[result[fan[f] * 3 + k]]] = 1;
+            addQuadric(quadrics[rt], quadrics[rs]);
+            acceptedCost = std::max(acceptedCost, collapse.cost);
+            removed += degenerate;
+            applied++;
+        }
+        if (applied == 0)
+            break;
+
+        // Aplica os colapsos e descarta os triângulos que ficaram degenerados
+        size_t write = 0;
+        for (size_t i = 0; i < triangleCount * 3; i += 3)
+        {
+            uint32_t a = collapseRemap[result[i]], b = collapseRemap[result[i + 1]], c = collapseRemap[result[i + 2]];
+            if (remap[a] == remap[b] || remap[b] == remap[c] || remap[c] == remap[a])
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        triangleCount = write / 3;
+        result.resize(write);
+
+        // As bordas e costuras seguem pelos vértices que sobraram
+        for (std::vector<uint32_t> *links : {&loop, &loopback})
+            for (uint32_t v = 0; v < (uint32_t)vertexCount; v++)
+            {
+                uint32_t link = (*links)[v];
+                if (!validLink(link))
+                    continue;
+                uint32_t target = collapseRemap[link];
+                (*links)[v] = target != v ? target : (*links)[link];
+            }
+    }
+
+    if (resultError)
+        *resultError = (float)std::sqrt(acceptedCost);
+    return result;
+}
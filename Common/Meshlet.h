@@ -0,0 +1,330 @@
+/*
+ *  Meshlet.h
+ *
+ *  Divide a malha indexada em meshlets (grupos de até MESHLET_MAX_VERTICES
+ *  vértices e MESHLET_MAX_TRIANGLES triângulos) que ocupam faixas contíguas do
+ *  buffer de índices. Cada meshlet guarda uma esfera envolvente e um cone com as
+ *  normais dos seus triângulos, o que permite descartar grupos inteiros na CPU:
+ *
+ *  - frustum: a esfera está totalmente fora de um dos 6 planos da câmera;
+ *  - cone: todos os triângulos do grupo estão de costas para a câmera.
+ *
+ *  Os grupos que sobrevivem são desenhados com um único glMultiDrawElements.
+ *  Um meshlet nunca mistura materiais: os grupos são formados dentro da faixa de
+ *  cada MeshSubset, e a lista visível guarda o subset de cada faixa.
+ *  Os testes são feitos no espaço do objeto (planos extraídos de
+ *  projection * view * model e câmera levada pela inversa de model), então
+ *  escalas não uniformes no model não invalidam as esferas nem os cones.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  buildMeshlets(mesh);                     // depois de optimizeMesh
+ *  GPUMesh gpu = uploadMesh(mesh);          // gpu.meshlets é copiado da malha
+ *  ...
+ *  MeshletDrawList drawList;
+ *  cullMeshlets(gpu, projection * view, model, camera.position, drawList);
+ *  drawMeshlets(gpu, drawList);
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+
+const uint32_t MESHLET_MAX_VERTICES = 64;
+const uint32_t MESHLET_MAX_TRIANGLES = 124;
+const float MESHLET_CONE_MIN_DOT = 0.1f;  // abaixo disso o cone é aberto demais para descartar algo
+
+struct MeshletDrawList
+{
+    std::vector<GLsizei> counts;
+    std::vector<const void *> offsets;
+    std::vector<uint32_t> subsets;  // MeshSubset de cada faixa
+    size_t visibleTriangles = 0;
+    size_t totalTriangles = 0;
+};
+
+// Esfera (centro da caixa envolvente) e cone de normais dos triângulos de um meshlet
+inline void computeMeshletBounds(const Mesh &mesh, Meshlet &meshlet)
+{
+    const uint32_t *indices = mesh.indices.data() + meshlet.indexOffset;
+
+    glm::vec3 boundsMin = mesh.vertices[indices[0]].position;
+    glm::vec3 boundsMax = boundsMin;
+    for (uint32_t i = 0; i < meshlet.indexCount; i++)
+    {
+        boundsMin = glm::min(boundsMin, mesh.vertices[indices[i]].position);
+        boundsMax = glm::max(boundsMax, mesh.vertices[indices[i]].position);
+    }
+    meshlet.center = (boundsMin + boundsMax) * 0.5f;
+    meshlet.radius = 0.0f;
+    for (uint32_t i = 0; i < meshlet.indexCount; i++)
+        meshlet.radius = std::max(meshlet.radius, glm::length(mesh.vertices[indices[i]].position - meshlet.center));
+
+    // Normais geométricas (não as do .OBJ, que podem estar suavizadas ou ausentes)
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet.indexCount / 3);
+    glm::vec3 axis(0.0f);
+    for (uint32_t i = 0; i < meshlet.indexCount; i += 3)
+    {
+        const glm::vec3 &a = mesh.vertices[indices[i]].position;
+        const glm::vec3 &b = mesh.vertices[indices[i + 1]].position;
+        const glm::vec3 &c = mesh.vertices[indices[i + 2]].position;
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        if (length == 0.0f)
+            continue;
+        normals.push_back(normal / length);
+        axis += normals.back();
+    }
+
+    meshlet.coneAxis = glm::vec3(0.0f);
+    meshlet.coneCutoff = 1.0f;
+    float axisLength = glm::length(axis);
+    if (normals.empty() || axisLength == 0.0f)
+        return;
+    axis /= axisLength;
+
+    float minDot = 1.0f;
+    for (const glm::vec3 &normal : normals)
+        minDot = std::min(minDot, glm::dot(normal, axis));
+    if (minDot <= MESHLET_CONE_MIN_DOT)
+        return;
+
+    // Seno do ângulo de abertura: o grupo está de costas se a direção da câmera
+    // fica fora do cone complementar (teste em isMeshletVisible)
+    meshlet.coneAxis = axis;
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+// Agrupa triângulos vizinhos: a partir de um triângulo semente, acrescenta sempre o
+// triângulo adjacente que traz menos vértices novos (empate: mais perto do centro do
+// grupo). O buffer de índices é reescrito na ordem dos meshlets, material por material.
+inline void buildMeshlets(Mesh &mesh, uint32_t maxVertices = MESHLET_MAX_VERTICES,
+                          uint32_t maxTriangles = MESHLET_MAX_TRIANGLES)
+{
+    mesh.meshlets.clear();
+    size_t triangleCount = mesh.indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Adjacência vértice -> triângulos (formato CSR)
+    std::vector<uint32_t> adjacencyOffsets(mesh.vertices.size() + 1, 0);
+    for (uint32_t index : mesh.indices)
+        adjacencyOffsets[index + 1]++;
+    for (size_t v = 0; v < mesh.vertices.size(); v++)
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    std::vector<uint32_t> adjacency(mesh.indices.size());
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < mesh.indices.size(); i++)
+            adjacency[fill[mesh.indices[i]]++] = (uint32_t)(i / 3);
+    }
+
+    std::vector<MeshSubset> subsets = mesh.subsets;
+    if (subsets.empty())
+        subsets.push_back({0, (uint32_t)mesh.indices.size(), 0, 0});
+
+    // Triângulos fora do material atual contam como emitidos e nunca entram no grupo
+    const uint32_t none = ~0u;
+    std::vector<uint8_t> emitted(triangleCount, 1);
+    std::vector<uint32_t> vertexMeshlet(mesh.vertices.size(), none);  // último meshlet que usou o vértice
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint32_t> output;
+    output.reserve(mesh.indices.size());
+
+    auto newVertices = [&](uint32_t triangle, uint32_t meshletIndex) {
+        uint32_t count = 0;
+        for (int k = 0; k < 3; k++)
+            count += vertexMeshlet[mesh.indices[triangle * 3 + k]] != meshletIndex;
+        return count;
+    };
+    auto centroid = [&](uint32_t triangle) {
+        const uint32_t *t = &mesh.indices[triangle * 3];
+        return (mesh.vertices[t[0]].position + mesh.vertices[t[1]].position + mesh.vertices[t[2]].position) / 3.0f;
+    };
+
+    for (uint32_t subsetIndex = 0; subsetIndex < (uint32_t)subsets.size(); subsetIndex++)
+    {
+        const MeshSubset &subset = subsets[subsetIndex];
+        size_t seed = subset.indexOffset / 3;
+        size_t seedEnd = seed + subset.indexCount / 3;
+        std::fill(emitted.begin() + seed, emitted.begin() + seedEnd, 0);
+        while (true)
+        {
+            while (seed < seedEnd && emitted[seed])
+                seed++;
+            if (seed == seedEnd)
+                break;
+
+            uint32_t meshletIndex = (uint32_t)mesh.meshlets.size();
+            Meshlet meshlet{};
+            meshlet.indexOffset = (uint32_t)output.size();
+            meshlet.subset = subsetIndex;
+            meshletVertices.clear();
+            glm::vec3 centerSum(0.0f);
+            uint32_t triangles = 0;
+
+            uint32_t triangle = (uint32_t)seed;
+            while (triangle != none)
+            {
+                emitted[triangle] = 1;
+                for (int k = 0; k < 3; k++)
+                {
+                    uint32_t vertex = mesh.indices[triangle * 3 + k];
+                    output.push_back(vertex);
+                    if (vertexMeshlet[vertex] != meshletIndex)
+                    {
+                        vertexMeshlet[vertex] = meshletIndex;
+                        meshletVertices.push_back(vertex);
+                    }
+                }
+                centerSum += centroid(triangle);
+                triangles++;
+                if (triangles == maxTriangles)
+                    break;
+
+                glm::vec3 center = centerSum / (float)triangles;
+                uint32_t best = none;
+                uint32_t bestNew = 4;
+                float bestDistance = 0.0f;
+                for (uint32_t vertex : meshletVertices)
+                {
+                    for (uint32_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++)
+                    {
+                        uint32_t candidate = adjacency[a];
+                        if (emitted[candidate])
+                            continue;
+                        uint32_t added = newVertices(candidate, meshletIndex);
+                        if (meshletVertices.size() + added > maxVertices || added > bestNew)
+                            continue;
+                        float distance = glm::length(centroid(candidate) - center);
+                        if (added < bestNew || distance < bestDistance)
+                        {
+                            best = candidate;
+                            bestNew = added;
+                            bestDistance = distance;
+                        }
+                    }
+                }
+
+                // Sem vizinho que caiba: tenta a próxima semente, se couber no grupo
+                if (best == none)
+                {
+                    while (seed < seedEnd && emitted[seed])
+                        seed++;
+                    if (seed < seedEnd && meshletVertices.size() + newVertices((uint32_t)seed, meshletIndex) <= maxVertices)
+                        best = (uint32_t)seed;
+                }
+                triangle = best;
+            }
+
+            meshlet.indexCount = triangles * 3;
+            mesh.meshlets.push_back(meshlet);
+        }
+    }
+
+    mesh.indices.swap(output);
+    optimizeVertexFetch(mesh);
+    for (Meshlet &meshlet : mesh.meshlets)
+        computeMeshletBounds(mesh, meshlet);
+
+    VertexCacheStats stats = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    std::cout << "Meshlets: " << mesh.meshlets.size() << " grupos, media de "
+              << (float)triangleCount / mesh.meshlets.size() << " triangulos, ACMR " << stats.acmr << std::endl;
+}
+
+// Planos do frustum de uma matriz de projeção (Gribb/Hartmann), normalizados.
+// Com projection * view * model os planos ficam no espaço do objeto.
+inline void extractFrustumPlanes(const glm::mat4 &matrix, glm::vec4 planes[6])
+{
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+
+    for (int i = 0; i < 3; i++)
+    {
+        planes[i * 2] = rows[3] + rows[i];
+        planes[i * 2 + 1] = rows[3] - rows[i];
+    }
+    for (int i = 0; i < 6; i++)
+        planes[i] = planes[i] / glm::length(glm::vec3(planes[i]));
+}
+
+inline bool isMeshletVisible(const Meshlet &meshlet, const glm::vec4 planes[6], const glm::vec3 &cameraPosition,
+                             bool coneCulling)
+{
+    for (int i = 0; i < 6; i++)
+        if (glm::dot(glm::vec3(planes[i]), meshlet.center) + planes[i].w < -meshlet.radius)
+            return false;
+
+    if (coneCulling)
+    {
+        glm::vec3 toCenter = meshlet.center - cameraPosition;
+        if (glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius)
+            return false;
+    }
+    return true;
+}
+
+// Monta a lista de faixas de índices visíveis. O teste de cone supõe que as faces
+// de trás não precisam aparecer (malha fechada ou GL_CULL_FACE)
+inline void cullMeshlets(const GPUMesh &mesh, const glm::mat4 &viewProjection, const glm::mat4 &model,
+                         const glm::vec3 &cameraPosition, MeshletDrawList &drawList, bool coneCulling = true)
+{
+    drawList.counts.clear();
+    drawList.offsets.clear();
+    drawList.subsets.clear();
+    drawList.visibleTriangles = 0;
+    drawList.totalTriangles = mesh.indexCount / 3;
+
+    glm::vec4 planes[6];
+    extractFrustumPlanes(viewProjection * model, planes);
+    glm::vec3 cameraObject = glm::vec3(glm::inverse(model) * glm::vec4(cameraPosition, 1.0f));
+    size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+
+    for (const Meshlet &meshlet : mesh.meshlets)
+    {
+        if (!isMeshletVisible(meshlet, planes, cameraObject, coneCulling))
+            continue;
+
+        // Meshlets vizinhos visíveis do mesmo material viram uma única faixa
+        const void *offset = (const void *)(uintptr_t)(meshlet.indexOffset * indexSize);
+        if (!drawList.counts.empty() && drawList.subsets.back() == meshlet.subset &&
+            (uintptr_t)drawList.offsets.back() + drawList.counts.back() * indexSize == (uintptr_t)offset)
+            drawList.counts.back() += meshlet.indexCount;
+        else
+        {
+            drawList.counts.push_back(meshlet.indexCount);
+            drawList.offsets.push_back(offset);
+            drawList.subsets.push_back(meshlet.subset);
+        }
+        drawList.visibleTriangles += meshlet.indexCount / 3;
+    }
+}
+
+inline void drawMeshlets(const GPUMesh &mesh, const MeshletDrawList &drawList)
+{
+    if (mesh.meshlets.empty())
+    {
+        drawMesh(mesh);
+        return;
+    }
+    if (drawList.counts.empty())
+        return;
+
+    glBindVertexArray(mesh.VAO);
+    glMultiDrawElements(GL_TRIANGLES, drawList.counts.data(), mesh.indexType, drawList.offsets.data(),
+                        (GLsizei)drawList.counts.size());
+    glBindVertexArray(0);
+}
@@ -0,0 +1,403 @@
+/*
+ *  Mipmap.h
+ *
+ *  Cadeia de mipmaps gerada na CPU, no lugar de glGenerateMipmap (cujo filtro e
+ *  velocidade dependem do driver). Cada nível sai do anterior por um filtro
+ *  separável: primeiro as linhas de origem são combinadas na vertical (laço
+ *  vetorizado com AVX ou SSE sobre a linha inteira), depois a linha resultante é
+ *  reduzida na horizontal (um texel RGBA por registrador SSE). As linhas de
+ *  saída são divididas entre threads.
+ *
+ *  MIP_BOX     média simples da área coberta (2x2 texels, 3 em lados ímpares)
+ *  MIP_KAISER  sinc com janela de Kaiser (raio de 3 texels do nível de saída):
+ *              mantém a nitidez dos níveis pequenos sem serrilhado
+ *
+ *  Com srgb, os canais de cor são convertidos para luz linear antes do filtro e
+ *  voltam para sRGB no fim, então as médias não escurecem a imagem; o alfa é
+ *  sempre linear. Os níveis são filtrados em float a partir do nível anterior
+ *  também em float, sem acumular o arredondamento de 8 bits.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  MipSettings settings;  // Kaiser, sRGB
+ *  std::vector<unsigned char> chain = buildMipChain(pixels, width, height, channels, settings);
+ *  // chain: níveis 1 até 1x1, um depois do outro (mipLevelWidth/mipLevelHeight dão as dimensões)
+ *  std::vector<unsigned char> layer = resizeImage(pixels, width, height, channels, 512, 512, settings);
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MIPMAP_AVX 1
+#endif
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define MIPMAP_SSE 1
+#endif
+
+const float MIP_KAISER_RADIUS = 3.0f;  // em texels do nível de saída
+const float MIP_KAISER_ALPHA = 4.0f;
+const size_t MIPMAP_MIN_ROWS = 32;     // linhas de saída mínimas por thread
+
+enum MipFilter
+{
+    MIP_BOX,
+    MIP_KAISER
+};
+
+struct MipSettings
+{
+    MipFilter filter = MIP_KAISER;
+    bool srgb = true;  // cores em sRGB (fotos, texturas de cor); false para dados (normais, máscaras)
+};
+
+// Pesos de um eixo: taps entradas (índice de origem, peso) por texel de saída
+struct MipTaps
+{
+    int taps = 0;
+    std::vector<int> index;
+    std::vector<float> weight;
+};
+
+inline int mipLevelWidth(int width, int level)
+{
+    return std::max(1, width >> level);
+}
+
+inline int mipLevelHeight(int height, int level)
+{
+    return std::max(1, height >> level);
+}
+
+// Níveis até 1x1, contando o nível 0
+inline int mipLevelCount(int width, int height)
+{
+    int levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        levels++;
+    }
+    return levels;
+}
+
+// Bytes de todos os níveis juntos, do nível 0 ao 1x1
+inline size_t mipChainBytes(int width, int height, int channels)
+{
+    size_t bytes = 0;
+    for (int level = 0; level < mipLevelCount(width, height); level++)
+        bytes += (size_t)mipLevelWidth(width, level) * mipLevelHeight(height, level) * channels;
+    return bytes;
+}
+
+// Parte das opções que muda os pixels gerados (vai na chave do cache)
+inline std::string mipSettingsKey(const MipSettings &settings)
+{
+    return std::string(settings.filter == MIP_BOX ? "box" : "kaiser") + (settings.srgb ? " srgb" : " linear");
+}
+
+// Bessel modificada de ordem 0 (série de potências)
+inline double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12)
+            break;
+    }
+    return sum;
+}
+
+inline float kaiserWeight(float t)
+{
+    if (std::fabs(t) >= MIP_KAISER_RADIUS)
+        return 0.0f;
+    const double pi = 3.14159265358979323846;
+    double sinc = t == 0.0f ? 1.0 : std::sin(pi * t) / (pi * t);
+    double ratio = t / MIP_KAISER_RADIUS;
+    return (float)(sinc * besselI0(MIP_KAISER_ALPHA * std::sqrt(1.0 - ratio * ratio)) / besselI0(MIP_KAISER_ALPHA));
+}
+
+// Pesos normalizados para levar source texels a target; fora da imagem repete a borda.
+// Só os pesos diferentes de zero entram (2 taps no filtro de caixa com redução exata de 2x).
+// Na ampliação (target > source) o Kaiser fica com raio de 3 texels de origem
+inline MipTaps mipTaps(int source, int target, MipFilter filter)
+{
+    float scale = (float)source / target, support = std::max(scale, 1.0f);
+    float radius = filter == MIP_BOX ? scale * 0.5f : MIP_KAISER_RADIUS * support;
+    std::vector<std::vector<std::pair<int, float>>> perTexel(target);
+    MipTaps taps;
+    for (int x = 0; x < target; x++)
+    {
+        float center = (x + 0.5f) * scale, sum = 0.0f;
+        for (int i = (int)std::floor(center - radius); i <= (int)std::ceil(center + radius); i++)
+        {
+            float weight;
+            if (filter == MIP_BOX)
+            {
+                // Quanto do texel [i, i + 1] cai dentro de [x * scale, (x + 1) * scale]
+                float overlap = std::min(i + 1.0f, (x + 1) * scale) - std::max((float)i, x * scale);
+                weight = std::max(0.0f, overlap);
+            }
+            else
+                weight = kaiserWeight((i + 0.5f - center) / support);
+            if (weight == 0.0f)
+                continue;
+            perTexel[x].push_back({std::clamp(i, 0, source - 1), weight});
+            sum += weight;
+        }
+        for (auto &tap : perTexel[x])
+            tap.second /= sum;
+        taps.taps = std::max(taps.taps, (int)perTexel[x].size());
+    }
+
+    // Texels com menos taps completam com peso zero no último índice
+    taps.index.resize((size_t)target * taps.taps);
+    taps.weight.resize((size_t)target * taps.taps);
+    for (int x = 0; x < target; x++)
+        for (int t = 0; t < taps.taps; t++)
+        {
+            bool real = t < (int)perTexel[x].size();
+            taps.index[(size_t)x * taps.taps + t] = real ? perTexel[x][t].first : perTexel[x].back().first;
+            taps.weight[(size_t)x * taps.taps + t] = real ? perTexel[x][t].second : 0.0f;
+        }
+    return taps;
+}
+
+inline const float *srgbToLinearTable()
+{
+    static const std::vector<float> table = []()
+    {
+        std::vector<float> values(256);
+        for (int i = 0; i < 256; i++)
+        {
+            float c = i / 255.0f;
+            values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+// Limites em luz linear entre bytes sRGB vizinhos: threshold[k] é o valor linear de (k + 0.5) / 255
+inline const float *linearToSRGBThresholds()
+{
+    static const std::vector<float> table = []()
+    {
+        std::vector<float> values(255);
+        for (int k = 0; k < 255; k++)
+        {
+            float c = (k + 0.5f) / 255.0f;
+            values[k] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+// Byte sRGB mais próximo (busca binária nos limites, sem pow por texel)
+inline unsigned char linearToSRGB8(float linear)
+{
+    const float *thresholds = linearToSRGBThresholds();
+    return (unsigned char)(std::upper_bound(thresholds, thresholds + 255, linear) - thresholds);
+}
+
+inline unsigned char unorm8(float value)
+{
+    return (unsigned char)std::clamp((int)(value * 255.0f + 0.5f), 0, 255);
+}
+
+// Índice do canal de alfa (-1 se não há)
+inline int mipAlphaChannel(int channels)
+{
+    return channels == 4 ? 3 : channels == 2 ? 1 : -1;
+}
+
+// Divide as linhas [0, count) em faixas contíguas, uma por thread
+template <typename Function>
+void mipParallelFor(size_t count, Function function)
+{
+    unsigned threads = (unsigned)std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                  std::max<size_t>(1, count / MIPMAP_MIN_ROWS));
+    if (threads <= 1)
+    {
+        function((size_t)0, count);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; i++)
+        workers.emplace_back(function, count * i / threads, count * (i + 1) / threads);
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+// out[j] = soma de weights[t] * rows[t][j] para j em [0, count)
+inline void mipVerticalPass(const float *const *rows, const float *weights, int taps, float *out, size_t count)
+{
+    size_t j = 0;
+#ifdef MIPMAP_AVX
+    for (; j + 8 <= count; j += 8)
+    {
+        __m256 sum = _mm256_setzero_ps();
+        for (int t = 0; t < taps; t++)
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[t]), _mm256_loadu_ps(rows[t] + j)));
+        _mm256_storeu_ps(out + j, sum);
+    }
+#endif
+#ifdef MIPMAP_SSE
+    for (; j + 4 <= count; j += 4)
+    {
+        __m128 sum = _mm_setzero_ps();
+        for (int t = 0; t < taps; t++)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(rows[t] + j)));
+        _mm_storeu_ps(out + j, sum);
+    }
+#endif
+    for (; j < count; j++)
+    {
+        float sum = 0.0f;
+        for (int t = 0; t < taps; t++)
+            sum += weights[t] * rows[t][j];
+        out[j] = sum;
+    }
+}
+
+// Reduz uma linha (já filtrada na vertical) para width texels; o resultado fica em [0, 1]
+inline void mipHorizontalPass(const float *row, const MipTaps &taps, int width, int channels, float *out)
+{
+    for (int x = 0; x < width; x++)
+    {
+        const int *index = &taps.index[(size_t)x * taps.taps];
+        const float *weight = &taps.weight[(size_t)x * taps.taps];
+#ifdef MIPMAP_SSE
+        if (channels == 4)
+        {
+            __m128 sum = _mm_setzero_ps();
+            for (int t = 0; t < taps.taps; t++)
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[t]), _mm_loadu_ps(row + (size_t)index[t] * 4)));
+            sum = _mm_min_ps(_mm_max_ps(sum, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+            _mm_storeu_ps(out + (size_t)x * 4, sum);
+            continue;
+        }
+#endif
+        for (int c = 0; c < channels; c++)
+        {
+            float sum = 0.0f;
+            for (int t = 0; t < taps.taps; t++)
+                sum += weight[t] * row[(size_t)index[t] * channels + c];
+            out[(size_t)x * channels + c] = std::clamp(sum, 0.0f, 1.0f);
+        }
+    }
+}
+
+// Imagem em float levada de width x height para outWidth x outHeight
+inline std::vector<float> resampleMipLevel(const std::vector<float> &source, int width, int height, int channels,
+                                           int outWidth, int outHeight, MipFilter filter)
+{
+    MipTaps horizontal = mipTaps(width, outWidth, filter), vertical = mipTaps(height, outHeight, filter);
+    size_t rowFloats = (size_t)width * channels;
+    std::vector<float> out((size_t)outWidth * outHeight * channels);
+    mipParallelFor((size_t)outHeight, [&](size_t begin, size_t end)
+    {
+        std::vector<float> row(rowFloats);
+        std::vector<const float *> rows(vertical.taps);
+        for (size_t y = begin; y < end; y++)
+        {
+            for (int t = 0; t < vertical.taps; t++)
+                rows[t] = &source[(size_t)vertical.index[y * vertical.taps + t] * rowFloats];
+            mipVerticalPass(rows.data(), &vertical.weight[y * vertical.taps], vertical.taps, row.data(), rowFloats);
+            mipHorizontalPass(row.data(), horizontal, outWidth, channels, &out[y * outWidth * channels]);
+        }
+    });
+    return out;
+}
+
+// Um nível em float a partir do anterior (width x height -> metade, mínimo 1)
+inline std::vector<float> downsampleMipLevel(const std::vector<float> &source, int width, int height, int channels,
+                                             MipFilter filter)
+{
+    return resampleMipLevel(source, width, height, channels, std::max(1, width / 2), std::max(1, height / 2), filter);
+}
+
+// Canais filtrados em luz linear: a cor com settings.srgb; alfa e dados nunca
+inline void mipSRGBChannels(int channels, const MipSettings &settings, bool srgb[4])
+{
+    int alpha = mipAlphaChannel(channels);
+    for (int c = 0; c < channels; c++)
+        srgb[c] = settings.srgb && c != alpha;
+}
+
+// Pixels de 8 bits para float em [0, 1] (cor em sRGB passa pela curva por tabela)
+inline std::vector<float> mipToFloat(const unsigned char *pixels, size_t count, int channels,
+                                     const MipSettings &settings)
+{
+    bool srgb[4];
+    mipSRGBChannels(channels, settings, srgb);
+    const float *toLinear = srgbToLinearTable();
+    float toUnorm[256];
+    for (int i = 0; i < 256; i++)
+        toUnorm[i] = i / 255.0f;
+
+    const float *tables[4];
+    for (int c = 0; c < channels; c++)
+        tables[c] = srgb[c] ? toLinear : toUnorm;
+
+    std::vector<float> level(count);
+    for (size_t i = 0; i < count; i += channels)
+        for (int c = 0; c < channels; c++)
+            level[i + c] = tables[c][pixels[i + c]];
+    return level;
+}
+
+inline void mipToBytes(const std::vector<float> &level, int channels, const MipSettings &settings,
+                       unsigned char *out)
+{
+    bool srgb[4];
+    mipSRGBChannels(channels, settings, srgb);
+    for (size_t i = 0; i < level.size(); i += channels)
+        for (int c = 0; c < channels; c++)
+            out[i + c] = srgb[c] ? linearToSRGB8(level[i + c]) : unorm8(level[i + c]);
+}
+
+// Níveis 1 até 1x1 de uma imagem de 8 bits por canal, um depois do outro
+inline std::vector<unsigned char> buildMipChain(const unsigned char *pixels, int width, int height, int channels,
+                                                const MipSettings &settings = MipSettings())
+{
+    size_t count = (size_t)width * height * channels;
+    std::vector<float> level = mipToFloat(pixels, count, channels, settings);
+    std::vector<unsigned char> chain(mipChainBytes(width, height, channels) - count);
+    unsigned char *out = chain.data();
+    while (width > 1 || height > 1)
+    {
+        level = downsampleMipLevel(level, width, height, channels, settings.filter);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        mipToBytes(level, channels, settings, out);
+        out += level.size();
+    }
+    return chain;
+}
+
+// A imagem inteira levada para outWidth x outHeight com o mesmo filtro dos mipmaps
+// (redução ou ampliação, cada eixo com sua escala)
+inline std::vector<unsigned char> resizeImage(const unsigned char *pixels, int width, int height, int channels,
+                                              int outWidth, int outHeight, const MipSettings &settings = MipSettings())
+{
+    std::vector<float> level = mipToFloat(pixels, (size_t)width * height * channels, channels, settings);
+    level = resampleMipLevel(level, width, height, channels, outWidth, outHeight, settings.filter);
+    std::vector<unsigned char> out(level.size());
+    mipToBytes(level, channels, settings, out.data());
+    return out;
+}
@@ -0,0 +1,578 @@
+/*
+ *  ObjLoader.h
+ *
+ *  Leitor de arquivos Wavefront .OBJ compartilhado pelos exercícios.
+ *
+ *  O arquivo é mapeado em memória (MappedFile) e interpretado no próprio buffer
+ *  mapeado com std::from_chars: não há istringstream por linha nem std::string
+ *  por token, e a única alocação de memória é o crescimento dos vetores de saída.
+ *
+ *  Arquivos grandes são divididos em blocos terminados em '\n' e interpretados em
+ *  paralelo (parseOBJParallel); os vetores de cada bloco são depois concatenados
+ *  usando somas de prefixo dos tamanhos.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  ObjData obj;
+ *  if (loadOBJ("../assets/Modelos3D/Suzanne.obj", obj))
+ *  {
+ *      forEachTriangle(obj, [&](const ObjCorner &a, const ObjCorner &b, const ObjCorner &c) {
+ *          ...
+ *      });
+ *  }
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MappedFile.h"
+
+// Índices (base 0) de um canto de face; -1 quando o atributo não foi informado
+struct ObjCorner
+{
+    int v = -1;
+    int vt = -1;
+    int vn = -1;
+};
+
+// A partir da face firstFace, as faces usam materialNames[material] (registro usemtl)
+struct ObjMaterialGroup
+{
+    uint32_t firstFace;
+    uint32_t material;
+};
+
+struct ObjData
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjCorner> corners;   // cantos de todas as faces, em sequência
+    std::vector<uint32_t> faceSizes;  // número de cantos de cada face
+
+    std::vector<std::string> materialLibraries;  // arquivos dos registros mtllib
+    std::vector<std::string> materialNames;      // nomes distintos dos registros usemtl
+    std::vector<ObjMaterialGroup> materialGroups;  // vazio: nenhuma face tem material
+
+    void clear()
+    {
+        positions.clear();
+        texCoords.clear();
+        normals.clear();
+        corners.clear();
+        faceSizes.clear();
+        materialLibraries.clear();
+        materialNames.clear();
+        materialGroups.clear();
+    }
+};
+
+// Canto de face com índice negativo (relativo), interpretado dentro de um bloco
+struct ObjRelativeCorner
+{
+    uint32_t corner;
+    uint8_t attributes;  // bit 0: v, bit 1: vt, bit 2: vn
+};
+
+struct ObjLoadStats
+{
+    size_t bytes = 0;
+    double seconds = 0.0;
+    unsigned threads = 1;
+
+    double megabytesPerSecond() const
+    {
+        return seconds > 0.0 ? (bytes / (1024.0 * 1024.0)) / seconds : 0.0;
+    }
+};
+
+inline bool objIsSpace(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+inline const char *objSkipSpaces(const char *p, const char *end)
+{
+    while (p < end && objIsSpace(*p))
+        ++p;
+    return p;
+}
+
+inline const char *objSkipLine(const char *p, const char *end)
+{
+    const char *newline = (const char *)memchr(p, '\n', end - p);
+    return newline ? newline + 1 : end;
+}
+
+inline const char *objParseFloat(const char *p, const char *end, float &value)
+{
+    p = objSkipSpaces(p, end);
+    if (p < end && *p == '+')
+        ++p;
+#if defined(__cpp_lib_to_chars)
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec == std::errc::invalid_argument)
+    {
+        value = 0.0f;
+        return p;
+    }
+    if (result.ec == std::errc::result_out_of_range)
+        value = 0.0f;
+    return result.ptr;
+#else
+    // Bibliotecas sem from_chars para float: copia o token para a pilha
+    char token[64];
+    size_t n = 0;
+    while (p < end && n < sizeof(token) - 1 && !objIsSpace(*p) && *p != '\r' && *p != '\n')
+        token[n++] = *p++;
+    token[n] = '\0';
+    value = strtof(token, nullptr);
+    return p;
+#endif
+}
+
+// Converte um índice do .OBJ (base 1, ou negativo e relativo ao fim da lista) para base 0
+inline int objResolveIndex(long index, size_t count)
+{
+    if (index > 0)
+        return (int)(index - 1);
+    if (index < 0)
+        return (int)((long)count + index);
+    return -1;
+}
+
+inline const char *objParseIndex(const char *p, const char *end, size_t count, int &index, bool &relative)
+{
+    long value = 0;
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc())
+        return p;
+    index = objResolveIndex(value, count);
+    relative = value < 0;
+    return result.ptr;
+}
+
+// Formatos aceitos: v, v/vt, v//vn e v/vt/vn
+inline const char *objParseCorner(const char *p, const char *end, const ObjData &obj, ObjCorner &corner,
+                                  uint8_t &relativeAttributes)
+{
+    bool relative = false;
+    relativeAttributes = 0;
+
+    p = objParseIndex(p, end, obj.positions.size(), corner.v, relative);
+    relativeAttributes |= relative ? 1 : 0;
+    if (p < end && *p == '/')
+    {
+        ++p;
+        if (p < end && *p != '/')
+        {
+            relative = false;
+            p = objParseIndex(p, end, obj.texCoords.size(), corner.vt, relative);
+            relativeAttributes |= relative ? 2 : 0;
+        }
+        if (p < end && *p == '/')
+        {
+            ++p;
+            relative = false;
+            p = objParseIndex(p, end, obj.normals.size(), corner.vn, relative);
+            relativeAttributes |= relative ? 4 : 0;
+        }
+    }
+    return p;
+}
+
+// Resto da linha sem espaços nas pontas (nome de material ou de arquivo)
+inline const char *objParseName(const char *p, const char *end, std::string &name)
+{
+    p = objSkipSpaces(p, end);
+    const char *last = std::find(p, end, '\n');
+    while (last > p && (objIsSpace(last[-1]) || last[-1] == '\r'))
+        --last;
+    name.assign(p, last);
+    return last;
+}
+
+inline uint32_t objFindMaterial(ObjData &obj, const std::string &name)
+{
+    for (size_t i = 0; i < obj.materialNames.size(); i++)
+        if (obj.materialNames[i] == name)
+            return (uint32_t)i;
+    obj.materialNames.push_back(name);
+    return (uint32_t)obj.materialNames.size() - 1;
+}
+
+inline bool objIsKeyword(const char *p, const char *end, const char *keyword, size_t length)
+{
+    return (size_t)(end - p) > length && memcmp(p, keyword, length) == 0 && objIsSpace(p[length]);
+}
+
+// Interpreta os registros v/vt/vn/f/usemtl/mtllib do intervalo [p, end); demais linhas são ignoradas.
+// Quando relativeCorners é informado, registra os cantos com índices negativos, que
+// foram resolvidos contra as contagens locais do bloco e precisam ser deslocados.
+inline void parseOBJ(const char *p, const char *end, ObjData &obj, bool flipV = true,
+                     std::vector<ObjRelativeCorner> *relativeCorners = nullptr)
+{
+    while (p < end)
+    {
+        p = objSkipSpaces(p, end);
+        if (p + 1 >= end)
+            break;
+
+        if (p[0] == 'v' && objIsSpace(p[1]))
+        {
+            glm::vec3 position;
+            p = objParseFloat(p + 2, end, position.x);
+            p = objParseFloat(p, end, position.y);
+            p = objParseFloat(p, end, position.z);
+            obj.positions.push_back(position);
+        }
+        else if (p[0] == 'v' && p[1] == 't' && p + 2 < end && objIsSpace(p[2]))
+        {
+            glm::vec2 texCoord;
+            p = objParseFloat(p + 3, end, texCoord.x);
+            p = objParseFloat(p, end, texCoord.y);
+            if (flipV)
+                texCoord.y = 1.0f - texCoord.y;
+            obj.texCoords.push_back(texCoord);
+        }
+        else if (p[0] == 'v' && p[1] == 'n' && p + 2 < end && objIsSpace(p[2]))
+        {
+            glm::vec3 normal;
+            p = objParseFloat(p + 3, end, normal.x);
+            p = objParseFloat(p, end, normal.y);
+            p = objParseFloat(p, end, normal.z);
+            obj.normals.push_back(normal);
+        }
+        else if (p[0] == 'f' && objIsSpace(p[1]))
+        {
+            p += 2;
+            uint32_t faceSize = 0;
+            while (true)
+            {
+                p = objSkipSpaces(p, end);
+                if (p >= end || *p == '\r' || *p == '\n' || *p == '#')
+                    break;
+
+                ObjCorner corner;
+                uint8_t relativeAttributes = 0;
+                const char *next = objParseCorner(p, end, obj, corner, relativeAttributes);
+                if (next == p)
+                    break;
+                if (relativeAttributes != 0 && relativeCorners)
+                    relativeCorners->push_back({(uint32_t)obj.corners.size(), relativeAttributes});
+                obj.corners.push_back(corner);
+                faceSize++;
+                p = next;
+            }
+            if (faceSize > 0)
+                obj.faceSizes.push_back(faceSize);
+        }
+        else if (objIsKeyword(p, end, "usemtl", 6))
+        {
+            std::string name;
+            p = objParseName(p + 7, end, name);
+            ObjMaterialGroup group = {(uint32_t)obj.faceSizes.size(), objFindMaterial(obj, name)};
+            if (!obj.materialGroups.empty() && obj.materialGroups.back().firstFace == group.firstFace)
+                obj.materialGroups.back() = group;
+            else if (obj.materialGroups.empty() || obj.materialGroups.back().material != group.material)
+                obj.materialGroups.push_back(group);
+        }
+        else if (objIsKeyword(p, end, "mtllib", 6))
+        {
+            std::string name;
+            p = objParseName(p + 7, end, name);
+            obj.materialLibraries.push_back(name);
+        }
+
+        p = objSkipLine(p, end);
+    }
+}
+
+// Tamanho mínimo de bloco para a leitura paralela: arquivos menores são lidos em uma thread
+const size_t OBJ_MIN_CHUNK_SIZE = 1 << 20;
+
+inline unsigned objChooseThreadCount(size_t bytes, unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    size_t maxChunks = std::max<size_t>(1, bytes / OBJ_MIN_CHUNK_SIZE);
+    return (unsigned)std::min<size_t>(threadCount, maxChunks);
+}
+
+// Divide [begin, end) em threadCount blocos terminados em '\n', interpreta cada bloco em
+// uma thread e concatena os resultados. Os índices positivos do .OBJ já são globais;
+// os negativos são corrigidos com as somas de prefixo das contagens dos blocos anteriores.
+inline void parseOBJParallel(const char *begin, const char *end, ObjData &obj, bool flipV, unsigned threadCount)
+{
+    if (threadCount <= 1)
+    {
+        parseOBJ(begin, end, obj, flipV);
+        return;
+    }
+
+    std::vector<const char *> bounds(threadCount + 1);
+    bounds[0] = begin;
+    bounds[threadCount] = end;
+    size_t size = end - begin;
+    for (unsigned i = 1; i < threadCount; i++)
+    {
+        const char *split = std::max(begin + size * i / threadCount, bounds[i - 1]);
+        bounds[i] = split < end ? objSkipLine(split, end) : end;
+    }
+
+    std::vector<ObjData> chunks(threadCount);
+    std::vector<std::vector<ObjRelativeCorner>> relativeCorners(threadCount);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threadCount; i++)
+        workers.emplace_back([&, i]() {
+            parseOBJ(bounds[i], bounds[i + 1], chunks[i], flipV, &relativeCorners[i]);
+        });
+    for (std::thread &worker : workers)
+        worker.join();
+    workers.clear();
+
+    // Somas de prefixo: posição de cada bloco nos vetores finais
+    struct ChunkOffsets { size_t positions, texCoords, normals, corners, faces; };
+    std::vector<ChunkOffsets> offsets(threadCount + 1);
+    offsets[0] = {0, 0, 0, 0, 0};
+    for (unsigned i = 0; i < threadCount; i++)
+    {
+        offsets[i + 1].positions = offsets[i].positions + chunks[i].positions.size();
+        offsets[i + 1].texCoords = offsets[i].texCoords + chunks[i].texCoords.size();
+        offsets[i + 1].normals = offsets[i].normals + chunks[i].normals.size();
+        offsets[i + 1].corners = offsets[i].corners + chunks[i].corners.size();
+        offsets[i + 1].faces = offsets[i].faces + chunks[i].faceSizes.size();
+    }
+
+    const ChunkOffsets &total = offsets[threadCount];
+    obj.positions.resize(total.positions);
+    obj.texCoords.resize(total.texCoords);
+    obj.normals.resize(total.normals);
+    obj.corners.resize(total.corners);
+    obj.faceSizes.resize(total.faces);
+
+    for (unsigned i = 0; i < threadCount; i++)
+        workers.emplace_back([&, i]() {
+            const ObjData &chunk = chunks[i];
+            const ChunkOffsets &offset = offsets[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), obj.positions.begin() + offset.positions);
+            std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), obj.texCoords.begin() + offset.texCoords);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), obj.normals.begin() + offset.normals);
+            std::copy(chunk.corners.begin(), chunk.corners.end(), obj.corners.begin() + offset.corners);
+            std::copy(chunk.faceSizes.begin(), chunk.faceSizes.end(), obj.faceSizes.begin() + offset.faces);
+
+            for (const ObjRelativeCorner &relative : relativeCorners[i])
+            {
+                ObjCorner &corner = obj.corners[offset.corners + relative.corner];
+                if (relative.attributes & 1)
+                    corner.v += (int)offset.positions;
+                if (relative.attributes & 2)
+                    corner.vt += (int)offset.texCoords;
+                if (relative.attributes & 4)
+                    corner.vn += (int)offset.normals;
+            }
+        });
+    for (std::thread &worker : workers)
+        worker.join();
+
+    // Materiais: os nomes de cada bloco são levados para a tabela global. Um bloco que
+    // não começa com usemtl continua com o material em que o bloco anterior terminou.
+    for (unsigned i = 0; i < threadCount; i++)
+    {
+        const ObjData &chunk = chunks[i];
+        obj.materialLibraries.insert(obj.materialLibraries.end(), chunk.materialLibraries.begin(),
+                                     chunk.materialLibraries.end());
+        for (const ObjMaterialGroup &group : chunk.materialGroups)
+        {
+            ObjMaterialGroup merged = {group.firstFace + (uint32_t)offsets[i].faces,
+                                       objFindMaterial(obj, chunk.materialNames[group.material])};
+            if (!obj.materialGroups.empty() && obj.materialGroups.back().firstFace == merged.firstFace)
+                obj.materialGroups.back() = merged;
+            else if (obj.materialGroups.empty() || obj.materialGroups.back().material != merged.material)
+                obj.materialGroups.push_back(merged);
+        }
+    }
+}
+
+// Mapeia e interpreta um arquivo .OBJ, informando a vazão da leitura em MB/s.
+// threadCount = 0 usa todos os núcleos disponíveis (respeitando OBJ_MIN_CHUNK_SIZE).
+inline bool loadOBJ(const std::string &filePath, ObjData &obj, bool flipV = true, ObjLoadStats *stats = nullptr,
+                    unsigned threadCount = 0)
+{
+    MappedFile file;
+    if (!file.open(filePath))
+    {
+        std::cerr << "Erro ao tentar ler o arquivo " << filePath << std::endl;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    threadCount = objChooseThreadCount(file.size, threadCount);
+    obj.clear();
+    parseOBJParallel(file.data, file.data + file.size, obj, flipV, threadCount);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    ObjLoadStats result;
+    result.bytes = file.size;
+    result.seconds = elapsed.count();
+    result.threads = threadCount;
+    if (stats)
+        *stats = result;
+
+    std::cout << "OBJ " << filePath << ": " << obj.positions.size() << " vertices, "
+              << obj.faceSizes.size() << " faces, " << result.seconds * 1000.0 << " ms ("
+              << result.megabytesPerSecond() << " MB/s, " << threadCount << " threads)" << std::endl;
+    return true;
+}
+
+inline glm::vec3 objCornerPosition(const ObjData &obj, const ObjCorner &corner)
+{
+    return corner.v >= 0 && (size_t)corner.v < obj.positions.size() ? obj.positions[corner.v] : glm::vec3(0.0f);
+}
+
+// Memória reaproveitada entre chamadas de triangulatePolygon
+struct PolygonScratch
+{
+    std::vector<glm::vec2> points;
+    std::vector<uint32_t> remaining;
+    std::vector<uint32_t> triangles;
+};
+
+inline float polygonCross(const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// Triangula um polígono por corte de orelhas (ear clipping), projetado no plano da sua
+// normal. Polígonos côncavos ficam corretos, o que não acontece com o leque; em polígonos
+// convexos o resultado é o mesmo leque (v0, vi, vi+1). position(corner) devolve a posição
+// do canto. Devolve scratch.triangles: índices locais (0..size-1), três por triângulo.
+template <typename Position>
+const std::vector<uint32_t> &triangulatePolygon(const ObjCorner *corners, uint32_t size, Position position,
+                                                PolygonScratch &scratch)
+{
+    std::vector<uint32_t> &triangles = scratch.triangles;
+    std::vector<uint32_t> &remaining = scratch.remaining;
+    triangles.clear();
+    if (size < 3)
+        return triangles;
+    if (size == 3)
+    {
+        triangles.insert(triangles.end(), {0, 1, 2});
+        return triangles;
+    }
+
+    // Normal de Newell; o eixo de maior componente é descartado na projeção
+    glm::vec3 normal(0.0f);
+    for (uint32_t i = 0; i < size; i++)
+    {
+        glm::vec3 a = position(corners[i]);
+        glm::vec3 b = position(corners[(i + 1) % size]);
+        normal += glm::vec3((a.y - b.y) * (a.z + b.z), (a.z - b.z) * (a.x + b.x), (a.x - b.x) * (a.y + b.y));
+    }
+    glm::vec3 magnitude = glm::abs(normal);
+    int axis = magnitude.x > magnitude.y ? (magnitude.x > magnitude.z ? 0 : 2) : (magnitude.y > magnitude.z ? 1 : 2);
+    int u = (axis + 1) % 3, v = (axis + 2) % 3;
+    if (normal[axis] < 0.0f)
+        std::swap(u, v);  // mantém o polígono anti-horário no plano projetado
+
+    scratch.points.resize(size);
+    remaining.resize(size);
+    for (uint32_t i = 0; i < size; i++)
+    {
+        glm::vec3 p = position(corners[i]);
+        scratch.points[i] = glm::vec2(p[u], p[v]);
+        remaining[i] = i;
+    }
+    const std::vector<glm::vec2> &points = scratch.points;
+
+    size_t i = 1;
+    size_t misses = 0;
+    while (remaining.size() > 3 && normal != glm::vec3(0.0f))
+    {
+        size_t count = remaining.size();
+        uint32_t previous = remaining[(i + count - 1) % count];
+        uint32_t current = remaining[i];
+        uint32_t next = remaining[(i + 1) % count];
+        const glm::vec2 &a = points[previous], &b = points[current], &c = points[next];
+
+        bool ear = polygonCross(a, b, c) > 0.0f;
+        for (size_t k = 0; ear && k < count; k++)
+        {
+            const glm::vec2 &p = points[remaining[k]];
+            if (remaining[k] == previous || remaining[k] == current || remaining[k] == next || p == a || p == b ||
+                p == c)
+                continue;
+            ear = !(polygonCross(a, b, p) >= 0.0f && polygonCross(b, c, p) >= 0.0f && polygonCross(c, a, p) >= 0.0f);
+        }
+
+        if (ear)
+        {
+            triangles.insert(triangles.end(), {previous, current, next});
+            remaining.erase(remaining.begin() + i);
+            i %= remaining.size();
+            misses = 0;
+        }
+        else
+        {
+            i = (i + 1) % count;
+            if (++misses >= count)
+                break;  // polígono que se cruza ou degenerado: o resto vai em leque
+        }
+    }
+
+    for (size_t k = 1; k + 1 < remaining.size(); k++)
+        triangles.insert(triangles.end(), {remaining[0], remaining[k], remaining[k + 1]});
+    return triangles;
+}
+
+// Percorre as faces informando o material de cada triângulo: índice em materialNames, ou
+// materialNames.size() para faces anteriores ao primeiro usemtl. Polígonos com mais de
+// três cantos são triangulados por triangulatePolygon
+template <typename Callback>
+void forEachMaterialTriangle(const ObjData &obj, Callback callback)
+{
+    auto position = [&](const ObjCorner &corner) { return objCornerPosition(obj, corner); };
+    PolygonScratch scratch;
+    uint32_t material = (uint32_t)obj.materialNames.size();
+    size_t group = 0;
+    size_t first = 0;
+    for (size_t face = 0; face < obj.faceSizes.size(); face++)
+    {
+        while (group < obj.materialGroups.size() && obj.materialGroups[group].firstFace <= face)
+            material = obj.materialGroups[group++].material;
+        uint32_t faceSize = obj.faceSizes[face];
+        const ObjCorner *corners = &obj.corners[first];
+        if (faceSize == 3)
+            callback(material, corners[0], corners[1], corners[2]);
+        else
+        {
+            const std::vector<uint32_t> &triangles = triangulatePolygon(corners, faceSize, position, scratch);
+            for (size_t i = 0; i < triangles.size(); i += 3)
+                callback(material, corners[triangles[i]], corners[triangles[i + 1]], corners[triangles[i + 2]]);
+        }
+        first += faceSize;
+    }
+}
+
+// Como forEachMaterialTriangle, sem o material
+template <typename Callback>
+void forEachTriangle(const ObjData &obj, Callback callback)
+{
+    forEachMaterialTriangle(obj, [&](uint32_t, const ObjCorner &a, const ObjCorner &b, const ObjCorner &c) {
+        callback(a, b, c);
+    });
+}
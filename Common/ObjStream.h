@@ -0,0 +1,351 @@
+/*
+ *  ObjStream.h
+ *
+ *  Leitura de .OBJ com memória limitada, para malhas maiores que a RAM.
+ *
+ *  O arquivo é lido em janelas de OBJ_STREAM_WINDOW bytes (só linhas completas;
+ *  o resto passa para a janela seguinte) e nada do arquivo inteiro fica em
+ *  vetores na memória:
+ *
+ *  1. openOBJStream: interpreta cada janela com parseOBJ e grava posições,
+ *     coordenadas de textura, normais e cantos de face em arquivos temporários
+ *     binários na pasta do cache (AssetCache.h), com nomes únicos por leitura:
+ *     processos e threads diferentes podem ler o mesmo .OBJ ao mesmo tempo, e a
+ *     pasta do .OBJ pode ser só de leitura. Depois mapeia os três arquivos de
+ *     atributos, que são lidos por acesso aleatório; o sistema pode descartar
+ *     essas páginas a qualquer momento, porque elas vêm de arquivo.
+ *  2. streamOBJTriangles: percorre os cantos gravados e entrega os vértices dos
+ *     triângulos (não indexados) em lotes de OBJ_STREAM_BATCH vértices. Cantos
+ *     sem vn recebem a normal plana do triângulo.
+ *
+ *  O destino dos lotes é escolhido por quem chama: streamOBJToGPU escreve direto
+ *  em um VBO mapeado com glMapBuffer e writeMeshCacheStream (MeshCache.h) grava o
+ *  cache binário. loadMeshCached usa esse caminho para arquivos a partir de
+ *  OBJ_STREAM_THRESHOLD bytes.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  GPUMesh mesh = streamOBJToGPU("scan.obj");
+ *  ...
+ *  drawMesh(mesh);  // glDrawArrays, sem EBO
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "AssetCache.h"
+#include "MappedFile.h"
+#include "Mesh.h"
+#include "ObjLoader.h"
+
+const size_t OBJ_STREAM_WINDOW = 8 << 20;
+const size_t OBJ_STREAM_BATCH = 1 << 14;
+const uint64_t OBJ_STREAM_THRESHOLD = 256ull << 20;
+
+struct ObjStream
+{
+    std::string scratchPrefix;
+    uint64_t bytes = 0;
+    size_t positionCount = 0;
+    size_t texCoordCount = 0;
+    size_t normalCount = 0;
+    size_t faceCount = 0;
+    size_t triangleCount = 0;
+    glm::vec3 boundsMin = glm::vec3(0.0f);  // de todas as posições do arquivo
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    MappedFile positions;
+    MappedFile texCoords;
+    MappedFile normals;
+};
+
+inline std::string objStreamScratchPath(const ObjStream &stream, const char *name)
+{
+    return stream.scratchPrefix + "." + name + ".tmp";
+}
+
+// Chama callback(begin, end) com blocos de linhas completas lidos em janelas de windowSize bytes
+template <typename Callback>
+bool readFileWindows(const std::string &filePath, size_t windowSize, Callback callback)
+{
+    FILE *file = fopen(filePath.c_str(), "rb");
+    if (!file)
+        return false;
+
+    std::vector<char> buffer(std::max<size_t>(windowSize, 64));
+    size_t carried = 0;
+    while (true)
+    {
+        if (carried == buffer.size())
+            buffer.resize(buffer.size() * 2);  // uma única linha maior que a janela
+
+        size_t read = fread(buffer.data() + carried, 1, buffer.size() - carried, file);
+        size_t filled = carried + read;
+        if (read == 0)
+        {
+            if (filled > 0)
+                callback(buffer.data(), buffer.data() + filled);
+            break;
+        }
+
+        size_t lineEnd = filled;
+        while (lineEnd > 0 && buffer[lineEnd - 1] != '\n')
+            lineEnd--;
+        if (lineEnd == 0)
+        {
+            carried = filled;
+            continue;
+        }
+
+        callback(buffer.data(), buffer.data() + lineEnd);
+        carried = filled - lineEnd;
+        memmove(buffer.data(), buffer.data() + lineEnd, carried);
+    }
+
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+inline void closeOBJStream(ObjStream &stream)
+{
+    stream.positions.close();
+    stream.texCoords.close();
+    stream.normals.close();
+    if (stream.scratchPrefix.empty())
+        return;
+
+    std::error_code error;
+    for (const char *name : {"positions", "texcoords", "normals", "corners", "faces"})
+        std::filesystem::remove(objStreamScratchPath(stream, name), error);
+}
+
+// Primeira passada: grava os atributos e as faces em arquivos temporários e os mapeia
+inline bool openOBJStream(const std::string &filePath, ObjStream &stream, bool flipV = true,
+                          size_t windowSize = OBJ_STREAM_WINDOW)
+{
+    closeOBJStream(stream);
+    std::error_code error;
+    std::string absolute = std::filesystem::absolute(filePath, error).lexically_normal().string();
+    stream.scratchPrefix = assetCacheTempPath(assetCachePath(hashBytes(absolute.data(), absolute.size()), ".stream"));
+    stream.bytes = 0;
+    stream.positionCount = stream.texCoordCount = stream.normalCount = 0;
+    stream.faceCount = stream.triangleCount = 0;
+    stream.boundsMin = stream.boundsMax = glm::vec3(0.0f);
+
+    bool ok;
+    {
+        std::ofstream positionsOut(objStreamScratchPath(stream, "positions"), std::ios::binary | std::ios::trunc);
+        std::ofstream texCoordsOut(objStreamScratchPath(stream, "texcoords"), std::ios::binary | std::ios::trunc);
+        std::ofstream normalsOut(objStreamScratchPath(stream, "normals"), std::ios::binary | std::ios::trunc);
+        std::ofstream cornersOut(objStreamScratchPath(stream, "corners"), std::ios::binary | std::ios::trunc);
+        std::ofstream facesOut(objStreamScratchPath(stream, "faces"), std::ios::binary | std::ios::trunc);
+
+        ObjData chunk;
+        std::vector<ObjRelativeCorner> relativeCorners;
+        ok = readFileWindows(filePath, windowSize, [&](const char *begin, const char *end) {
+            chunk.clear();
+            relativeCorners.clear();
+            parseOBJ(begin, end, chunk, flipV, &relativeCorners);
+
+            // Índices negativos foram resolvidos contra as contagens da janela
+            for (const ObjRelativeCorner &relative : relativeCorners)
+            {
+                ObjCorner &corner = chunk.corners[relative.corner];
+                if (relative.attributes & 1)
+                    corner.v += (int)stream.positionCount;
+                if (relative.attributes & 2)
+                    corner.vt += (int)stream.texCoordCount;
+                if (relative.attributes & 4)
+                    corner.vn += (int)stream.normalCount;
+            }
+
+            if (stream.positionCount == 0 && !chunk.positions.empty())
+                stream.boundsMin = stream.boundsMax = chunk.positions[0];
+            for (const glm::vec3 &position : chunk.positions)
+            {
+                stream.boundsMin = glm::min(stream.boundsMin, position);
+                stream.boundsMax = glm::max(stream.boundsMax, position);
+            }
+            for (uint32_t faceSize : chunk.faceSizes)
+                stream.triangleCount += faceSize >= 3 ? faceSize - 2 : 0;
+
+            positionsOut.write((const char *)chunk.positions.data(), chunk.positions.size() * sizeof(glm::vec3));
+            texCoordsOut.write((const char *)chunk.texCoords.data(), chunk.texCoords.size() * sizeof(glm::vec2));
+            normalsOut.write((const char *)chunk.normals.data(), chunk.normals.size() * sizeof(glm::vec3));
+            cornersOut.write((const char *)chunk.corners.data(), chunk.corners.size() * sizeof(ObjCorner));
+            facesOut.write((const char *)chunk.faceSizes.data(), chunk.faceSizes.size() * sizeof(uint32_t));
+
+            stream.positionCount += chunk.positions.size();
+            stream.texCoordCount += chunk.texCoords.size();
+            stream.normalCount += chunk.normals.size();
+            stream.faceCount += chunk.faceSizes.size();
+            stream.bytes += end - begin;
+        });
+        ok = ok && positionsOut && texCoordsOut && normalsOut && cornersOut && facesOut;
+    }
+
+    ok = ok && stream.positions.open(objStreamScratchPath(stream, "positions")) &&
+         stream.texCoords.open(objStreamScratchPath(stream, "texcoords")) &&
+         stream.normals.open(objStreamScratchPath(stream, "normals"));
+    if (!ok)
+    {
+        std::cerr << "Erro ao tentar ler o arquivo " << filePath << std::endl;
+        closeOBJStream(stream);
+        return false;
+    }
+    return true;
+}
+
+inline Vertex objStreamVertex(const ObjStream &stream, const ObjCorner &corner)
+{
+    Vertex vertex{};
+    if (corner.v >= 0 && (size_t)corner.v < stream.positionCount)
+        memcpy(&vertex.position, stream.positions.data + corner.v * sizeof(glm::vec3), sizeof(glm::vec3));
+    if (corner.vt >= 0 && (size_t)corner.vt < stream.texCoordCount)
+        memcpy(&vertex.texCoord, stream.texCoords.data + corner.vt * sizeof(glm::vec2), sizeof(glm::vec2));
+    if (corner.vn >= 0 && (size_t)corner.vn < stream.normalCount)
+        memcpy(&vertex.normal, stream.normals.data + corner.vn * sizeof(glm::vec3), sizeof(glm::vec3));
+    return vertex;
+}
+
+// Sem vizinhança entre faces não dá para gerar normais suaves (MeshNormals.h): cantos sem
+// vn recebem a normal do próprio triângulo
+inline void objStreamFlatNormals(const ObjStream &stream, const ObjCorner *a, const ObjCorner *b,
+                                 const ObjCorner *c, Vertex *vertices)
+{
+    const ObjCorner *corners[3] = {a, b, c};
+    glm::vec3 normal(0.0f);
+    for (int k = 0; k < 3; k++)
+    {
+        if (corners[k]->vn >= 0 && (size_t)corners[k]->vn < stream.normalCount)
+            continue;
+        if (normal == glm::vec3(0.0f))
+        {
+            normal = glm::cross(vertices[1].position - vertices[0].position,
+                                vertices[2].position - vertices[0].position);
+            float length = glm::length(normal);
+            normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+        }
+        vertices[k].normal = normal;
+    }
+}
+
+// Segunda passada: callback(const Vertex *vertices, size_t count) recebe os triângulos em
+// lotes (polígonos triangulados por triangulatePolygon, como em forEachTriangle); devolve o total de vértices entregues
+template <typename Callback>
+size_t streamOBJTriangles(const ObjStream &stream, Callback callback)
+{
+    FILE *faces = fopen(objStreamScratchPath(stream, "faces").c_str(), "rb");
+    FILE *corners = fopen(objStreamScratchPath(stream, "corners").c_str(), "rb");
+    size_t delivered = 0;
+    if (faces && corners)
+    {
+        std::vector<Vertex> batch;
+        batch.reserve(OBJ_STREAM_BATCH);
+        std::vector<ObjCorner> face;
+        PolygonScratch scratch;
+        auto position = [&](const ObjCorner &corner) { return objStreamVertex(stream, corner).position; };
+        uint32_t faceSize;
+        for (size_t f = 0; f < stream.faceCount && fread(&faceSize, sizeof(faceSize), 1, faces) == 1; f++)
+        {
+            face.resize(faceSize);
+            if (fread(face.data(), sizeof(ObjCorner), faceSize, corners) != faceSize)
+                break;
+
+            const std::vector<uint32_t> &triangles = triangulatePolygon(face.data(), faceSize, position, scratch);
+            for (size_t i = 0; i < triangles.size(); i += 3)
+            {
+                if (batch.size() + 3 > OBJ_STREAM_BATCH)
+                {
+                    callback(batch.data(), batch.size());
+                    delivered += batch.size();
+                    batch.clear();
+                }
+                const ObjCorner &a = face[triangles[i]], &b = face[triangles[i + 1]], &c = face[triangles[i + 2]];
+                batch.push_back(objStreamVertex(stream, a));
+                batch.push_back(objStreamVertex(stream, b));
+                batch.push_back(objStreamVertex(stream, c));
+                objStreamFlatNormals(stream, &a, &b, &c, &batch[batch.size() - 3]);
+            }
+        }
+        if (!batch.empty())
+            callback(batch.data(), batch.size());
+        delivered += batch.size();
+    }
+
+    if (faces)
+        fclose(faces);
+    if (corners)
+        fclose(corners);
+    return delivered;
+}
+
+inline void printOBJStreamStats(const std::string &filePath, const ObjStream &stream, double totalSeconds)
+{
+    std::cout << "OBJ (streaming) " << filePath << ": " << stream.positionCount << " vertices, " << stream.faceCount
+              << " faces, " << totalSeconds * 1000.0 << " ms ("
+              << (totalSeconds > 0.0 ? stream.bytes / (1024.0 * 1024.0) / totalSeconds : 0.0)
+              << " MB/s, janelas de " << OBJ_STREAM_WINDOW / (1024 * 1024) << " MB)" << std::endl;
+}
+
+// Lê o .OBJ em janelas e escreve os vértices direto no VBO mapeado (malha não indexada)
+inline GPUMesh streamOBJToGPU(const std::string &filePath, bool flipV = true)
+{
+    auto start = std::chrono::steady_clock::now();
+    ObjStream stream;
+    if (!openOBJStream(filePath, stream, flipV))
+        return GPUMesh();
+
+    GPUMesh gpu;
+    size_t vertexCount = stream.triangleCount * 3;
+    glGenVertexArrays(1, &gpu.VAO);
+    glGenBuffers(1, &gpu.VBO);
+    glBindVertexArray(gpu.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, gpu.VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
+
+    size_t written = 0;
+    Vertex *mapped = vertexCount > 0 ? (Vertex *)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY) : nullptr;
+    if (mapped)
+    {
+        streamOBJTriangles(stream, [&](const Vertex *vertices, size_t count) {
+            count = std::min(count, vertexCount - written);
+            memcpy(mapped + written, vertices, count * sizeof(Vertex));
+            written += count;
+        });
+        // GL_FALSE: o conteúdo do buffer se perdeu enquanto estava mapeado (ex.: troca de modo de vídeo)
+        if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE)
+        {
+            std::cerr << "Conteudo do VBO perdido durante o envio de " << filePath << std::endl;
+            written = 0;
+        }
+    }
+    else if (vertexCount > 0)
+        std::cerr << "Nao foi possivel mapear o VBO para " << filePath << std::endl;
+
+    setupVertexAttributes(VERTEX_LAYOUT, VERTEX_LAYOUT_SIZE, sizeof(Vertex));
+    glBindVertexArray(0);
+    gpu.indexCount = (GLsizei)written;
+    gpu.boundsMin = stream.boundsMin;
+    gpu.boundsMax = stream.boundsMax;
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printOBJStreamStats(filePath, stream, elapsed.count());
+    closeOBJStream(stream);
+    return gpu;
+}
@@ -0,0 +1,248 @@
+/*
+ *  PackedVertex.h
+ *
+ *  Formato compacto de vértice (16 bytes em vez dos 32 de Vertex):
+ *
+ *  posição   3 x int16 snorm, relativos à caixa envolvente da malha (+ 2 bytes de alinhamento)
+ *  normal    GL_INT_2_10_10_10_REV normalizado (10 bits com sinal por componente)
+ *  textura   2 x half float
+ *
+ *  A OpenGL converte os tipos normalizados para float ao ler os atributos; o
+ *  vertex shader só precisa desfazer a escala da posição com os uniforms
+ *  positionOffset e positionScale (GPUMesh guarda os valores de cada malha).
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+
+struct PackedVertex
+{
+    int16_t position[4];
+    uint32_t normal;
+    uint16_t texCoord[2];
+};
+
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex deve ter 16 bytes");
+
+// Mesmas localizações de VERTEX_LAYOUT (1 e 2 = normal), com tipos normalizados
+const VertexAttribute PACKED_VERTEX_LAYOUT[] = {
+    {0, 3, GL_SHORT, GL_TRUE, offsetof(PackedVertex, position)},
+    {1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(PackedVertex, normal)},
+    {2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(PackedVertex, normal)},
+    {3, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(PackedVertex, texCoord)},
+};
+const uint32_t PACKED_VERTEX_LAYOUT_SIZE = sizeof(PACKED_VERTEX_LAYOUT) / sizeof(PACKED_VERTEX_LAYOUT[0]);
+
+struct QuantizationParams
+{
+    glm::vec3 offset;  // centro da caixa envolvente
+    glm::vec3 scale;   // metade do tamanho da caixa em cada eixo
+};
+
+struct QuantizationError
+{
+    float maxPosition = 0.0f;      // em unidades do objeto
+    float rmsPosition = 0.0f;
+    float maxNormalDegrees = 0.0f;
+    float maxTexCoord = 0.0f;
+};
+
+inline QuantizationParams quantizationParams(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+    QuantizationParams params;
+    params.offset = (boundsMin + boundsMax) * 0.5f;
+    params.scale = glm::max((boundsMax - boundsMin) * 0.5f, glm::vec3(1e-8f));
+    return params;
+}
+
+inline int16_t quantizeSnorm16(float value)
+{
+    return (int16_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+inline float dequantizeSnorm16(int16_t value)
+{
+    return std::max(value / 32767.0f, -1.0f);
+}
+
+inline uint32_t packNormal2101010(glm::vec3 normal)
+{
+    float length = glm::length(normal);
+    if (length > 0.0f)
+        normal /= length;
+
+    uint32_t packed = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        int32_t q = (int32_t)std::lround(std::clamp(normal[i], -1.0f, 1.0f) * 511.0f);
+        packed |= ((uint32_t)q & 0x3FFu) << (10 * i);
+    }
+    return packed;
+}
+
+inline glm::vec3 unpackNormal2101010(uint32_t packed)
+{
+    glm::vec3 normal;
+    for (int i = 0; i < 3; i++)
+    {
+        int32_t q = (int32_t)((packed >> (10 * i)) & 0x3FFu);
+        if (q & 0x200)
+            q -= 0x400;
+        normal[i] = std::max(q / 511.0f, -1.0f);
+    }
+    return normal;
+}
+
+// Conversão float -> half com arredondamento para o mais próximo
+inline uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    if (((bits >> 23) & 0xFF) == 0xFF)  // inf / NaN
+        return (uint16_t)(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+    if (exponent >= 31)  // estouro: infinito
+        return (uint16_t)(sign | 0x7C00u);
+    if (exponent <= 0)  // subnormal ou zero
+    {
+        if (exponent < -10)
+            return (uint16_t)sign;
+        mantissa |= 0x800000u;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t midpoint = 1u << (shift - 1);
+        if (remainder > midpoint || (remainder == midpoint && (half & 1)))
+            half++;
+        return (uint16_t)(sign | half);
+    }
+
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFFu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1)))
+        half++;  // pode propagar para o expoente, o que também é o resultado correto
+    return (uint16_t)half;
+}
+
+inline float halfToFloat(uint16_t half)
+{
+    uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+    uint32_t exponent = (half >> 10) & 0x1Fu;
+    uint32_t mantissa = half & 0x3FFu;
+    uint32_t bits;
+
+    if (exponent == 0)
+    {
+        if (mantissa == 0)
+            bits = sign;
+        else
+        {
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400u) == 0)
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+        }
+    }
+    else if (exponent == 31)
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    else
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline std::vector<PackedVertex> packVertices(const Mesh &mesh, const QuantizationParams &params)
+{
+    std::vector<PackedVertex> packed(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); i++)
+    {
+        const Vertex &vertex = mesh.vertices[i];
+        glm::vec3 position = (vertex.position - params.offset) / params.scale;
+        packed[i].position[0] = quantizeSnorm16(position.x);
+        packed[i].position[1] = quantizeSnorm16(position.y);
+        packed[i].position[2] = quantizeSnorm16(position.z);
+        packed[i].position[3] = 0;
+        packed[i].normal = packNormal2101010(vertex.normal);
+        packed[i].texCoord[0] = floatToHalf(vertex.texCoord.x);
+        packed[i].texCoord[1] = floatToHalf(vertex.texCoord.y);
+    }
+    return packed;
+}
+
+// Decodifica os vértices como a GPU faria e compara com os originais
+inline QuantizationError measureQuantizationError(const Mesh &mesh, const std::vector<PackedVertex> &packed,
+                                                  const QuantizationParams &params)
+{
+    QuantizationError error;
+    double sumSquared = 0.0;
+    for (size_t i = 0; i < mesh.vertices.size(); i++)
+    {
+        const Vertex &vertex = mesh.vertices[i];
+        glm::vec3 position(dequantizeSnorm16(packed[i].position[0]), dequantizeSnorm16(packed[i].position[1]),
+                           dequantizeSnorm16(packed[i].position[2]));
+        position = params.offset + position * params.scale;
+        float positionError = glm::length(position - vertex.position);
+        error.maxPosition = std::max(error.maxPosition, positionError);
+        sumSquared += (double)positionError * positionError;
+
+        float normalLength = glm::length(vertex.normal);
+        glm::vec3 normal = unpackNormal2101010(packed[i].normal);
+        if (normalLength > 0.0f && glm::length(normal) > 0.0f)
+        {
+            float cosine = glm::dot(vertex.normal / normalLength, glm::normalize(normal));
+            float degrees = glm::degrees(std::acos(std::clamp(cosine, -1.0f, 1.0f)));
+            error.maxNormalDegrees = std::max(error.maxNormalDegrees, degrees);
+        }
+
+        float du = std::fabs(halfToFloat(packed[i].texCoord[0]) - vertex.texCoord.x);
+        float dv = std::fabs(halfToFloat(packed[i].texCoord[1]) - vertex.texCoord.y);
+        error.maxTexCoord = std::max(error.maxTexCoord, std::max(du, dv));
+    }
+    if (!mesh.vertices.empty())
+        error.rmsPosition = (float)std::sqrt(sumSquared / mesh.vertices.size());
+    return error;
+}
+
+inline void printQuantizationError(const QuantizationError &error, const Mesh &mesh)
+{
+    float diagonal = glm::length(mesh.boundsMax - mesh.boundsMin);
+    float relative = diagonal > 0.0f ? error.maxPosition / diagonal : 0.0f;
+    std::cout << "Quantizacao (" << sizeof(PackedVertex) << " bytes/vertice): posicao max " << error.maxPosition
+              << " (" << relative * 100.0f << "% da diagonal), rms " << error.rmsPosition << ", normal max "
+              << error.maxNormalDegrees << " graus, UV max " << error.maxTexCoord << std::endl;
+}
+
+inline GPUMesh uploadPackedMesh(const Mesh &mesh)
+{
+    QuantizationParams params = quantizationParams(mesh.boundsMin, mesh.boundsMax);
+    std::vector<PackedVertex> packed = packVertices(mesh, params);
+    printQuantizationError(measureQuantizationError(mesh, packed, params), mesh);
+
+    GPUMesh gpu = uploadMeshVertices(mesh, packed.data(), packed.size() * sizeof(PackedVertex), PACKED_VERTEX_LAYOUT,
+                                     PACKED_VERTEX_LAYOUT_SIZE, sizeof(PackedVertex));
+    gpu.positionOffset = params.offset;
+    gpu.positionScale = params.scale;
+    return gpu;
+}
@@ -0,0 +1,135 @@
+/*
+ *  Shader.h
+ *
+ *  Programa de shader com as localizações dos uniforms resolvidas uma vez, logo
+ *  depois do link. glGetUniformLocation procura o nome em uma tabela do driver a
+ *  cada chamada; chamado por objeto e por quadro, isso fica no caminho mais
+ *  quente do desenho. loadShaderUniforms percorre os uniforms ativos com
+ *  glGetActiveUniform e guarda nome -> localização; uniformLocation consulta
+ *  essa tabela (sem GL) e é usado na inicialização para montar as localizações
+ *  que o laço de desenho passa direto para glUniform*.
+ *
+ *  Um nome que não está na tabela devolve -1 (glUniform* com -1 não faz nada)
+ *  e gera um aviso, uma vez por nome: ou o uniform não existe no shader (erro
+ *  de digitação, uma variável "out" tratada como uniform) ou o compilador o
+ *  removeu por não ser usado.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  Shader shader;
+ *  loadShaderUniforms(shader, setupShader());  // ou createShader(shader, vertexSource, fragmentSource)
+ *  GLint modelLoc = uniformLocation(shader, "model");
+ *  ...
+ *  glUseProgram(shader.program);
+ *  glUniformMatrix4fv(modelLoc, 1, GL_FALSE, value_ptr(model));
+ *
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glad/glad.h>
+
+struct Shader
+{
+    GLuint program = 0;
+    std::unordered_map<std::string, GLint> uniforms;  // uniforms ativos fora de blocos
+    std::unordered_set<std::string> warned;           // nomes desconhecidos já avisados
+};
+
+// Enumera os uniforms ativos de um programa já linkado
+inline void loadShaderUniforms(Shader &shader, GLuint program)
+{
+    shader.program = program;
+    shader.uniforms.clear();
+    shader.warned.clear();
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> name((size_t)maxLength + 1);
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+        std::string uniform(name.data(), (size_t)length);
+        // Uniforms dentro de blocos não têm localização
+        GLint location = glGetUniformLocation(program, uniform.c_str());
+        if (location < 0)
+            continue;
+        shader.uniforms[uniform] = location;
+        // Arrays aparecem como "nome[0]"; o nome sem índice aponta para o mesmo elemento
+        if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+            shader.uniforms[uniform.substr(0, uniform.size() - 3)] = location;
+    }
+}
+
+inline GLuint compileShaderStage(GLenum type, const char *source)
+{
+    GLuint stage = glCreateShader(type);
+    glShaderSource(stage, 1, &source, NULL);
+    glCompileShader(stage);
+
+    GLint success;
+    GLchar infoLog[512];
+    glGetShaderiv(stage, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(stage, 512, NULL, infoLog);
+        std::cout << "Erro " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader:\n"
+                  << infoLog << std::endl;
+    }
+    return stage;
+}
+
+// Compila, linka e carrega os uniforms; devolve false se o link falhar
+inline bool createShader(Shader &shader, const char *vertexSource, const char *fragmentSource)
+{
+    GLuint vertexShader = compileShaderStage(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = compileShaderStage(GL_FRAGMENT_SHADER, fragmentSource);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+
+    GLint success;
+    GLchar infoLog[512];
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cout << "Erro link shader program:\n" << infoLog << std::endl;
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    loadShaderUniforms(shader, program);
+    return success != 0;
+}
+
+// Localização resolvida no link; -1 (com aviso único) para nomes que o programa não tem
+inline GLint uniformLocation(Shader &shader, const char *name)
+{
+    auto it = shader.uniforms.find(name);
+    if (it != shader.uniforms.end())
+        return it->second;
+    if (shader.warned.insert(name).second)
+        std::cout << "Aviso: uniform \"" << name << "\" nao existe no shader " << shader.program
+                  << " (ou foi removido por nao ser usado)" << std::endl;
+    return -1;
+}
+
+inline void destroyShader(Shader &shader)
+{
+    glDeleteProgram(shader.program);
+    shader = Shader();
+}
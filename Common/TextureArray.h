@@ -0,0 +1,428 @@
+/*
+ *  TextureArray.h
+ *
+ *  Empacota as texturas de cor dos materiais (map_Kd) em GL_TEXTURE_2D_ARRAY:
+ *  as imagens de mesmo formato (ex.: todas em BC1) viram camadas de um único
+ *  array, e cada material guarda o array em diffuseTexture e a camada em
+ *  diffuseLayer. A cena inteira desenha com um glBindTexture por formato (em
+ *  geral um só), e o shader escolhe a camada por uniform ou por atributo:
+ *  texture(diffuseMaps, vec3(TexCoord, diffuseLayer)).
+ *
+ *  Todas as camadas de um array têm o tamanho da maior imagem do grupo; as
+ *  menores são ampliadas na CPU com o filtro dos mipmaps (resizeImage) e a versão
+ *  ampliada, já com os mipmaps (e comprimida, se for o caso), fica no cache
+ *  compartilhado com o tamanho na chave. Ao contrário de um atlas, as camadas não
+ *  se misturam na filtragem nem nos mipmaps, GL_REPEAT continua valendo e as
+ *  coordenadas de textura das malhas não mudam. A amostragem é uma só por array:
+ *  repetição e filtro trilinear (TextureSampler padrão).
+ *
+ *  Forma de uso
+ *  -----------------
+ *  TextureArraySet arrays;
+ *  packMaterialTextures(arrays, materials, loadImage, stbi_image_free, support, true);
+ *  ...
+ *  glBindTexture(GL_TEXTURE_2D_ARRAY, material.diffuseTexture);  // só quando muda
+ *  glUniform1i(layerLocation, material.diffuseLayer);
+ *  ...
+ *  destroyTextureArrays(arrays);
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "GLExtensions.h"
+#include "ImageCache.h"
+#include "KTX2.h"
+#include "Material.h"
+#include "Mipmap.h"
+#include "TextureRegistry.h"
+
+const size_t TEXTURE_ARRAY_MAX_LAYERS = 256;  // mínimo garantido de GL_MAX_ARRAY_TEXTURE_LAYERS
+
+// Imagens de mesmo formato que vão para o mesmo array
+struct TextureArrayGroup
+{
+    GLenum format = 0;
+    bool compressed = false;
+    BlockFormat blockFormat = BLOCK_BC1;
+    int width = 0;  // tamanho das camadas: o maior do grupo
+    int height = 0;
+    size_t levels = 0;  // menor cadeia entre as camadas (um .ktx2 pode não chegar a 1x1)
+    std::vector<size_t> members;  // índices em TextureArrayStaging::paths
+};
+
+// Parte de CPU do empacotamento: as imagens já no tamanho do array de cada uma
+struct TextureArrayStaging
+{
+    std::vector<std::string> paths;      // caminhos canônicos
+    std::deque<TextureStaging> layers;   // uma por caminho
+    std::vector<bool> loaded;
+    std::vector<TextureArrayGroup> groups;
+};
+
+struct TextureArray
+{
+    GLuint texture = 0;
+    GLenum format = 0;
+    int width = 0;
+    int height = 0;
+    size_t levels = 0;
+    size_t layers = 0;
+    size_t bytes = 0;  // memória de vídeo estimada, mipmaps incluídos
+};
+
+// Arrays da cena e a posição de cada arquivo neles
+struct TextureArraySet
+{
+    std::vector<TextureArray> arrays;
+    std::vector<std::string> paths;  // caminhos canônicos
+    std::vector<int> array;          // índice em arrays de paths[i] (-1: a imagem não pôde ser lida)
+    std::vector<int> layer;
+};
+
+inline GLenum textureStagingFormat(const TextureStaging &staging)
+{
+    return staging.compressed ? compressedTextureFormat(staging.blocks.format, staging.blocks.srgb)
+                              : imageTextureFormat(staging.image.channels);
+}
+
+inline int textureStagingWidth(const TextureStaging &staging)
+{
+    return staging.compressed ? staging.blocks.levels[0].width : staging.image.width;
+}
+
+inline int textureStagingHeight(const TextureStaging &staging)
+{
+    return staging.compressed ? staging.blocks.levels[0].height : staging.image.height;
+}
+
+inline size_t textureStagingLevels(const TextureStaging &staging)
+{
+    return staging.compressed ? staging.blocks.levels.size() : staging.image.levels.size();
+}
+
+// Arquivos map_Kd distintos da tabela, na ordem dos materiais
+inline std::vector<std::string> materialTexturePaths(const MaterialLibrary &library)
+{
+    std::vector<std::string> paths;
+    for (const Material &material : library.materials)
+    {
+        if (material.diffuseMap.empty())
+            continue;
+        std::string path = canonicalTexturePath(material.diffuseMap);
+        if (std::find(paths.begin(), paths.end(), path) == paths.end())
+            paths.push_back(path);
+    }
+    return paths;
+}
+
+// Leva a imagem já lida em staging para width x height, com os mipmaps refeitos. O
+// resultado vai para o cache com o tamanho na chave, então só a primeira carga filtra
+inline bool resizeTextureStaging(const std::string &path, TextureStaging &staging, int width, int height,
+                                 const std::string &settings = "", const MipSettings &mips = MipSettings())
+{
+    AssetSource source;
+    if (!statAssetSource(path, source))
+    {
+        std::cerr << "Erro ao tentar ler o arquivo " << path << std::endl;
+        return false;
+    }
+    std::string layerSettings = settings + " layer " + std::to_string(width) + "x" + std::to_string(height);
+
+    if (staging.compressed)
+    {
+        CompressedTextureStaging &blocks = staging.blocks;
+        if (blocks.format == BLOCK_BC7)
+        {
+            std::cerr << "A textura " << path << " usa BC7 e nao pode ser redimensionada" << std::endl;
+            return false;
+        }
+        // Cópia do nível 0: a entrada mapeada é fechada antes de abrir a do novo tamanho
+        int sourceWidth = blocks.levels[0].width, sourceHeight = blocks.levels[0].height;
+        std::vector<unsigned char> source0(blocks.levels[0].data, blocks.levels[0].data + blocks.levels[0].size);
+        BlockFormat format = blocks.format;
+        bool srgb = blocks.srgb;
+        blocks.file.close();
+        blocks.levels.clear();
+
+        std::string cachePath = compressedTextureCachePath(source.hash, layerSettings, mips);
+        if (openCompressedTextureCache(cachePath, blocks))
+            return true;
+        std::vector<unsigned char> rgba = decompressToRGBA(source0.data(), sourceWidth, sourceHeight, format);
+        std::vector<unsigned char> resized = resizeImage(rgba.data(), sourceWidth, sourceHeight, 4, width, height, mips);
+        blocks.format = format;
+        blocks.srgb = srgb;
+        blocks.owned = buildKTX2(format, srgb, compressMipChain(resized, width, height, format, mips));
+        parseKTX2(blocks.owned.data(), blocks.owned.size(), blocks);
+        if (!writeCompressedTextureCache(cachePath, blocks.owned))
+            std::cerr << "Nao foi possivel gravar o cache de textura " << cachePath << std::endl;
+        return true;
+    }
+
+    ImageStaging &image = staging.image;
+    int sourceWidth = image.width, sourceHeight = image.height, channels = image.channels;
+    std::vector<unsigned char> source0(image.pixels, image.pixels + (size_t)sourceWidth * sourceHeight * channels);
+    image.file.close();
+    image.owned.clear();
+
+    std::string cachePath = imageCachePath(source.hash, layerSettings, mips);
+    if (openImageCache(cachePath, source.hash, image))
+        return true;
+    image.owned = resizeImage(source0.data(), sourceWidth, sourceHeight, channels, width, height, mips);
+    image.pixels = image.owned.data();
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    generateImageMips(image, mips);
+    if (!writeImageCache(cachePath, image, source.hash))
+        std::cerr << "Nao foi possivel gravar o cache de imagem " << cachePath << std::endl;
+    return true;
+}
+
+// Parte do empacotamento que não usa OpenGL (pode rodar nas threads de AssetLoader.h):
+// lê cada um de staging.paths (loadTextureStaging), separa as imagens por formato e
+// deixa todas as camadas de um grupo com o mesmo tamanho
+inline void loadTextureArrayStaging(TextureArrayStaging &staging, ImageLoadFunction decode,
+                                    ImageFreeFunction freeImage, const TextureCompressionSupport &support,
+                                    bool compress, const std::string &settings = "")
+{
+    staging.layers.clear();
+    staging.loaded.clear();
+    staging.groups.clear();
+    for (const std::string &path : staging.paths)
+    {
+        TextureStaging &layer = staging.layers.emplace_back();
+        staging.loaded.push_back(loadTextureStaging(path, decode, freeImage, support, compress, layer, settings));
+    }
+
+    for (size_t i = 0; i < staging.paths.size(); i++)
+    {
+        if (!staging.loaded[i])
+            continue;
+        const TextureStaging &layer = staging.layers[i];
+        GLenum format = textureStagingFormat(layer);
+        TextureArrayGroup *group = nullptr;
+        for (TextureArrayGroup &candidate : staging.groups)
+            if (candidate.format == format && candidate.members.size() < TEXTURE_ARRAY_MAX_LAYERS)
+                group = &candidate;
+        if (!group)
+        {
+            staging.groups.emplace_back();
+            group = &staging.groups.back();
+            group->format = format;
+            group->compressed = layer.compressed;
+            group->blockFormat = layer.blocks.format;
+        }
+        group->width = std::max(group->width, textureStagingWidth(layer));
+        group->height = std::max(group->height, textureStagingHeight(layer));
+        group->members.push_back(i);
+    }
+
+    for (TextureArrayGroup &group : staging.groups)
+    {
+        std::vector<size_t> members;
+        group.levels = (size_t)mipLevelCount(group.width, group.height);
+        for (size_t i : group.members)
+        {
+            TextureStaging &layer = staging.layers[i];
+            if (textureStagingWidth(layer) != group.width || textureStagingHeight(layer) != group.height)
+                staging.loaded[i] = resizeTextureStaging(staging.paths[i], layer, group.width, group.height, settings);
+            if (!staging.loaded[i])
+                continue;
+            group.levels = std::min(group.levels, textureStagingLevels(layer));
+            members.push_back(i);
+        }
+        group.members = members;
+    }
+    staging.groups.erase(std::remove_if(staging.groups.begin(), staging.groups.end(),
+                                        [](const TextureArrayGroup &group) { return group.members.empty(); }),
+                         staging.groups.end());
+}
+
+inline void destroyTextureArrays(TextureArraySet &set)
+{
+    for (TextureArray &array : set.arrays)
+        glDeleteTextures(1, &array.texture);
+    set.arrays.clear();
+    set.paths.clear();
+    set.array.clear();
+    set.layer.clear();
+}
+
+// Cria os arrays (um por grupo, com todos os níveis alocados e ainda sem dados) e
+// define a camada de cada arquivo. O set anterior é apagado
+inline void beginTextureArrays(TextureArraySet &set, const TextureArrayStaging &staging)
+{
+    destroyTextureArrays(set);
+    set.paths = staging.paths;
+    set.array.assign(staging.paths.size(), -1);
+    set.layer.assign(staging.paths.size(), -1);
+
+    for (const TextureArrayGroup &group : staging.groups)
+    {
+        TextureArray array;
+        array.format = group.format;
+        array.width = group.width;
+        array.height = group.height;
+        array.levels = group.levels;
+        array.layers = group.members.size();
+        glGenTextures(1, &array.texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+        // Imutável com glTexStorage3D quando o driver tem (GLExtensions.h); senão nível por nível
+        GLTexStorage3DFunction texStorage3D = glExtensions().texStorage3D;
+        if (texStorage3D)
+            texStorage3D(GL_TEXTURE_2D_ARRAY, (GLsizei)array.levels, sizedTextureFormat(array.format), array.width,
+                         array.height, (GLsizei)array.layers);
+        for (size_t level = 0; level < array.levels; level++)
+        {
+            int width = mipLevelWidth(array.width, (int)level), height = mipLevelHeight(array.height, (int)level);
+            if (group.compressed)
+            {
+                size_t bytes = compressedLevelBytes(group.blockFormat, width, height) * array.layers;
+                if (!texStorage3D)
+                    glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, array.format, width, height,
+                                           (GLsizei)array.layers, 0, (GLsizei)bytes, nullptr);
+                array.bytes += bytes;
+            }
+            else
+            {
+                if (!texStorage3D)
+                    glTexImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, array.format, width, height,
+                                 (GLsizei)array.layers, 0, array.format, GL_UNSIGNED_BYTE, nullptr);
+                size_t texelBytes = array.format == GL_RGB ? 4 : (size_t)staging.layers[group.members[0]].image.channels;
+                array.bytes += (size_t)width * height * texelBytes * array.layers;
+            }
+        }
+        TextureSampler sampler;
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, sampler.wrapS);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, sampler.wrapT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, sampler.minFilter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, sampler.magFilter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, (GLint)array.levels - 1);
+
+        for (size_t layer = 0; layer < group.members.size(); layer++)
+        {
+            set.array[group.members[layer]] = (int)set.arrays.size();
+            set.layer[group.members[layer]] = (int)layer;
+        }
+        set.arrays.push_back(array);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+// Bytes do nível level da imagem staging.paths[index]
+inline size_t textureArrayLevelBytes(const TextureArrayStaging &staging, size_t index, size_t level)
+{
+    const TextureStaging &layer = staging.layers[index];
+    return layer.compressed ? layer.blocks.levels[level].size : imageLevelBytes(layer.image, level);
+}
+
+// Bytes enviados para todas as camadas, com os níveis dos seus arrays
+inline size_t textureArrayUploadBytes(const TextureArraySet &set, const TextureArrayStaging &staging)
+{
+    size_t bytes = 0;
+    for (size_t index = 0; index < staging.paths.size(); index++)
+        if (set.array[index] >= 0)
+            for (size_t level = 0; level < set.arrays[set.array[index]].levels; level++)
+                bytes += textureArrayLevelBytes(staging, index, level);
+    return bytes;
+}
+
+// Envia todos os níveis da imagem staging.paths[index] para a sua camada
+inline void uploadTextureArrayLayer(const TextureArraySet &set, const TextureArrayStaging &staging, size_t index)
+{
+    if (set.array[index] < 0)
+        return;
+    const TextureArray &array = set.arrays[set.array[index]];
+    const TextureStaging &layer = staging.layers[index];
+    GLint z = set.layer[index];
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t level = 0; level < array.levels; level++)
+    {
+        if (layer.compressed)
+        {
+            const CompressedLevelView &view = layer.blocks.levels[level];
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, 0, 0, z, view.width, view.height, 1,
+                                      array.format, (GLsizei)view.size, view.data);
+        }
+        else
+        {
+            const ImageLevel &view = layer.image.levels[level];
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, 0, 0, z, view.width, view.height, 1, array.format,
+                            GL_UNSIGNED_BYTE, view.pixels);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+// Cria os arrays e envia todas as camadas de uma vez
+inline void uploadTextureArrays(TextureArraySet &set, const TextureArrayStaging &staging)
+{
+    beginTextureArrays(set, staging);
+    for (size_t i = 0; i < staging.paths.size(); i++)
+        uploadTextureArrayLayer(set, staging, i);
+}
+
+// Aponta diffuseTexture/diffuseLayer de cada material para o array e a camada do
+// seu map_Kd (0 e -1 quando o arquivo não está em set)
+inline void assignMaterialLayers(const TextureArraySet &set, MaterialLibrary &library)
+{
+    for (Material &material : library.materials)
+    {
+        material.diffuseTexture = 0;
+        material.diffuseLayer = -1;
+        if (material.diffuseMap.empty())
+            continue;
+        auto found = std::find(set.paths.begin(), set.paths.end(), canonicalTexturePath(material.diffuseMap));
+        size_t index = (size_t)(found - set.paths.begin());
+        if (found == set.paths.end() || set.array[index] < 0)
+            continue;
+        material.diffuseTexture = set.arrays[set.array[index]].texture;
+        material.diffuseLayer = set.layer[index];
+    }
+}
+
+inline void printTextureArrays(const TextureArraySet &set)
+{
+    size_t total = 0;
+    for (const TextureArray &array : set.arrays)
+    {
+        std::cout << "  array " << array.texture << ": " << array.layers << " camadas " << array.width << "x"
+                  << array.height << " " << textureFormatName(array.format) << ", " << array.bytes / 1024 << " KB"
+                  << std::endl;
+        total += array.bytes;
+    }
+    std::cout << "Texturas em " << set.arrays.size() << " arrays: " << total / 1024 << " KB" << std::endl;
+}
+
+// Empacota as texturas map_Kd da tabela e aponta os materiais para as camadas (na
+// thread da OpenGL, sem dividir o envio entre quadros). Nada é refeito se os arquivos
+// são os mesmos do último empacotamento; devolve true se os arrays foram recriados
+inline bool packMaterialTextures(TextureArraySet &set, MaterialLibrary &library, ImageLoadFunction decode,
+                                 ImageFreeFunction freeImage, const TextureCompressionSupport &support, bool compress,
+                                 const std::string &settings = "")
+{
+    TextureArrayStaging staging;
+    staging.paths = materialTexturePaths(library);
+    bool repack = staging.paths != set.paths;
+    if (repack)
+    {
+        loadTextureArrayStaging(staging, decode, freeImage, support, compress, settings);
+        uploadTextureArrays(set, staging);
+        printTextureArrays(set);
+    }
+    assignMaterialLayers(set, library);
+    return repack;
+}
@@ -0,0 +1,421 @@
+/*
+ *  TextureCompression.h
+ *
+ *  Compressão de texturas em blocos de 4x4 texels (formatos BCn / S3TC), feita
+ *  na CPU e sem OpenGL, para rodar nas threads de carga:
+ *
+ *  BC1 (DXT1)  8 bytes por bloco (0,5 byte por texel, 1/8 do RGBA8): duas cores
+ *              RGB 565 nas pontas de uma reta e 2 bits por texel escolhendo uma
+ *              das 4 cores da reta. Sem transparência.
+ *  BC3 (DXT5)  16 bytes por bloco (1/4 do RGBA8): um bloco de alfa (dois valores
+ *              de 8 bits e 3 bits por texel) seguido de um bloco de cor como o BC1.
+ *  BC7         só leitura/envio (arquivos .ktx2 gerados por outras ferramentas);
+ *              não há codificador aqui.
+ *
+ *  As pontas de cada bloco seguem o eixo principal das cores (covariância +
+ *  iteração de potência), são recolhidas um pouco para dentro e refinadas uma
+ *  vez por mínimos quadrados com os índices escolhidos. A cadeia de mipmaps vem
+ *  de Mipmap.h (Kaiser, sRGB por padrão) até 1x1, e cada nível é codificado em
+ *  faixas de blocos em paralelo.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  std::vector<unsigned char> rgba = expandToRGBA(pixels, width, height, channels);
+ *  BlockFormat format = imageHasAlpha(rgba) ? BLOCK_BC3 : BLOCK_BC1;
+ *  std::vector<CompressedLevel> levels = compressMipChain(rgba, width, height, format);
+ *  // levels[0].data: width x height em blocos; levels.back(): 1x1
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "Mipmap.h"
+
+enum BlockFormat
+{
+    BLOCK_BC1,
+    BLOCK_BC3,
+    BLOCK_BC7
+};
+
+// Um nível de mipmap já comprimido
+struct CompressedLevel
+{
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> data;
+};
+
+inline size_t blockBytes(BlockFormat format)
+{
+    return format == BLOCK_BC1 ? 8 : 16;
+}
+
+inline size_t compressedLevelBytes(BlockFormat format, int width, int height)
+{
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+}
+
+inline const char *blockFormatName(BlockFormat format)
+{
+    const char *names[3] = {"BC1", "BC3", "BC7"};
+    return names[format];
+}
+
+// 1 a 4 canais -> RGBA (cinza vira R = G = B; alfa ausente vira 255)
+inline std::vector<unsigned char> expandToRGBA(const unsigned char *pixels, int width, int height, int channels)
+{
+    size_t count = (size_t)width * height;
+    std::vector<unsigned char> rgba(count * 4);
+    for (size_t i = 0; i < count; i++)
+    {
+        const unsigned char *in = pixels + i * channels;
+        unsigned char *out = &rgba[i * 4];
+        if (channels <= 2)
+            out[0] = out[1] = out[2] = in[0];
+        else
+        {
+            out[0] = in[0];
+            out[1] = in[1];
+            out[2] = in[2];
+        }
+        out[3] = channels == 2 ? in[1] : channels == 4 ? in[3] : 255;
+    }
+    return rgba;
+}
+
+inline bool imageHasAlpha(const std::vector<unsigned char> &rgba)
+{
+    for (size_t i = 3; i < rgba.size(); i += 4)
+        if (rgba[i] != 255)
+            return true;
+    return false;
+}
+
+inline uint16_t packRGB565(const float color[3])
+{
+    int r = std::clamp((int)std::lround(color[0] * 31.0f / 255.0f), 0, 31);
+    int g = std::clamp((int)std::lround(color[1] * 63.0f / 255.0f), 0, 63);
+    int b = std::clamp((int)std::lround(color[2] * 31.0f / 255.0f), 0, 31);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+inline void unpackRGB565(uint16_t color, int rgb[3])
+{
+    int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// As 4 cores de um bloco de cor; com c0 <= c1 e threeColor, a 4ª é preto transparente (BC1)
+inline void colorPalette(uint16_t c0, uint16_t c1, bool threeColor, int palette[4][4])
+{
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    for (int c = 0; c < 3; c++)
+    {
+        if (threeColor && c0 <= c1)
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+        else
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+    palette[3][3] = threeColor && c0 <= c1 ? 0 : 255;
+}
+
+inline uint32_t chooseColorIndices(const unsigned char block[64], uint16_t c0, uint16_t c1)
+{
+    int palette[4][4];
+    colorPalette(c0, c1, false, palette);
+    uint32_t indices = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        const unsigned char *texel = block + i * 4;
+        int best = 0, bestError = 1 << 30;
+        for (int p = 0; p < 4; p++)
+        {
+            int dr = texel[0] - palette[p][0], dg = texel[1] - palette[p][1], db = texel[2] - palette[p][2];
+            int error = dr * dr + dg * dg + db * db;
+            if (error < bestError)
+            {
+                best = p;
+                bestError = error;
+            }
+        }
+        indices |= (uint32_t)best << (i * 2);
+    }
+    return indices;
+}
+
+// Pontas que minimizam o erro para os índices dados (peso de cada ponta por texel: 1, 0, 2/3, 1/3)
+inline bool refineColorEndpoints(const unsigned char block[64], uint32_t indices, float end0[3], float end1[3])
+{
+    const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f, ax[3] = {}, bx[3] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        float a = weights[(indices >> (i * 2)) & 3], b = 1.0f - a;
+        aa += a * a;
+        bb += b * b;
+        ab += a * b;
+        for (int c = 0; c < 3; c++)
+        {
+            ax[c] += a * block[i * 4 + c];
+            bx[c] += b * block[i * 4 + c];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f)
+        return false;
+    for (int c = 0; c < 3; c++)
+    {
+        end0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+        end1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+inline void writeColorBlock(uint16_t c0, uint16_t c1, uint32_t indices, unsigned char out[8])
+{
+    out[0] = (unsigned char)(c0 & 0xFF);
+    out[1] = (unsigned char)(c0 >> 8);
+    out[2] = (unsigned char)(c1 & 0xFF);
+    out[3] = (unsigned char)(c1 >> 8);
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (unsigned char)(indices >> (i * 8));
+}
+
+// Bloco de cor (BC1 opaco ou a parte de cor do BC3) de 16 texels RGBA
+inline void encodeColorBlock(const unsigned char block[64], unsigned char out[8])
+{
+    float mean[3] = {}, low[3] = {255.0f, 255.0f, 255.0f}, high[3] = {};
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++)
+        {
+            float value = block[i * 4 + c];
+            mean[c] += value / 16.0f;
+            low[c] = std::min(low[c], value);
+            high[c] = std::max(high[c], value);
+        }
+
+    float covariance[6] = {};  // rr rg rb gg gb bb
+    for (int i = 0; i < 16; i++)
+    {
+        float r = block[i * 4] - mean[0], g = block[i * 4 + 1] - mean[1], b = block[i * 4 + 2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    // Eixo principal por iteração de potência, a partir da diagonal da caixa das cores
+    float axis[3] = {high[0] - low[0], high[1] - low[1], high[2] - low[2]};
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[3] = {covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+                         covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+                         covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]};
+        float length = std::max({std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2])});
+        if (length < 1e-6f)
+            break;
+        for (int c = 0; c < 3; c++)
+            axis[c] = next[c] / length;
+    }
+
+    float minT = 0.0f, maxT = 0.0f;
+    for (int i = 0; i < 16; i++)
+    {
+        float t = (block[i * 4] - mean[0]) * axis[0] + (block[i * 4 + 1] - mean[1]) * axis[1] +
+                  (block[i * 4 + 2] - mean[2]) * axis[2];
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    float axisLength2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    float end0[3], end1[3];
+    for (int c = 0; c < 3; c++)
+    {
+        float scale = axisLength2 > 1e-12f ? axis[c] / axisLength2 : 0.0f;
+        float inset = (maxT - minT) * scale / 16.0f;  // recolhe 1/16 para dentro: menos erro médio
+        end0[c] = std::clamp(mean[c] + maxT * scale - inset, 0.0f, 255.0f);
+        end1[c] = std::clamp(mean[c] + minT * scale + inset, 0.0f, 255.0f);
+    }
+
+    uint16_t c0 = packRGB565(end0), c1 = packRGB565(end1);
+    uint32_t indices = chooseColorIndices(block, c0, c1);
+    if (c0 != c1 && refineColorEndpoints(block, indices, end0, end1))
+    {
+        uint16_t r0 = packRGB565(end0), r1 = packRGB565(end1);
+        if (r0 != r1)
+        {
+            c0 = r0;
+            c1 = r1;
+            indices = chooseColorIndices(block, c0, c1);
+        }
+    }
+
+    // Modo de 4 cores exige c0 > c1: trocar as pontas troca 0 <-> 1 e 2 <-> 3
+    if (c0 < c1)
+    {
+        std::swap(c0, c1);
+        indices ^= 0x55555555;
+    }
+    else if (c0 == c1)
+        indices = 0;
+    writeColorBlock(c0, c1, indices, out);
+}
+
+// Bloco de alfa do BC3: a0 = maior, a1 = menor, 6 valores intermediários
+inline void encodeAlphaBlock(const unsigned char block[64], unsigned char out[8])
+{
+    int a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; i++)
+    {
+        a0 = std::max(a0, (int)block[i * 4 + 3]);
+        a1 = std::min(a1, (int)block[i * 4 + 3]);
+    }
+    out[0] = (unsigned char)a0;
+    out[1] = (unsigned char)a1;
+    uint64_t indices = 0;
+    if (a0 > a1)
+        for (int i = 0; i < 16; i++)
+        {
+            // Posição na reta de a0 (0) a a1 (7), arredondada, convertida para a ordem do formato
+            int step = (int)std::lround((a0 - block[i * 4 + 3]) * 7.0f / (a0 - a1));
+            uint64_t index = step == 0 ? 0 : step == 7 ? 1 : (uint64_t)step + 1;
+            indices |= index << (i * 3);
+        }
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (unsigned char)(indices >> (i * 8));
+}
+
+// Copia o bloco (bx, by) de 4x4 texels; fora da imagem repete a última coluna/linha
+inline void extractBlock(const unsigned char *rgba, int width, int height, int bx, int by, unsigned char block[64])
+{
+    for (int y = 0; y < 4; y++)
+        for (int x = 0; x < 4; x++)
+        {
+            int sx = std::min(bx * 4 + x, width - 1), sy = std::min(by * 4 + y, height - 1);
+            memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+        }
+}
+
+// Comprime um nível RGBA; faixas de linhas de blocos vão para threads diferentes
+inline std::vector<unsigned char> compressRGBA(const unsigned char *rgba, int width, int height, BlockFormat format,
+                                               unsigned threadCount = 0)
+{
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t stride = blockBytes(format);
+    std::vector<unsigned char> out(compressedLevelBytes(format, width, height));
+    auto encodeRows = [&](int firstRow, int lastRow)
+    {
+        unsigned char block[64];
+        for (int by = firstRow; by < lastRow; by++)
+            for (int bx = 0; bx < blocksX; bx++)
+            {
+                unsigned char *target = &out[((size_t)by * blocksX + bx) * stride];
+                extractBlock(rgba, width, height, bx, by, block);
+                if (format == BLOCK_BC3)
+                {
+                    encodeAlphaBlock(block, target);
+                    target += 8;
+                }
+                encodeColorBlock(block, target);
+            }
+    };
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min<unsigned>(threadCount, (unsigned)std::max(1, blocksY / 16));
+    if (threadCount <= 1)
+    {
+        encodeRows(0, blocksY);
+        return out;
+    }
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadCount; t++)
+        threads.emplace_back(encodeRows, (int)(blocksY * t / threadCount), (int)(blocksY * (t + 1) / threadCount));
+    for (std::thread &thread : threads)
+        thread.join();
+    return out;
+}
+
+// Cadeia completa (até 1x1, mipmaps de Mipmap.h) comprimida no formato pedido (BC1 ou BC3)
+inline std::vector<CompressedLevel> compressMipChain(const std::vector<unsigned char> &rgba, int width, int height,
+                                                     BlockFormat format, const MipSettings &mips = MipSettings())
+{
+    std::vector<unsigned char> chain = buildMipChain(rgba.data(), width, height, 4, mips);
+    std::vector<CompressedLevel> levels;
+    const unsigned char *pixels = rgba.data();
+    for (int i = 0; i < mipLevelCount(width, height); i++)
+    {
+        CompressedLevel level;
+        level.width = mipLevelWidth(width, i);
+        level.height = mipLevelHeight(height, i);
+        level.data = compressRGBA(pixels, level.width, level.height, format);
+        pixels = i == 0 ? chain.data() : pixels + (size_t)level.width * level.height * 4;
+        levels.push_back(std::move(level));
+    }
+    return levels;
+}
+
+// Descomprime um nível BC1 ou BC3 para RGBA (envio quando a GPU não aceita o formato)
+inline std::vector<unsigned char> decompressToRGBA(const unsigned char *data, int width, int height, BlockFormat format)
+{
+    std::vector<unsigned char> rgba((size_t)width * height * 4);
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t stride = blockBytes(format);
+    for (int by = 0; by < blocksY; by++)
+        for (int bx = 0; bx < blocksX; bx++)
+        {
+            const unsigned char *block = data + ((size_t)by * blocksX + bx) * stride;
+            int alpha[8] = {255, 255, 255, 255, 255, 255, 255, 255};
+            uint64_t alphaIndices = 0;
+            if (format == BLOCK_BC3)
+            {
+                alpha[0] = block[0];
+                alpha[1] = block[1];
+                for (int i = 1; i <= 6; i++)
+                    alpha[i + 1] = alpha[0] > alpha[1] ? ((7 - i) * alpha[0] + i * alpha[1]) / 7
+                                   : i <= 4        ? ((5 - i) * alpha[0] + i * alpha[1]) / 5
+                                   : i == 5        ? 0
+                                                   : 255;
+                for (int i = 0; i < 6; i++)
+                    alphaIndices |= (uint64_t)block[2 + i] << (i * 8);
+                block += 8;
+            }
+
+            uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8)), c1 = (uint16_t)(block[2] | (block[3] << 8));
+            uint32_t indices = (uint32_t)(block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24));
+            int palette[4][4];
+            colorPalette(c0, c1, format == BLOCK_BC1, palette);
+            for (int i = 0; i < 16; i++)
+            {
+                int x = bx * 4 + i % 4, y = by * 4 + i / 4;
+                if (x >= width || y >= height)
+                    continue;
+                unsigned char *texel = &rgba[((size_t)y * width + x) * 4];
+                const int *color = palette[(indices >> (i * 2)) & 3];
+                texel[0] = (unsigned char)color[0];
+                texel[1] = (unsigned char)color[1];
+                texel[2] = (unsigned char)color[2];
+                texel[3] = (unsigned char)(format == BLOCK_BC3 ? alpha[(alphaIndices >> (i * 3)) & 7] : color[3]);
+            }
+        }
+    return rgba;
+}
@@ -0,0 +1,520 @@
+/*
+ *  TextureRegistry.h
+ *
+ *  Tabela das texturas da OpenGL de um programa, chaveada pelo caminho canônico
+ *  do arquivo, pelos parâmetros de amostragem (TextureSampler) e pelas opções de
+ *  importação da imagem (ex.: "flip"). Pedir de novo a mesma textura, por
+ *  qualquer caminho que leve ao mesmo arquivo, devolve o objeto já criado em vez
+ *  de ler e enviar a imagem outra vez.
+ *
+ *  Cada entrada tem contagem de referências e é identificada por um
+ *  TextureHandle (índice + geração): um handle de uma textura já apagada deixa de
+ *  ser válido mesmo que o índice seja reaproveitado. Quando a contagem chega a
+ *  zero a textura não é apagada na hora: ela espera freeDelayFrames chamadas de
+ *  updateTextureRegistry, e um novo pedido nesse intervalo a recupera sem
+ *  recarregar. printTextureMemory lista as texturas residentes e a memória de
+ *  vídeo estimada (níveis de mipmap incluídos).
+ *
+ *  Os mipmaps vêm prontos do cache (Mipmap.h), nível por nível, sem
+ *  glGenerateMipmap. Com compressTextures (o padrão), as imagens vão para a GPU
+ *  comprimidas em blocos (KTX2.h): BC1 ou BC3, 4 a 8 vezes menos memória que
+ *  RGBA8, enviadas com glCompressedTexImage2D. Um arquivo .ktx2 pode
+ *  ser pedido direto (inclusive BC7). Sem GL_EXT_texture_compression_s3tc (ou
+ *  GL_ARB_texture_compression_bptc para BC7) a textura é enviada sem compressão.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  TextureRegistry textures;
+ *  TextureHandle wall = acquireTexture(textures, "../assets/tex/pixelWall.png", loadImage, stbi_image_free);
+ *  glBindTexture(GL_TEXTURE_2D, textureObject(textures, wall));
+ *  updateTextureRegistry(textures);       // uma vez por quadro
+ *  releaseTexture(textures, wall);        // apagada alguns quadros depois, se ninguém pedir de novo
+ *  destroyTextureRegistry(textures);
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "GLExtensions.h"
+#include "ImageCache.h"
+#include "KTX2.h"
+
+// Enums das extensões de compressão (o glad do projeto só tem o núcleo 4.0)
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
+
+const uint32_t TEXTURE_FREE_DELAY_FRAMES = 120;  // ~2 s a 60 quadros por segundo
+
+struct TextureSampler
+{
+    GLint wrapS = GL_REPEAT;
+    GLint wrapT = GL_REPEAT;
+    GLint minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLint magFilter = GL_LINEAR;
+};
+
+struct TextureHandle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0;  // 0: handle vazio
+};
+
+struct TextureEntry
+{
+    std::string key;
+    std::string path;  // caminho canônico
+    GLuint texture = 0;
+    TextureSampler sampler;
+    int width = 0;  // 0 até a imagem ser enviada
+    int height = 0;
+    GLenum format = 0;  // formato interno (GL_RGB, GL_COMPRESSED_RGB_S3TC_DXT1_EXT...)
+    size_t bytes = 0;   // memória de vídeo estimada, mipmaps incluídos
+    uint32_t refs = 0;
+    uint32_t generation = 1;
+    uint64_t releasedFrame = 0;  // quadro em que refs chegou a zero
+};
+
+// Formatos comprimidos aceitos pelo driver (queryTextureCompressionSupport)
+struct TextureCompressionSupport
+{
+    bool s3tc = false;  // BC1 e BC3
+    bool bptc = false;  // BC7
+};
+
+// Imagem pronta para o envio: blocos comprimidos ou pixels sem compressão
+struct TextureStaging
+{
+    bool compressed = false;
+    ImageStaging image;
+    CompressedTextureStaging blocks;
+};
+
+struct TextureRegistry
+{
+    std::vector<TextureEntry> entries;
+    std::vector<uint32_t> freeEntries;  // índices de entradas apagadas, para reaproveitar
+    std::unordered_map<std::string, uint32_t> byKey;
+    uint64_t frame = 0;
+    uint32_t freeDelayFrames = TEXTURE_FREE_DELAY_FRAMES;
+    bool compressTextures = true;  // comprime imagens comuns em BC1/BC3 quando o driver aceita
+    bool supportQueried = false;
+    TextureCompressionSupport support;
+};
+
+inline bool textureUsesMipmaps(const TextureSampler &sampler)
+{
+    return sampler.minFilter != GL_NEAREST && sampler.minFilter != GL_LINEAR;
+}
+
+// Precisa de um contexto da OpenGL atual
+inline TextureCompressionSupport queryTextureCompressionSupport()
+{
+    TextureCompressionSupport support;
+    support.s3tc = hasGLExtension("GL_EXT_texture_compression_s3tc");
+    support.bptc = hasGLVersion(4, 2) || hasGLExtension("GL_ARB_texture_compression_bptc");
+    return support;
+}
+
+// Consultado uma vez, na primeira textura criada
+inline const TextureCompressionSupport &textureCompressionSupport(TextureRegistry &registry)
+{
+    if (!registry.supportQueried)
+    {
+        registry.support = queryTextureCompressionSupport();
+        registry.supportQueried = true;
+    }
+    return registry.support;
+}
+
+inline bool isBlockFormatSupported(const TextureCompressionSupport &support, BlockFormat format)
+{
+    return format == BLOCK_BC7 ? support.bptc : support.s3tc;
+}
+
+inline GLenum compressedTextureFormat(BlockFormat format, bool srgb)
+{
+    if (format == BLOCK_BC1)
+        return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    if (format == BLOCK_BC3)
+        return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+}
+
+inline const char *textureFormatName(GLenum format)
+{
+    switch (format)
+    {
+    case GL_RED:
+        return "R8";
+    case GL_RG:
+        return "RG8";
+    case GL_RGB:
+        return "RGB8";
+    case GL_RGBA:
+        return "RGBA8";
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        return "BC1";
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+        return "BC3";
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+        return "BC7";
+    default:
+        return "?";
+    }
+}
+
+inline GLenum imageTextureFormat(int channels)
+{
+    const GLenum formats[4] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+    return formats[channels - 1];
+}
+
+// Formato com tamanho exigido por glTexStorage2D (os comprimidos já são)
+inline GLenum sizedTextureFormat(GLenum format)
+{
+    switch (format)
+    {
+    case GL_RED:
+        return GL_R8;
+    case GL_RG:
+        return GL_RG8;
+    case GL_RGB:
+        return GL_RGB8;
+    case GL_RGBA:
+        return GL_RGBA8;
+    default:
+        return format;
+    }
+}
+
+// Níveis sem compressão que vão para a GPU: a cadeia inteira, ou só o maior sem mipmaps
+inline size_t imageLevelCount(const ImageStaging &image, const TextureSampler &sampler)
+{
+    return textureUsesMipmaps(sampler) ? image.levels.size() : std::min<size_t>(1, image.levels.size());
+}
+
+// Memória de vídeo estimada sem compressão: 1 byte por canal (RGB ocupa 4 na maioria
+// dos drivers) em cada nível enviado
+inline size_t imageTextureBytes(const ImageStaging &image, const TextureSampler &sampler)
+{
+    size_t texelBytes = image.channels == 3 ? 4 : (size_t)image.channels, bytes = 0;
+    for (size_t i = 0; i < imageLevelCount(image, sampler); i++)
+        bytes += (size_t)image.levels[i].width * image.levels[i].height * texelBytes;
+    return bytes;
+}
+
+// Níveis comprimidos que vão para a GPU: a cadeia inteira, ou só o maior sem mipmaps
+inline size_t compressedLevelCount(const CompressedTextureStaging &blocks, const TextureSampler &sampler)
+{
+    return textureUsesMipmaps(sampler) ? blocks.levels.size() : std::min<size_t>(1, blocks.levels.size());
+}
+
+inline size_t compressedTextureBytes(const CompressedTextureStaging &blocks, const TextureSampler &sampler)
+{
+    size_t bytes = 0;
+    for (size_t i = 0; i < compressedLevelCount(blocks, sampler); i++)
+        bytes += blocks.levels[i].size;
+    return bytes;
+}
+
+// Parte do carregamento que não usa OpenGL (pode rodar nas threads de AssetLoader.h).
+// Com compress e suporte do driver, a imagem vem comprimida (KTX2.h); senão sem
+// compressão (ImageCache.h). Um .ktx2 que o driver não aceita é descomprimido na
+// CPU (BC1/BC3; BC7 não tem volta e falha)
+inline bool loadTextureStaging(const std::string &path, ImageLoadFunction decode, ImageFreeFunction freeImage,
+                               const TextureCompressionSupport &support, bool compress, TextureStaging &staging,
+                               const std::string &settings = "")
+{
+    CompressedTextureStaging &blocks = staging.blocks;
+    if (isKTX2Path(path))
+    {
+        if (!loadKTX2File(path, blocks))
+            return false;
+        staging.compressed = isBlockFormatSupported(support, blocks.format);
+        if (staging.compressed)
+            return true;
+        if (blocks.format == BLOCK_BC7)
+        {
+            std::cerr << "A textura " << path << " usa BC7, que o driver nao aceita" << std::endl;
+            return false;
+        }
+        ImageStaging &image = staging.image;
+        image.width = blocks.levels[0].width;
+        image.height = blocks.levels[0].height;
+        image.channels = 4;
+        image.owned = decompressToRGBA(blocks.levels[0].data, image.width, image.height, blocks.format);
+        image.pixels = image.owned.data();
+        generateImageMips(image, MipSettings());
+        blocks.file.close();
+        blocks.levels.clear();
+        return true;
+    }
+
+    staging.compressed = compress && support.s3tc;
+    if (staging.compressed)
+        return loadCompressedTextureStaging(path, decode, freeImage, blocks, settings);
+    return loadImageStaging(path, decode, freeImage, staging.image, settings);
+}
+
+inline std::string canonicalTexturePath(const std::string &path)
+{
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+    return error ? std::filesystem::absolute(path).lexically_normal().string() : canonical.string();
+}
+
+inline std::string textureKey(const std::string &canonicalPath, const TextureSampler &sampler,
+                              const std::string &settings)
+{
+    return canonicalPath + "|" + std::to_string(sampler.wrapS) + "," + std::to_string(sampler.wrapT) + "," +
+           std::to_string(sampler.minFilter) + "," + std::to_string(sampler.magFilter) + "|" + settings;
+}
+
+// Aplica a amostragem na textura ligada em GL_TEXTURE_2D
+inline void applyTextureSampler(const TextureSampler &sampler)
+{
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, sampler.wrapS);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, sampler.wrapT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, sampler.minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, sampler.magFilter);
+}
+
+inline TextureEntry *textureEntry(TextureRegistry &registry, TextureHandle handle)
+{
+    if (handle.generation == 0 || handle.index >= registry.entries.size())
+        return nullptr;
+    TextureEntry &entry = registry.entries[handle.index];
+    return entry.generation == handle.generation && entry.texture != 0 ? &entry : nullptr;
+}
+
+inline bool isTextureHandleValid(TextureRegistry &registry, TextureHandle handle)
+{
+    return textureEntry(registry, handle) != nullptr;
+}
+
+// Objeto da OpenGL do handle (0 se o handle não vale mais)
+inline GLuint textureObject(TextureRegistry &registry, TextureHandle handle)
+{
+    TextureEntry *entry = textureEntry(registry, handle);
+    return entry ? entry->texture : 0;
+}
+
+// Procura a textura sem mudar a contagem de referências (handle vazio se não existe)
+inline TextureHandle findTexture(TextureRegistry &registry, const std::string &path,
+                                 const TextureSampler &sampler = TextureSampler(), const std::string &settings = "")
+{
+    auto found = registry.byKey.find(textureKey(canonicalTexturePath(path), sampler, settings));
+    if (found == registry.byKey.end())
+        return TextureHandle();
+    return {found->second, registry.entries[found->second].generation};
+}
+
+inline void retainTexture(TextureRegistry &registry, TextureHandle handle)
+{
+    if (TextureEntry *entry = textureEntry(registry, handle))
+        entry->refs++;
+}
+
+// Com refs em zero a textura só é apagada por updateTextureRegistry, freeDelayFrames quadros depois
+inline void releaseTexture(TextureRegistry &registry, TextureHandle handle)
+{
+    TextureEntry *entry = textureEntry(registry, handle);
+    if (!entry || entry->refs == 0)
+        return;
+    if (--entry->refs == 0)
+        entry->releasedFrame = registry.frame;
+}
+
+// Nova entrada (refs = 1) com o objeto da OpenGL criado e a amostragem aplicada, ainda sem imagem
+inline TextureHandle createTexture(TextureRegistry &registry, const std::string &path,
+                                   const TextureSampler &sampler = TextureSampler(), const std::string &settings = "")
+{
+    uint32_t index;
+    if (registry.freeEntries.empty())
+    {
+        index = (uint32_t)registry.entries.size();
+        registry.entries.emplace_back();
+    }
+    else
+    {
+        index = registry.freeEntries.back();
+        registry.freeEntries.pop_back();
+    }
+
+    TextureEntry &entry = registry.entries[index];
+    entry.path = canonicalTexturePath(path);
+    entry.key = textureKey(entry.path, sampler, settings);
+    entry.sampler = sampler;
+    entry.width = entry.height = 0;
+    entry.format = 0;
+    entry.bytes = 0;
+    entry.refs = 1;
+    glGenTextures(1, &entry.texture);
+    glBindTexture(GL_TEXTURE_2D, entry.texture);
+    applyTextureSampler(sampler);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    registry.byKey[entry.key] = index;
+    return {index, entry.generation};
+}
+
+// Dimensões, formato e memória da imagem enviada para a textura (usados no relatório de memória)
+inline void setTextureImage(TextureRegistry &registry, TextureHandle handle, int width, int height, GLenum format,
+                            size_t bytes)
+{
+    if (TextureEntry *entry = textureEntry(registry, handle))
+    {
+        entry->width = width;
+        entry->height = height;
+        entry->format = format;
+        entry->bytes = bytes;
+    }
+}
+
+// Limita a amostragem aos níveis enviados
+inline void setTextureLevelRange(size_t levelCount)
+{
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levelCount - 1);
+}
+
+// Envia a imagem inteira, com os mipmaps já prontos, para a textura ligada em GL_TEXTURE_2D
+inline void uploadTextureImage(const ImageStaging &image, const TextureSampler &sampler)
+{
+    GLenum format = imageTextureFormat(image.channels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t level = 0; level < imageLevelCount(image, sampler); level++)
+    {
+        const ImageLevel &view = image.levels[level];
+        glTexImage2D(GL_TEXTURE_2D, (GLint)level, format, view.width, view.height, 0, format, GL_UNSIGNED_BYTE,
+                     view.pixels);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    setTextureLevelRange(imageLevelCount(image, sampler));
+}
+
+// Envia um nível comprimido para a textura ligada em GL_TEXTURE_2D
+inline void uploadCompressedLevel(const CompressedTextureStaging &blocks, size_t level)
+{
+    const CompressedLevelView &view = blocks.levels[level];
+    glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, compressedTextureFormat(blocks.format, blocks.srgb),
+                           view.width, view.height, 0, (GLsizei)view.size, view.data);
+}
+
+// Envia a imagem (comprimida ou não) para a textura ligada em GL_TEXTURE_2D e
+// registra dimensões, formato e memória
+inline void uploadTextureStaging(TextureRegistry &registry, TextureHandle handle, const TextureStaging &staging,
+                                 const TextureSampler &sampler)
+{
+    if (!staging.compressed)
+    {
+        const ImageStaging &image = staging.image;
+        uploadTextureImage(image, sampler);
+        setTextureImage(registry, handle, image.width, image.height, imageTextureFormat(image.channels),
+                        imageTextureBytes(image, sampler));
+        return;
+    }
+    const CompressedTextureStaging &blocks = staging.blocks;
+    for (size_t level = 0; level < compressedLevelCount(blocks, sampler); level++)
+        uploadCompressedLevel(blocks, level);
+    setTextureLevelRange(compressedLevelCount(blocks, sampler));  // a cadeia do .ktx2 pode não chegar a 1x1
+    setTextureImage(registry, handle, blocks.levels[0].width, blocks.levels[0].height,
+                    compressedTextureFormat(blocks.format, blocks.srgb), compressedTextureBytes(blocks, sampler));
+}
+
+// Devolve a textura já registrada (mais uma referência) ou lê a imagem (KTX2.h ou
+// ImageCache.h) e cria a textura. Se a imagem não puder ser lida, o handle vale, mas a textura fica vazia
+inline TextureHandle acquireTexture(TextureRegistry &registry, const std::string &path, ImageLoadFunction decode,
+                                    ImageFreeFunction freeImage, const TextureSampler &sampler = TextureSampler(),
+                                    const std::string &settings = "")
+{
+    TextureHandle handle = findTexture(registry, path, sampler, settings);
+    if (handle.generation != 0)
+    {
+        retainTexture(registry, handle);
+        return handle;
+    }
+
+    handle = createTexture(registry, path, sampler, settings);
+    TextureStaging staging;
+    if (loadTextureStaging(path, decode, freeImage, textureCompressionSupport(registry), registry.compressTextures,
+                           staging, settings))
+    {
+        glBindTexture(GL_TEXTURE_2D, textureObject(registry, handle));
+        uploadTextureStaging(registry, handle, staging, sampler);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    return handle;
+}
+
+inline void deleteTextureEntry(TextureRegistry &registry, uint32_t index)
+{
+    TextureEntry &entry = registry.entries[index];
+    glDeleteTextures(1, &entry.texture);
+    registry.byKey.erase(entry.key);
+    entry.texture = 0;
+    entry.key.clear();
+    entry.path.clear();
+    entry.generation++;
+    registry.freeEntries.push_back(index);
+}
+
+// Avança um quadro e apaga as texturas sem referências há freeDelayFrames quadros
+inline void updateTextureRegistry(TextureRegistry &registry)
+{
+    registry.frame++;
+    for (uint32_t i = 0; i < registry.entries.size(); i++)
+    {
+        const TextureEntry &entry = registry.entries[i];
+        if (entry.texture != 0 && entry.refs == 0 && registry.frame - entry.releasedFrame >= registry.freeDelayFrames)
+            deleteTextureEntry(registry, i);
+    }
+}
+
+inline void printTextureMemory(const TextureRegistry &registry)
+{
+    size_t total = 0, count = 0, unused = 0;
+    for (const TextureEntry &entry : registry.entries)
+    {
+        if (entry.texture == 0)
+            continue;
+        std::cout << "  " << entry.path << ": " << entry.width << "x" << entry.height << ", "
+                  << textureFormatName(entry.format) << ", " << entry.bytes / 1024 << " KB, " << entry.refs
+                  << " referencias" << std::endl;
+        total += entry.bytes;
+        count++;
+        unused += entry.refs == 0;
+    }
+    std::cout << "Texturas residentes: " << count << " (" << unused << " sem referencias), " << total / 1024
+              << " KB" << std::endl;
+}
+
+inline void destroyTextureRegistry(TextureRegistry &registry)
+{
+    for (const TextureEntry &entry : registry.entries)
+        if (entry.texture != 0)
+            glDeleteTextures(1, &entry.texture);
+    registry = TextureRegistry();
+}
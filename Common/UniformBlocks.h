@@ -0,0 +1,127 @@
+/*
+ *  UniformBlocks.h
+ *
+ *  Uniform buffer objects (std140) com os dados que valem para o quadro inteiro:
+ *  câmera (FrameData) e luzes (LightData). Cada bloco fica em um ponto de
+ *  ligação fixo (FRAME_UNIFORMS_BINDING, LIGHT_UNIFORMS_BINDING) e é preenchido
+ *  com um glBufferSubData por quadro; todo programa que declara o bloco lê o
+ *  mesmo buffer, sem nenhum glUniform* de câmera ou de luz por programa ou por
+ *  objeto.
+ *
+ *  O GLSL 4.0 não tem layout(binding = N), então cada programa liga o bloco ao
+ *  ponto com bindUniformBlock depois do link. Os blocos declarados nos shaders
+ *  precisam ter exatamente os membros das structs abaixo, na mesma ordem:
+ *
+ *  layout (std140) uniform FrameData
+ *  {
+ *      mat4 projection;
+ *      mat4 view;
+ *      vec4 viewPos;       // xyz
+ *  };
+ *
+ *  struct Light
+ *  {
+ *      vec4 position;      // xyz; w = 1 ligada, 0 desligada
+ *      vec4 color;         // rgb; a = intensidade
+ *  };
+ *  layout (std140) uniform LightData
+ *  {
+ *      Light lights[8];    // MAX_LIGHTS
+ *      vec4 ambientLight;  // rgb
+ *      int lightCount;
+ *  };
+ *
+ *  Forma de uso
+ *  -----------------
+ *  UniformBuffer frameBuffer;
+ *  createUniformBuffer(frameBuffer, FRAME_UNIFORMS_BINDING, sizeof(FrameUniforms));
+ *  bindUniformBlock(shader, "FrameData", FRAME_UNIFORMS_BINDING);  // para cada programa
+ *  ...
+ *  FrameUniforms frame;
+ *  frame.projection = projection; frame.view = view; frame.viewPos = vec4(cameraPos, 1.0f);
+ *  updateUniformBuffer(frameBuffer, &frame, sizeof(frame));  // uma vez por quadro
+ *
+ */
+
+#pragma once
+
+#include <iostream>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+const GLuint FRAME_UNIFORMS_BINDING = 0;
+const GLuint LIGHT_UNIFORMS_BINDING = 1;
+const int MAX_LIGHTS = 8;
+
+// Espelho do bloco FrameData em std140: só mat4 e vec4, sem preenchimento implícito
+struct FrameUniforms
+{
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec4 viewPos;
+};
+
+struct LightUniform
+{
+    glm::vec4 position;  // w = 1 ligada, 0 desligada
+    glm::vec4 color;     // a = intensidade
+};
+
+// Espelho do bloco LightData; o int sozinho no fim ocupa uma linha de 16 bytes
+struct LightUniforms
+{
+    LightUniform lights[MAX_LIGHTS];
+    glm::vec4 ambientLight;
+    GLint lightCount = 0;
+    GLint padding[3] = {};
+};
+
+static_assert(sizeof(FrameUniforms) == 144, "FrameUniforms fora do layout std140");
+static_assert(sizeof(LightUniforms) == MAX_LIGHTS * 32 + 32, "LightUniforms fora do layout std140");
+
+struct UniformBuffer
+{
+    GLuint buffer = 0;
+    GLuint binding = 0;
+    GLsizeiptr size = 0;
+};
+
+inline void createUniformBuffer(UniformBuffer &ubo, GLuint binding, size_t size)
+{
+    ubo.binding = binding;
+    ubo.size = (GLsizeiptr)size;
+    glGenBuffers(1, &ubo.buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo.buffer);
+    glBufferData(GL_UNIFORM_BUFFER, ubo.size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo.buffer);
+}
+
+inline void updateUniformBuffer(const UniformBuffer &ubo, const void *data, size_t size)
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo.buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, (GLsizeiptr)size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+inline void destroyUniformBuffer(UniformBuffer &ubo)
+{
+    glDeleteBuffers(1, &ubo.buffer);
+    ubo = UniformBuffer();
+}
+
+// Liga o bloco do programa ao ponto de ligação; avisa se o programa não tem o bloco
+inline bool bindUniformBlock(const Shader &shader, const char *block, GLuint binding)
+{
+    GLuint index = glGetUniformBlockIndex(shader.program, block);
+    if (index == GL_INVALID_INDEX)
+    {
+        std::cout << "Aviso: bloco \"" << block << "\" nao existe no shader " << shader.program << std::endl;
+        return false;
+    }
+    glUniformBlockBinding(shader.program, index, binding);
+    return true;
+}
@@ -0,0 +1,156 @@
+/*
+ *  UploadRing.h
+ *
+ *  Anel de pixel buffer objects (GL_PIXEL_UNPACK_BUFFER) para enviar texturas
+ *  sem que o driver copie da memória do programa dentro de glTexSubImage2D.
+ *  Cada pedaço é copiado para uma faixa livre do anel e o glTexSubImage2D
+ *  recebe o deslocamento no PBO: a cópia para a textura fica com a GPU, em
+ *  paralelo com o desenho. Um glFenceSync depois de cada envio marca quando a
+ *  faixa pode ser reescrita; o espaço volta ao anel quando a fence sinaliza
+ *  (glClientWaitSync com tempo zero, nunca esperando).
+ *
+ *  Com glBufferStorage (GLExtensions.h) o anel é mapeado uma vez só, persistente
+ *  e coerente. Sem ele, cada faixa é mapeada com GL_MAP_UNSYNCHRONIZED_BIT (as
+ *  fences já garantem que a GPU não está lendo ali) e desmapeada após a cópia.
+ *  Se o anel estiver cheio, stageUpload devolve false e o envio fica para o
+ *  próximo quadro.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  UploadRing ring;
+ *  createUploadRing(ring, 8 << 20);
+ *  size_t offset;
+ *  if (stageUpload(ring, pixels, bytes, offset))  // deixa o anel em GL_PIXEL_UNPACK_BUFFER
+ *  {
+ *      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, largura, linhas, GL_RGBA, GL_UNSIGNED_BYTE, (const void *)offset);
+ *      finishUpload(ring);
+ *  }
+ *  destroyUploadRing(ring);
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+
+#include <glad/glad.h>
+
+#include "GLExtensions.h"
+
+const size_t UPLOAD_RING_ALIGNMENT = 64;
+
+struct UploadFence
+{
+    GLsync sync = nullptr;
+    uint64_t end = 0;  // posição do anel liberada quando a fence sinaliza
+};
+
+struct UploadRing
+{
+    GLuint buffer = 0;
+    unsigned char *mapped = nullptr;  // mapeamento persistente (nulo sem glBufferStorage)
+    size_t size = 0;
+    uint64_t head = 0;  // posições crescentes; o deslocamento no buffer é posição % size
+    uint64_t tail = 0;  // início da faixa mais antiga ainda com a GPU
+    uint64_t pending = 0;  // fim do último stageUpload ainda sem fence
+    std::deque<UploadFence> fences;
+};
+
+inline bool createUploadRing(UploadRing &ring, size_t size)
+{
+    ring.size = size;
+    glGenBuffers(1, &ring.buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring.buffer);
+    GLBufferStorageFunction bufferStorage = glExtensions().bufferStorage;
+    if (bufferStorage)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)size, nullptr, flags);
+        ring.mapped = (unsigned char *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)size, flags);
+    }
+    else
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)size, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return ring.buffer != 0 && (!bufferStorage || ring.mapped);
+}
+
+// Devolve ao anel as faixas cujas fences já sinalizaram
+inline void retireUploads(UploadRing &ring)
+{
+    while (!ring.fences.empty())
+    {
+        GLenum status = glClientWaitSync(ring.fences.front().sync, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(ring.fences.front().sync);
+        ring.tail = ring.fences.front().end;
+        ring.fences.pop_front();
+    }
+    if (ring.fences.empty())
+        ring.tail = ring.pending;
+}
+
+// Copia bytes para uma faixa livre e deixa o anel ligado em GL_PIXEL_UNPACK_BUFFER;
+// offset é o "ponteiro" para glTexSubImage2D/glCompressedTexSubImage2D. Devolve false
+// (sem esperar) quando a GPU ainda não liberou espaço suficiente
+inline bool stageUpload(UploadRing &ring, const void *data, size_t bytes, size_t &offset)
+{
+    if (ring.buffer == 0 || bytes > ring.size)
+        return false;
+    // Uma faixa não atravessa o fim do buffer
+    uint64_t start = (ring.head + UPLOAD_RING_ALIGNMENT - 1) / UPLOAD_RING_ALIGNMENT * UPLOAD_RING_ALIGNMENT;
+    if (start % ring.size + bytes > ring.size)
+        start += ring.size - start % ring.size;
+    if (start + bytes - ring.tail > ring.size)
+    {
+        retireUploads(ring);
+        if (start + bytes - ring.tail > ring.size)
+            return false;
+    }
+
+    offset = (size_t)(start % ring.size);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring.buffer);
+    if (ring.mapped)
+        memcpy(ring.mapped + offset, data, bytes);
+    else
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        void *target = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, (GLintptr)offset, (GLsizeiptr)bytes, flags);
+        if (!target)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return false;
+        }
+        memcpy(target, data, bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    ring.head = ring.pending = start + bytes;
+    return true;
+}
+
+// Depois dos comandos que leem o que stageUpload copiou: fence e desliga o anel
+inline void finishUpload(UploadRing &ring)
+{
+    UploadFence fence;
+    fence.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    fence.end = ring.pending;
+    ring.fences.push_back(fence);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+inline void destroyUploadRing(UploadRing &ring)
+{
+    for (const UploadFence &fence : ring.fences)
+        glDeleteSync(fence.sync);
+    ring.fences.clear();
+    if (ring.mapped)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring.buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &ring.buffer);
+    ring = UploadRing();
+}
@@ -0,0 +1,771 @@
+/*
+ *  LoaderBenchmark.cpp
+ *
+ *  Benchmark dos caminhos de leitura de .OBJ, sem janela nem contexto OpenGL.
+ *
+ *  Gera arquivos .OBJ sintéticos (uma superfície de altura em grade) com o número
+ *  de triângulos pedido, com ou sem vt/vn e com faces triangulares, quadradas ou
+ *  polígonos de NGON_VERTICES vértices, e mede cada leitor:
+ *
+ *  - parseOBJ:          loadOBJ em uma thread
+ *  - parseOBJParallel:  loadOBJ com todos os núcleos
+ *  - loadSimpleOBJ:     parte de CPU de loadSimpleOBJ (Code snippets/): loadOBJ +
+ *                       forEachTriangle no vetor de floats posição/cor
+ *  - streamOBJ:         openOBJStream + streamOBJTriangles (memória limitada)
+ *  - indexedMesh:       loadOBJ + repairMesh + generateNormals + buildIndexedMesh
+ *  - meshCache:         loadMeshStaging sem cache (otimização, meshlets, LODs e gravação)
+ *  - meshCacheHit:      loadMeshStaging com o cache já gravado
+ *
+ *  Cada medida roda em um processo filho (o próprio executável com --run), para
+ *  que o pico de memória (RSS) seja só daquele leitor. O resultado é um JSON com
+ *  MB/s, triângulos/s, pico de RSS e número de alocações (operator new) de cada
+ *  leitor. Com --baseline, compara os MB/s com um JSON anterior e termina com
+ *  código 1 se algum leitor ficou mais lento que a tolerância.
+ *
+ *  Acima de PIPELINE_MAX_TRIANGLES, meshCache/meshCacheHit só rodam em arquivos que
+ *  passam de OBJ_STREAM_THRESHOLD (ramo de streaming de loadMeshStaging). Quando algum
+ *  deles está na lista, um arquivo extra (bench_stream_vtvn_tri.obj) é gerado com
+ *  tamanho suficiente para passar por esse ramo.
+ *
+ *  Os caches de malha vão para bench_cache dentro da pasta dos arquivos gerados
+ *  (não para a pasta compartilhada ../cache) e são apagados no fim, exceto com --keep.
+ *  meshCache/meshCacheHit falham se a entrada gravada não existir depois da carga.
+ *
+ *  Com --check, só roda as verificações de correção de runChecks (textos .OBJ
+ *  pequenos, sem gerar arquivos) e termina com código 1 se alguma falhar.
+ *
+ *  Forma de uso
+ *  -----------------
+ *  LoaderBenchmark --triangles 1000,1000000 --attributes none,vtvn --faces tri,quad,ngon
+ *                  [--loaders parseOBJ,streamOBJ] [--dir pasta] [--output resultado.json]
+ *                  [--baseline anterior.json] [--tolerance 0.2] [--keep]
+ *  LoaderBenchmark --check
+ *
+ */
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#define popen _popen
+#define pclose _pclose
+#else
+#include <sys/resource.h>
+#endif
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "MeshCache.h"
+#include "MeshNormals.h"
+#include "MeshRepair.h"
+#include "ObjLoader.h"
+#include "ObjStream.h"
+
+const char *DEFAULT_TRIANGLES = "1000,100000,1000000";
+const char *DEFAULT_ATTRIBUTES = "none,vtvn";
+const char *DEFAULT_FACES = "tri,quad,ngon";
+const char *DEFAULT_LOADERS = "parseOBJ,parseOBJParallel,loadSimpleOBJ,streamOBJ,indexedMesh,meshCache,meshCacheHit";
+const size_t MAX_TRIANGLES = 50000000;
+const size_t PIPELINE_MAX_TRIANGLES = 2000000;  // acima disso meshCache/meshCacheHit só rodam no streaming
+const size_t STREAM_CASE_TRIANGLES = 3000000;   // estimativa inicial do arquivo de streaming
+const unsigned NGON_CELLS = 3;                  // células da grade por polígono: 2 * 3 + 2 = 8 vértices
+const size_t GENERATOR_BUFFER = 8 << 20;
+
+// Contador de alocações: todo new/new[] do processo passa por aqui
+static atomic<size_t> allocationCount(0);
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"  // o delete abaixo casa com o new abaixo
+#endif
+
+void *operator new(size_t size)
+{
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+double peakRssMegabytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);  // bytes
+#else
+    return usage.ru_maxrss / 1024.0;             // KB
+#endif
+#endif
+}
+
+vector<string> splitList(const string &list)
+{
+    vector<string> items;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+// ---------------------------------------------------------------------------
+// Gerador de .OBJ sintético
+// ---------------------------------------------------------------------------
+
+struct GeneratorOptions
+{
+    size_t triangles = 1000;
+    bool texCoords = false;
+    bool normals = false;
+    string faces = "tri";  // tri, quad ou ngon
+};
+
+// Um arquivo gerado e os leitores que rodam nele
+struct BenchmarkCase
+{
+    GeneratorOptions options;
+    string attributes;
+    string name;
+    vector<string> loaders;
+    bool stream = false;  // cresce o arquivo até passar de OBJ_STREAM_THRESHOLD
+};
+
+struct GeneratedFile
+{
+    string path;
+    size_t triangles = 0;
+    uint64_t bytes = 0;
+};
+
+// Saída com buffer próprio e std::to_chars: gerar 50M triângulos com ofstream << leva minutos
+struct ObjWriter
+{
+    FILE *file;
+    vector<char> buffer;
+    size_t used = 0;
+
+    explicit ObjWriter(FILE *f) : file(f), buffer(GENERATOR_BUFFER) {}
+
+    void reserve(size_t bytes)
+    {
+        if (used + bytes > buffer.size())
+            flush();
+    }
+
+    void flush()
+    {
+        fwrite(buffer.data(), 1, used, file);
+        used = 0;
+    }
+
+    void put(char c)
+    {
+        buffer[used++] = c;
+    }
+
+    void put(const char *text)
+    {
+        while (*text)
+            buffer[used++] = *text++;
+    }
+
+    void put(float value)
+    {
+        used = to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr - buffer.data();
+    }
+
+    void put(size_t value)
+    {
+        used = to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr - buffer.data();
+    }
+};
+
+// Índice (base 1) do vértice (x, y) da grade; vt e vn usam o mesmo índice
+void writeCorner(ObjWriter &out, const GeneratorOptions &options, size_t width, size_t x, size_t y)
+{
+    size_t index = y * (width + 1) + x + 1;
+    out.put(' ');
+    out.put(index);
+    if (options.texCoords || options.normals)
+    {
+        out.put('/');
+        if (options.texCoords)
+            out.put(index);
+        if (options.normals)
+        {
+            out.put('/');
+            out.put(index);
+        }
+    }
+}
+
+bool generateOBJ(const string &path, const GeneratorOptions &options, GeneratedFile &generated)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        cerr << "Erro ao criar o arquivo " << path << endl;
+        return false;
+    }
+
+    // Grade de width x height células com 2 triângulos cada
+    size_t cells = max<size_t>(1, (options.triangles + 1) / 2);
+    size_t width = max<size_t>(1, (size_t)sqrt((double)cells));
+    size_t height = (cells + width - 1) / width;
+    if (options.faces == "ngon")
+        width = max<size_t>(NGON_CELLS, width / NGON_CELLS * NGON_CELLS);
+    const float size = 10.0f;
+    const float step = size / max(width, height);
+
+    ObjWriter out(file);
+    out.put("# OBJ sintetico gerado por LoaderBenchmark\n");
+    for (size_t y = 0; y <= height; y++)
+        for (size_t x = 0; x <= width; x++)
+        {
+            float px = x * step, pz = y * step;
+            float h = sin(px * 1.3f) * cos(pz * 0.9f);
+            out.reserve(128);
+            out.put("v ");
+            out.put(px);
+            out.put(' ');
+            out.put(h);
+            out.put(' ');
+            out.put(pz);
+            out.put('\n');
+        }
+    if (options.texCoords)
+        for (size_t y = 0; y <= height; y++)
+            for (size_t x = 0; x <= width; x++)
+            {
+                out.reserve(64);
+                out.put("vt ");
+                out.put((float)x / width);
+                out.put(' ');
+                out.put((float)y / height);
+                out.put('\n');
+            }
+    if (options.normals)
+        for (size_t y = 0; y <= height; y++)
+            for (size_t x = 0; x <= width; x++)
+            {
+                float px = x * step, pz = y * step;
+                glm::vec3 normal = glm::normalize(glm::vec3(-1.3f * cos(px * 1.3f) * cos(pz * 0.9f), 1.0f,
+                                                            0.9f * sin(px * 1.3f) * sin(pz * 0.9f)));
+                out.reserve(128);
+                out.put("vn ");
+                out.put(normal.x);
+                out.put(' ');
+                out.put(normal.y);
+                out.put(' ');
+                out.put(normal.z);
+                out.put('\n');
+            }
+
+    // Ordem (x, y) -> (x, y + 1) -> (x + 1, y + 1) -> (x + 1, y): anti-horária vista de +y
+    size_t triangles = 0;
+    for (size_t y = 0; y < height; y++)
+        for (size_t x = 0; x < width;)
+        {
+            out.reserve(512);
+            out.put('f');
+            if (options.faces == "ngon")
+            {
+                for (size_t i = 0; i <= NGON_CELLS; i++)
+                    writeCorner(out, options, width, x + i, y + 1);
+                for (size_t i = NGON_CELLS; i > 0; i--)
+                    writeCorner(out, options, width, x + i, y);
+                writeCorner(out, options, width, x, y);
+                triangles += 2 * NGON_CELLS;
+                x += NGON_CELLS;
+            }
+            else if (options.faces == "quad")
+            {
+                writeCorner(out, options, width, x, y);
+                writeCorner(out, options, width, x, y + 1);
+                writeCorner(out, options, width, x + 1, y + 1);
+                writeCorner(out, options, width, x + 1, y);
+                triangles += 2;
+                x++;
+            }
+            else
+            {
+                writeCorner(out, options, width, x, y);
+                writeCorner(out, options, width, x, y + 1);
+                writeCorner(out, options, width, x + 1, y + 1);
+                out.put("\nf");
+                writeCorner(out, options, width, x, y);
+                writeCorner(out, options, width, x + 1, y + 1);
+                writeCorner(out, options, width, x + 1, y);
+                triangles += 2;
+                x++;
+            }
+            out.put('\n');
+        }
+    out.flush();
+    bool ok = ferror(file) == 0;
+    ok = fclose(file) == 0 && ok;
+
+    generated.path = path;
+    generated.triangles = triangles;
+    generated.bytes = ok ? filesystem::file_size(path) : 0;
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Leitores medidos (rodam no processo filho)
+// ---------------------------------------------------------------------------
+
+size_t objTriangleCount(const ObjData &obj)
+{
+    size_t triangles = 0;
+    for (uint32_t faceSize : obj.faceSizes)
+        triangles += faceSize >= 3 ? faceSize - 2 : 0;
+    return triangles;
+}
+
+size_t stagingTriangleCount(const MeshStaging &staging)
+{
+    if (!staging.mesh.lods.empty())
+        return staging.mesh.lods[0].indexCount / 3;
+    if (staging.indexCount > 0)
+        return staging.indexCount / 3;
+    return staging.stride > 0 ? staging.vertexBytes / staging.stride / 3 : 0;
+}
+
+// O que loadSimpleOBJ (Code snippets/LoadSimpleOBJ.cpp) faz antes do glBufferData: x, y, z, r, g, b
+// por vértice, sem índices
+vector<GLfloat> loadSimpleOBJBuffer(const string &path, bool &ok)
+{
+    ObjData obj;
+    vector<GLfloat> vBuffer;
+    glm::vec3 color = glm::vec3(1.0, 0.0, 0.0);
+    ok = loadOBJ(path, obj, false);
+    if (!ok)
+        return vBuffer;
+
+    auto pushCorner = [&](const ObjCorner &corner) {
+        if (obj.positions.empty())
+            return;
+        int vi = corner.v >= 0 && corner.v < (int)obj.positions.size() ? corner.v : 0;
+        vBuffer.push_back(obj.positions[vi].x);
+        vBuffer.push_back(obj.positions[vi].y);
+        vBuffer.push_back(obj.positions[vi].z);
+        vBuffer.push_back(color.r);
+        vBuffer.push_back(color.g);
+        vBuffer.push_back(color.b);
+    };
+
+    vBuffer.reserve(obj.corners.size() * 6);
+    forEachTriangle(obj, [&](const ObjCorner &a, const ObjCorner &b, const ObjCorner &c) {
+        pushCorner(a);
+        pushCorner(b);
+        pushCorner(c);
+    });
+    return vBuffer;
+}
+
+// O benchmark usa uma pasta de cache própria ao lado dos arquivos gerados, e não ../cache
+void useBenchmarkCache(const string &directory)
+{
+    assetCacheDirectory = (filesystem::path(directory) / "bench_cache").string();
+}
+
+string benchmarkMeshCachePath(const string &path)
+{
+    AssetSource source;
+    return statAssetSource(path, source) ? meshCachePath(source.hash, true) : "";
+}
+
+// Roda um leitor e informa em triangles quantos triângulos ele entregou
+bool runLoader(const string &loader, const string &path, size_t &triangles)
+{
+    if (loader == "parseOBJ" || loader == "parseOBJParallel")
+    {
+        ObjData obj;
+        if (!loadOBJ(path, obj, true, nullptr, loader == "parseOBJ" ? 1 : 0))
+            return false;
+        triangles = objTriangleCount(obj);
+        return true;
+    }
+    if (loader == "loadSimpleOBJ")
+    {
+        bool ok;
+        vector<GLfloat> vBuffer = loadSimpleOBJBuffer(path, ok);
+        triangles = vBuffer.size() / 18;  // 3 vértices de 6 floats
+        return ok;
+    }
+    if (loader == "streamOBJ")
+    {
+        ObjStream stream;
+        if (!openOBJStream(path, stream))
+            return false;
+        triangles = streamOBJTriangles(stream, [](const Vertex *, size_t) {}) / 3;
+        closeOBJStream(stream);
+        return true;
+    }
+    if (loader == "indexedMesh")
+    {
+        ObjData obj;
+        if (!loadOBJ(path, obj))
+            return false;
+        repairMesh(obj);
+        generateNormals(obj);
+        Mesh mesh = buildIndexedMesh(obj);
+        triangles = mesh.indices.size() / 3;
+        return true;
+    }
+    if (loader == "meshCache" || loader == "meshCacheHit")
+    {
+        MeshStaging staging;
+        if (!loadMeshStaging(path, true, staging))
+            return false;
+        triangles = stagingTriangleCount(staging);
+        return true;
+    }
+    cerr << "Leitor desconhecido: " << loader << endl;
+    return false;
+}
+
+// Processo filho: mede um leitor e escreve um objeto JSON em stdout
+int runChild(const string &loader, const string &path)
+{
+    // As mensagens dos leitores (std::cout) não podem se misturar com o JSON
+    streambuf *console = cout.rdbuf(nullptr);
+    useBenchmarkCache(filesystem::path(path).parent_path().string());
+    // Calculado antes da carga, para não gravar um .src novo (e rodar o trim) antes da verificação
+    string cachePath = benchmarkMeshCachePath(path);
+    error_code error;
+    if (loader == "meshCache")
+        filesystem::remove(cachePath, error);
+    else if (loader == "meshCacheHit" && !filesystem::exists(cachePath, error))
+    {
+        MeshStaging staging;
+        loadMeshStaging(path, true, staging);
+    }
+
+    size_t triangles = 0;
+    size_t allocationsBefore = allocationCount.load();
+    auto start = chrono::steady_clock::now();
+    bool ok = runLoader(loader, path, triangles);
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    size_t allocations = allocationCount.load() - allocationsBefore;
+    cout.rdbuf(console);
+    if (!ok)
+        return 1;
+    if ((loader == "meshCache" || loader == "meshCacheHit") && !filesystem::exists(cachePath, error))
+    {
+        cerr << "Cache de malha de " << path << " nao ficou gravado" << endl;
+        return 1;
+    }
+
+    printf("{\"triangles\": %zu, \"seconds\": %.6f, \"allocations\": %zu, \"peakRssMegabytes\": %.2f}\n", triangles,
+           elapsed.count(), allocations, peakRssMegabytes());
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Verificações de correção
+// ---------------------------------------------------------------------------
+
+// Lê um .OBJ em memória e repara, como loadOBJ + repairMesh
+ObjData repairedOBJ(const char *text)
+{
+    ObjData obj;
+    parseOBJ(text, text + strlen(text), obj);
+    repairMesh(obj);
+    return obj;
+}
+
+bool check(bool condition, const char *description)
+{
+    if (!condition)
+        cerr << "Falhou: " << description << endl;
+    return condition;
+}
+
+int runChecks()
+{
+    streambuf *console = cout.rdbuf(nullptr);  // estatísticas de repairMesh
+    bool ok = true;
+
+    // O grupo B só tem um triângulo degenerado e fica vazio: os dois grupos A viram um só
+    ObjData merged = repairedOBJ("v 0 0 0\nv 1 0 0\nv 0 1 0\n"
+                                 "usemtl A\nf 1 2 3\nusemtl B\nf 1 1 2\nusemtl A\nf 1 3 2\n");
+    ok &= check(merged.faceSizes.size() == 2, "repairMesh remove o triangulo degenerado");
+    ok &= check(merged.materialGroups.size() == 1 && merged.materialGroups[0].firstFace == 0 &&
+                    merged.materialGroups[0].material == 0,
+                "repairMesh junta grupos iguais separados por um grupo vazio");
+
+    // Sem grupo vazio no meio, A, B, A continuam três grupos
+    ObjData kept = repairedOBJ("v 0 0 0\nv 1 0 0\nv 0 1 0\n"
+                               "usemtl A\nf 1 2 3\nusemtl B\nf 2 3 1\nusemtl A\nf 1 3 2\n");
+    ok &= check(kept.materialGroups.size() == 3 && kept.materialGroups[2].firstFace == 2,
+                "repairMesh mantem grupos alternados");
+
+    cout.rdbuf(console);
+    cerr << (ok ? "Verificacoes ok" : "Verificacoes falharam") << endl;
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Processo principal
+// ---------------------------------------------------------------------------
+
+// Valor (texto) de "key": ... em uma linha JSON gerada por este programa
+string jsonField(const string &line, const string &key)
+{
+    string pattern = "\"" + key + "\": ";
+    size_t start = line.find(pattern);
+    if (start == string::npos)
+        return "";
+    start += pattern.size();
+    if (line[start] == '"')
+        return line.substr(start + 1, line.find('"', start + 1) - start - 1);
+    return line.substr(start, line.find_first_of(",}", start) - start);
+}
+
+string runChildProcess(const string &executable, const string &loader, const string &path)
+{
+    string command = "\"" + executable + "\" --run " + loader + " \"" + path + "\"";
+#ifdef _WIN32
+    command = "\"" + command + "\"";  // cmd.exe remove as aspas externas
+#endif
+    FILE *pipe = popen(command.c_str(), "r");
+    if (!pipe)
+        return "";
+    string output;
+    char buffer[512];
+    while (fgets(buffer, sizeof(buffer), pipe))
+        output += buffer;
+    int status = pclose(pipe);
+    size_t end = output.find_last_of('}');
+    if (status != 0 || end == string::npos)
+        return "";
+    return output.substr(output.find_last_of('{', end), end - output.find_last_of('{', end) + 1);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 4 && string(argv[1]) == "--run")
+        return runChild(argv[2], argv[3]);
+    if (argc == 2 && string(argv[1]) == "--check")
+        return runChecks();
+
+    string triangleList = DEFAULT_TRIANGLES, attributeList = DEFAULT_ATTRIBUTES, faceList = DEFAULT_FACES;
+    string loaderList = DEFAULT_LOADERS, directory = filesystem::temp_directory_path().string();
+    string outputPath, baselinePath;
+    double tolerance = 0.2;
+    bool keep = false;
+    for (int i = 1; i < argc; i++)
+    {
+        string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (option == "--triangles" && hasValue)
+            triangleList = argv[++i];
+        else if (option == "--attributes" && hasValue)
+            attributeList = argv[++i];
+        else if (option == "--faces" && hasValue)
+            faceList = argv[++i];
+        else if (option == "--loaders" && hasValue)
+            loaderList = argv[++i];
+        else if (option == "--dir" && hasValue)
+            directory = argv[++i];
+        else if (option == "--output" && hasValue)
+            outputPath = argv[++i];
+        else if (option == "--baseline" && hasValue)
+            baselinePath = argv[++i];
+        else if (option == "--tolerance" && hasValue)
+            tolerance = atof(argv[++i]);
+        else if (option == "--keep")
+            keep = true;
+        else
+        {
+            cerr << "Opcao invalida: " << option << endl
+                 << "Uso: " << argv[0] << " [--triangles 1000,1000000] [--attributes none,vt,vn,vtvn]"
+                 << " [--faces tri,quad,ngon] [--loaders " << DEFAULT_LOADERS << "] [--dir pasta]"
+                 << " [--output arquivo.json] [--baseline anterior.json] [--tolerance 0.2] [--keep]" << endl
+                 << "     " << argv[0] << " --check" << endl;
+            return 2;
+        }
+    }
+
+    vector<string> baseline;
+    if (!baselinePath.empty())
+    {
+        ifstream in(baselinePath);
+        for (string line; getline(in, line);)
+            if (line.find("\"loader\"") != string::npos)
+                baseline.push_back(line);
+    }
+
+    vector<BenchmarkCase> cases;
+    for (const string &triangleText : splitList(triangleList))
+        for (const string &attributes : splitList(attributeList))
+            for (const string &faces : splitList(faceList))
+            {
+                BenchmarkCase benchmarkCase;
+                size_t triangles = strtoull(triangleText.c_str(), nullptr, 10);
+                benchmarkCase.options.triangles = min<size_t>(MAX_TRIANGLES, triangles);
+                benchmarkCase.options.texCoords = attributes.find("vt") != string::npos;
+                benchmarkCase.options.normals = attributes.find("vn") != string::npos;
+                benchmarkCase.options.faces = faces;
+                benchmarkCase.attributes = attributes;
+                benchmarkCase.name = "bench_" + to_string(benchmarkCase.options.triangles) + "_" + attributes + "_" +
+                                     faces + ".obj";
+                benchmarkCase.loaders = splitList(loaderList);
+                cases.push_back(benchmarkCase);
+            }
+
+    // Caso de streaming: só os leitores que passam por loadMeshStaging
+    BenchmarkCase streamCase;
+    for (const string &loader : splitList(loaderList))
+        if (loader == "meshCache" || loader == "meshCacheHit")
+            streamCase.loaders.push_back(loader);
+    if (!streamCase.loaders.empty())
+    {
+        streamCase.options.triangles = STREAM_CASE_TRIANGLES;
+        streamCase.options.texCoords = streamCase.options.normals = true;
+        streamCase.attributes = "vtvn";
+        streamCase.name = "bench_stream_vtvn_tri.obj";
+        streamCase.stream = true;
+        cases.push_back(streamCase);
+    }
+
+    string executable = filesystem::absolute(argv[0]).string();
+    vector<string> results;
+    bool failed = false;
+    for (BenchmarkCase &benchmarkCase : cases)
+    {
+        GeneratorOptions &options = benchmarkCase.options;
+        const string &name = benchmarkCase.name;
+        string path = (filesystem::path(directory) / name).string();
+
+        GeneratedFile generated;
+        auto start = chrono::steady_clock::now();
+        if (!generateOBJ(path, options, generated))
+            return 2;
+        // O tamanho por triângulo depende do gerador: refaz o arquivo até passar do limite do streaming
+        while (benchmarkCase.stream && generated.bytes < OBJ_STREAM_THRESHOLD && options.triangles < MAX_TRIANGLES)
+        {
+            double scale = 1.1 * OBJ_STREAM_THRESHOLD / max<uint64_t>(1, generated.bytes);
+            options.triangles = min<size_t>(MAX_TRIANGLES, (size_t)(options.triangles * scale));
+            if (!generateOBJ(path, options, generated))
+                return 2;
+        }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        cerr << name << ": " << generated.triangles << " triangulos, " << generated.bytes / (1024 * 1024)
+             << " MB gerados em " << elapsed.count() << " s" << endl;
+
+        for (const string &loader : benchmarkCase.loaders)
+        {
+            ostringstream result;
+            result << "{\"file\": \"" << name << "\", \"loader\": \"" << loader << "\", \"triangles\": "
+                   << generated.triangles << ", \"attributes\": \"" << benchmarkCase.attributes << "\", \"faces\": \""
+                   << options.faces << "\", \"bytes\": " << generated.bytes;
+
+            // Sem streaming, loadMeshStaging monta a malha inteira na memória
+            bool pipeline = loader == "meshCache" || loader == "meshCacheHit";
+            bool skipped =
+                pipeline && generated.triangles > PIPELINE_MAX_TRIANGLES && generated.bytes < OBJ_STREAM_THRESHOLD;
+            string child = skipped ? "" : runChildProcess(executable, loader, path);
+            if (skipped)
+                result << ", \"skipped\": true}";
+            else if (child.empty())
+            {
+                result << ", \"error\": true}";
+                failed = true;
+            }
+            else
+            {
+                double seconds = atof(jsonField(child, "seconds").c_str());
+                double triangles = atof(jsonField(child, "triangles").c_str());
+                double megabytesPerSecond = seconds > 0.0 ? generated.bytes / (1024.0 * 1024.0) / seconds : 0.0;
+                result << ", \"seconds\": " << seconds << ", \"megabytesPerSecond\": " << megabytesPerSecond
+                       << ", \"trianglesPerSecond\": " << (seconds > 0.0 ? triangles / seconds : 0.0)
+                       << ", \"peakRssMegabytes\": " << jsonField(child, "peakRssMegabytes")
+                       << ", \"allocations\": " << jsonField(child, "allocations") << "}";
+
+                if (triangles != generated.triangles)
+                {
+                    cerr << loader << " leu " << triangles << " triangulos de " << name << ", esperado "
+                         << generated.triangles << endl;
+                    failed = true;
+                }
+                for (const string &previous : baseline)
+                    if (jsonField(previous, "file") == name && jsonField(previous, "loader") == loader)
+                    {
+                        double before = atof(jsonField(previous, "megabytesPerSecond").c_str());
+                        if (megabytesPerSecond < before * (1.0 - tolerance))
+                        {
+                            cerr << "Regressao: " << loader << " em " << name << " caiu de " << before << " para "
+                                 << megabytesPerSecond << " MB/s" << endl;
+                            failed = true;
+                        }
+                    }
+            }
+            cerr << "  " << result.str() << endl;
+            results.push_back(result.str());
+        }
+
+        if (!keep)
+        {
+            error_code error;
+            filesystem::remove(path, error);
+        }
+    }
+
+    if (!keep)
+    {
+        error_code error;
+        useBenchmarkCache(directory);
+        filesystem::remove_all(assetCacheDirectory, error);
+    }
+
+    ostringstream json;
+    json << "{\n\"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+        json << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+    json << "]\n}\n";
+    if (outputPath.empty())
+        cout << json.str();
+    else
+        ofstream(outputPath) << json.str();
+
+    return failed ? 1 : 0;
+}
@@ -6,6 +6,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "Shader.h"
+#include "InstanceBuffer.h"
+
 using namespace std;
 
 // Callback de teclado
@@ -22,7 +25,7 @@ const GLuint WIDTH = 1000, HEIGHT = 1000;
 const GLchar* vertexShaderSource = "#version 450 core\n"
 "layout (location = 0) in vec3 position;\n"
 "layout (location = 1) in vec3 color;\n"
-"uniform mat4 model;\n"
+"layout (location = 2) in mat4 model;\n"  // por instância (InstanceBuffer.h), localizações 2..5
 "uniform mat4 view;\n"
 "uniform mat4 projection;\n"
 "out vec4 finalColor;\n"
@@ -56,13 +59,14 @@ int main()
 
     glEnable(GL_DEPTH_TEST);
 
-    GLuint shaderID = setupShader();
+    // Localizações resolvidas uma vez no link (Shader.h)
+    Shader shader;
+    loadShaderUniforms(shader, setupShader());
     GLuint VAO = setupGeometry();
-    glUseProgram(shaderID);
+    glUseProgram(shader.program);
 
-    GLint modelLoc = glGetUniformLocation(shaderID, "model");
-    GLint viewLoc = glGetUniformLocation(shaderID, "view");
-    GLint projLoc = glGetUniformLocation(shaderID, "projection");
+    GLint viewLoc = uniformLocation(shader, "view");
+    GLint projLoc = uniformLocation(shader, "projection");
 
     glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)WIDTH / HEIGHT, 0.1f, 100.0f);
 
@@ -73,6 +77,12 @@ int main()
         glm::vec3(-2.0f, 0.0f, 0.0f),
  
     };
+    const size_t cubeCount = sizeof(cubePositions) / sizeof(cubePositions[0]);
+
+    // Matrizes model em um VBO de instâncias: todos os cubos em um glDrawArraysInstanced
+    InstanceBuffer instances;
+    createInstanceBuffer(instances, VAO, 2);
+    vector<InstanceData> instanceData;
 
     while (!glfwWindowShouldClose(window))
     {
@@ -85,8 +95,8 @@ int main()
         glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
 
-        glBindVertexArray(VAO);
-        for (unsigned int i = 0; i < 4; i++) {
+        instanceData.clear();
+        for (size_t i = 0; i < cubeCount; i++) {
             glm::mat4 model = glm::translate(glm::mat4(1.0f), cubePositions[i]);
             model = glm::scale(model, glm::vec3(scaleFactor));
             if (rotateX)
@@ -96,9 +106,12 @@ int main()
             else if (rotateZ)
                 model = glm::rotate(model, angle, glm::vec3(0.0f, 0.0f, 1.0f));
 
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            instanceData.push_back({model, glm::vec4(1.0f)});
         }
+        uploadInstances(instances, instanceData);
+
+        glBindVertexArray(VAO);
+        drawInstancedArrays(instances, GL_TRIANGLES, 0, 36);
         glBindVertexArray(0);
         glfwSwapBuffers(window);
     }
@@ -5,10 +5,17 @@
 #include <iostream>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include "ImageCache.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// Decodificador usado quando a imagem ainda não está no cache compartilhado
+unsigned char* loadImage(const char* filePath, int* width, int* height, int* channels)
+{
+    return stbi_load(filePath, width, height, channels, 0);
+}
+
 // Função para lidar com resize da janela
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
@@ -158,20 +165,18 @@ int main()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    int width, height, nrChannels;
+    // A imagem invertida vira a entrada "flip" do cache (ImageCache.h)
+    ImageStaging image;
     stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load("C:/Users/mateu/CGCCHibrido/assets/tex/pixelWall.png", &width, &height, &nrChannels, 0);
-    if (data)
+    if (loadImageStaging("../assets/tex/pixelWall.png", loadImage, stbi_image_free, image, "flip"))
     {
-        GLenum format = (nrChannels == 4) ? GL_RGBA : GL_RGB;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        GLenum format = (image.channels == 4) ? GL_RGBA : GL_RGB;
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels);
     }
     else
     {
         std::cerr << "Falha ao carregar textura" << std::endl;
     }
-    stbi_image_free(data);
 
     glEnable(GL_DEPTH_TEST);
 
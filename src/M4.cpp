@@ -3,8 +3,6 @@
 #include <vector>
 #include <map>
 #include <cmath>
-#include <fstream>
-#include <sstream>
 #include <algorithm>
 
 #include <glad/glad.h>
@@ -17,6 +15,13 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include "MeshCache.h"
+#include "DrawQueue.h"
+#include "AssetLoader.h"
+#include "Shader.h"
+#include "MeshArena.h"
+#include "IndirectDraw.h"
+
 using namespace std;
 using namespace glm;
 
@@ -29,7 +34,10 @@ layout (location = 1) in vec3 color;
 layout (location = 2) in vec3 normal;
 layout (location = 3) in vec2 texCoord;
 
-uniform mat4 model;
+// Por objeto (IndirectDraw.h): lidos pelo baseInstance de cada comando indireto
+layout (location = 4) in mat4 model;
+layout (location = 8) in vec4 objectColor;
+
 uniform mat4 view;
 uniform mat4 projection;
 
@@ -42,7 +50,7 @@ void main() {
     FragPos = vec3(model * vec4(position, 1.0));
     Normal = mat3(transpose(inverse(model))) * normal;
     TexCoord = texCoord;
-    vColor = color;
+    vColor = color * objectColor.rgb;
     gl_Position = projection * view * model * vec4(position, 1.0);
 })";
 
@@ -56,15 +64,17 @@ in vec3 vColor;
 uniform sampler2D texture_diffuse1;
 uniform vec3 lightPos;
 uniform vec3 viewPos;
-uniform float ka;
-uniform float kd;
-uniform float ks;
+uniform vec3 ambientLight;
+uniform vec3 ka;
+uniform vec3 kd;
+uniform vec3 ks;
 uniform float shininess;
+uniform bool hasDiffuseMap;
 
 out vec4 FragColor;
 
 void main() {
-    vec3 ambient = ka * vec3(1.0);
+    vec3 ambient = ka * ambientLight;
     vec3 norm = normalize(Normal);
     vec3 lightDir = normalize(lightPos - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
@@ -73,7 +83,7 @@ void main() {
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
     vec3 specular = ks * spec * vec3(1.0);
-    vec4 texColor = texture(texture_diffuse1, TexCoord);
+    vec4 texColor = hasDiffuseMap ? texture(texture_diffuse1, TexCoord) : vec4(1.0);
     vec3 result = (ambient + diffuse + specular) * vColor * texColor.rgb;
     FragColor = vec4(result, 1.0);
 })";
@@ -82,6 +92,10 @@ float lastX = 0.0f;
 float angleY = 0.0f;
 bool firstMouse = true;
 
+// Grade de objetos com as malhas da arena, para testar o desenho indireto (tecla N)
+const int CROWD_SIZE = 50;
+bool showCrowd = false;
+
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     if (firstMouse) {
         lastX = xpos;
@@ -113,103 +127,48 @@ int setupShader() {
     return shaderProgram;
 }
 
-GLuint loadTexture(string filePath) {
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrComponents, 0);
-
-    if (data) {
-        GLenum format = (nrComponents == 1) ? GL_RED : (nrComponents == 3) ? GL_RGB : GL_RGBA;
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    }
-
-    stbi_image_free(data);
-    return textureID;
+unsigned char *loadImage(const char *filePath, int *width, int *height, int *channels) {
+    return stbi_load(filePath, width, height, channels, 0);
 }
 
-struct Vertex {
-    vec3 position;
-    vec3 normal;
-    vec2 texCoord;
-};
-
-GLuint loadSuzanneModel(const string& objPath, int &nVertices) {
-    vector<vec3> temp_positions;
-    vector<vec3> temp_normals;
-    vector<vec2> temp_texcoords;
-    vector<Vertex> vertices;
-
-    ifstream file(objPath);
-    string line;
-    while (getline(file, line)) {
-        istringstream iss(line);
-        string type;
-        iss >> type;
-        if (type == "v") {
-            vec3 p; iss >> p.x >> p.y >> p.z; temp_positions.push_back(p);
-        } else if (type == "vn") {
-            vec3 n; iss >> n.x >> n.y >> n.z; temp_normals.push_back(n);
-        } else if (type == "vt") {
-            vec2 t; iss >> t.x >> t.y; t.y = 1.0f - t.y; temp_texcoords.push_back(t);
-        } else if (type == "f") {
-            string v;
-            while (iss >> v) {
-                istringstream viss(v);
-                string idx;
-                unsigned int indices[3] = {0};
-                int i = 0;
-                while (getline(viss, idx, '/')) {
-                    if (!idx.empty()) indices[i] = stoul(idx) - 1;
-                    i++;
-                    if (i >= 3) break;
-                }
-                Vertex vert;
-                if (indices[0] < temp_positions.size()) vert.position = temp_positions[indices[0]];
-                if (indices[1] < temp_texcoords.size()) vert.texCoord = temp_texcoords[indices[1]];
-                if (indices[2] < temp_normals.size()) vert.normal = temp_normals[indices[2]];
-                vertices.push_back(vert);
-            }
-        }
-    }
-
-    nVertices = vertices.size();
-
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
-    glEnableVertexAttribArray(3);
-    glBindVertexArray(0);
-
-    return VAO;
-}
+// Objetos enfileirados no quadro; desenhados por material e VAO em flushDrawQueueIndirect
+// (IndirectDraw.h), ou em flushDrawQueue quando o driver não tem glMultiDrawElementsIndirect
+const GLuint OBJECT_ATTRIBUTE_LOCATION = 4;
+MaterialLibrary materials;
+DrawQueue drawQueue;
+vector<InstanceData> objects;
+AssetLoader assets;
+vector<uint32_t> crowdMeshes;  // malhas da grade, carregadas na arena pelas threads de AssetLoader
 
-void drawModel(GLuint shaderID, GLuint VAO, vec3 position, vec3 dimensions, float angle, int nVertices, vec3 color, vec3 axis) {
+mat4 modelMatrix(vec3 position, vec3 dimensions, float angle, vec3 axis) {
     mat4 model = mat4(1.0f);
     model = translate(model, position);
     model = rotate(model, radians(angle), axis);
     model = scale(model, dimensions);
-    glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
-    glUniform3f(glGetUniformLocation(shaderID, "vColor"), color.r, color.g, color.b);
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, nVertices);
-    glBindVertexArray(0);
+    return model;
+}
+
+void drawModel(const GPUMesh &mesh, const mat4 &model, vec3 color, size_t lod = 0) {
+    objects.push_back({model, vec4(color, 1.0f)});
+    submitMeshLOD(drawQueue, mesh, lod, (uint32_t)objects.size() - 1);
+}
+
+bool isCrowdReady() {
+    for (uint32_t mesh : crowdMeshes)
+        if (!isMeshReady(assets, mesh))
+            return false;
+    return true;
+}
+
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode) {
+    if (key == GLFW_KEY_N && action == GLFW_PRESS) {
+        showCrowd = !showCrowd;
+        cout << (showCrowd ? "Showing " : "Hiding ") << CROWD_SIZE * CROWD_SIZE << " extra objects ("
+             << drawQueue.drawCalls << " draw calls last frame, "
+             << (indirectDrawSupported() ? "glMultiDrawElementsIndirect" : "one per object") << ")" << endl;
+        if (showCrowd && !isCrowdReady())
+            cout << "Crowd meshes are still loading; they appear as soon as they are ready" << endl;
+    }
 }
 
 int main() {
@@ -217,49 +176,99 @@ int main() {
     GLFWwindow *window = glfwCreateWindow(WIDTH, HEIGHT, "M4 Tarefa", nullptr, nullptr);
     glfwMakeContextCurrent(window);
     glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetKeyCallback(window, key_callback);
 
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+    loadGLExtensions((GLADloadproc)glfwGetProcAddress);  // glTexStorage2D, glBufferStorage e glMultiDrawElementsIndirect, se o driver tiver
 
     int width, height;
     glfwGetFramebufferSize(window, &width, &height);
     glViewport(0, 0, width, height);
 
-    GLuint shaderID = setupShader();
-    int nVertices;
-    GLuint VAO = loadSuzanneModel("../assets/Modelos3D/Suzanne.obj", nVertices);
-    GLuint textureID = loadTexture("../assets/Modelos3D/Suzanne.png");
-
-    float ka = 0.1f, kd = 0.7f, ks = 0.5f, shininess = 32.0f;
+    // Localizações dos uniforms resolvidas uma vez no link (Shader.h)
+    Shader shader;
+    loadShaderUniforms(shader, setupShader());
+    GLint kaLoc = uniformLocation(shader, "ka");
+    GLint kdLoc = uniformLocation(shader, "kd");
+    GLint ksLoc = uniformLocation(shader, "ks");
+    GLint shininessLoc = uniformLocation(shader, "shininess");
+    GLint hasDiffuseMapLoc = uniformLocation(shader, "hasDiffuseMap");
+    // A janela abre com um cubo no lugar da Suzanne enquanto ela é carregada em outra thread
+    startAssetLoader(assets, &materials, loadImage, stbi_image_free);
+    enableHotReload(assets);  // Suzanne.obj/.png alterados são recarregados com o programa aberto
+    uint32_t suzanne = requestMesh(assets, "../assets/Modelos3D/Suzanne.obj");
+
+    // Malhas da grade em um VBO/EBO/VAO compartilhado (um comando de desenho por material),
+    // lidas nas threads de carga como a Suzanne: a grade aparece quando todas ficam prontas
+    MeshArena arena;
+    for (const char *path : {"../assets/Modelos3D/Cube.obj", "../assets/Modelos3D/Suzanne.obj",
+                             "../assets/Modelos3D/SuzanneSubdiv1.obj"})
+        crowdMeshes.push_back(requestMesh(assets, path, false, &arena));
+    IndirectDrawBuffer indirect;
+    createIndirectDrawBuffer(indirect, OBJECT_ATTRIBUTE_LOCATION);
+
+    vec3 ambientLight = vec3(0.1f);
     vec3 lightPos = vec3(2.0f);
     vec3 viewPos = vec3(0.0f, 0.0f, 3.0f);
 
-    glUseProgram(shaderID);
-    glUniform1i(glGetUniformLocation(shaderID, "texture_diffuse1"), 0);
-    glUniform3f(glGetUniformLocation(shaderID, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
-    glUniform3f(glGetUniformLocation(shaderID, "viewPos"), viewPos.x, viewPos.y, viewPos.z);
-    glUniform1f(glGetUniformLocation(shaderID, "ka"), ka);
-    glUniform1f(glGetUniformLocation(shaderID, "kd"), kd);
-    glUniform1f(glGetUniformLocation(shaderID, "ks"), ks);
-    glUniform1f(glGetUniformLocation(shaderID, "shininess"), shininess);
+    glUseProgram(shader.program);
+    glUniform1i(uniformLocation(shader, "texture_diffuse1"), 0);
+    glUniform3f(uniformLocation(shader, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
+    glUniform3f(uniformLocation(shader, "viewPos"), viewPos.x, viewPos.y, viewPos.z);
+    glUniform3f(uniformLocation(shader, "ambientLight"), ambientLight.r, ambientLight.g, ambientLight.b);
 
     mat4 projection = perspective(radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
     mat4 view = lookAt(viewPos, vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
-    glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
-    glUniformMatrix4fv(glGetUniformLocation(shaderID, "view"), 1, GL_FALSE, value_ptr(view));
+    glUniformMatrix4fv(uniformLocation(shader, "projection"), 1, GL_FALSE, value_ptr(projection));
+    glUniformMatrix4fv(uniformLocation(shader, "view"), 1, GL_FALSE, value_ptr(view));
+
+    auto bindMaterial = [&](const Material &material) {
+        glUniform3fv(kaLoc, 1, value_ptr(material.ambient));
+        glUniform3fv(kdLoc, 1, value_ptr(material.diffuse));
+        glUniform3fv(ksLoc, 1, value_ptr(material.specular));
+        glUniform1f(shininessLoc, material.shininess);
+        glUniform1i(hasDiffuseMapLoc, material.diffuseTexture != 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, material.diffuseTexture);
+    };
+    // Só sem desenho indireto: model e cor como valor constante dos atributos do objeto
+    auto bindObject = [&](uint32_t object) {
+        setObjectAttributes(OBJECT_ATTRIBUTE_LOCATION, objects[object]);
+    };
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureID);
     glEnable(GL_DEPTH_TEST);
 
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
+        updateAssetLoader(assets);
         glClearColor(0.08f, 0.08f, 0.08f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        drawModel(shaderID, VAO, vec3(0.0f), vec3(1.0f), angleY, nVertices, vec3(1.0f), vec3(0.0f, 1.0f, 0.0f));
+        clearDrawQueue(drawQueue);
+        objects.clear();
+        drawModel(assetMesh(assets, suzanne), modelMatrix(vec3(0.0f), vec3(1.0f), angleY, vec3(0.0f, 1.0f, 0.0f)),
+                  vec3(1.0f));
+        if (showCrowd && isCrowdReady()) {
+            for (int x = 0; x < CROWD_SIZE; x++)
+                for (int z = 0; z < CROWD_SIZE; z++) {
+                    const GPUMesh &mesh = assetMesh(assets, crowdMeshes[(x + z) % crowdMeshes.size()]);
+                    vec3 position = vec3((x - CROWD_SIZE / 2) * 1.5f, -2.0f, -2.0f - z * 1.5f);
+                    mat4 model = modelMatrix(position, vec3(0.5f), angleY + x * 10.0f, vec3(0.0f, 1.0f, 0.0f));
+                    size_t lod = selectMeshLOD(mesh, model, projection, viewPos, (float)height);
+                    vec3 color = vec3(0.5f + 0.5f * x / CROWD_SIZE, 0.8f, 0.5f + 0.5f * z / CROWD_SIZE);
+                    drawModel(mesh, model, color, lod);
+                }
+        }
+        if (indirectDrawSupported())
+            flushDrawQueueIndirect(drawQueue, materials, indirect, objects, bindMaterial);
+        else
+            flushDrawQueue(drawQueue, materials, bindMaterial, bindObject);
         glfwSwapBuffers(window);
     }
 
-    glDeleteVertexArrays(1, &VAO);
+    printTextureMemory(assets.textureRegistry);
+    destroyIndirectDrawBuffer(indirect);
+    stopAssetLoader(assets);
+    destroyMeshArena(arena);
     glfwTerminate();
     return 0;
 }
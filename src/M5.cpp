@@ -4,8 +4,6 @@
 #include <vector>
 #include <map>
 #include <cmath>
-#include <fstream>
-#include <sstream>
 #include <algorithm>
 
 using namespace std;
@@ -21,6 +19,12 @@ using namespace std;
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include "MeshCache.h"
+#include "DrawQueue.h"
+#include "AssetLoader.h"
+#include "Shader.h"
+#include "UniformBlocks.h"
+
 using namespace glm;
 
 class Camera {
@@ -107,11 +111,27 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
 int setupShader();
-GLuint loadTexture(string filePath);
-GLuint loadSuzanneModel(const string& objPath, int &nVertices);
-void drawModel(GLuint shaderID, GLuint VAO, vec3 position, vec3 dimensions, int nVertices, vec3 color = vec3(1.0, 0.0, 0.0));
+unsigned char *loadImage(const char *filePath, int *width, int *height, int *channels);
+void drawModel(const GPUMesh &mesh, const mat4 &projection, const mat4 &view, float viewportHeight, vec3 position, vec3 dimensions);
 
 const GLuint WIDTH = 800, HEIGHT = 800;
+// Vértices quantizados de 16 bytes (PackedVertex.h) em vez de 32 bytes em float
+const bool PACKED_VERTICES = true;
+// Descarta meshlets fora do frustum ou de costas para a câmera antes de desenhar (tecla C)
+bool meshletCullingEnabled = true;
+MeshletDrawList meshletDrawList;
+// Nível de detalhe escolhido pelo tamanho na tela (MeshLOD.h)
+size_t currentLOD = 0;
+// Materiais dos .MTL e desenho agrupado por material (DrawQueue.h)
+struct ModelInstance {
+    const GPUMesh *mesh;
+    mat4 model;
+};
+MaterialLibrary materials;
+DrawQueue drawQueue;
+vector<ModelInstance> modelInstances;
+// Malhas e texturas lidas em threads de carga; cubo e xadrez até ficarem prontas (AssetLoader.h)
+AssetLoader assets;
 Camera camera;
 float lastX = WIDTH / 2.0f;
 float lastY = HEIGHT / 2.0f;
@@ -140,9 +160,17 @@ layout (location = 1) in vec3 color;
 layout (location = 2) in vec3 normal;
 layout (location = 3) in vec2 texCoord;
 
+// Câmera do quadro, compartilhada por todos os programas (UniformBlocks.h)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
 
 out vec3 FragPos;
 out vec3 Normal;
@@ -151,11 +179,12 @@ out vec3 vColor;
 
 void main()
 {
-    FragPos = vec3(model * vec4(position, 1.0));
+    vec3 localPos = positionOffset + position * positionScale;
+    FragPos = vec3(model * vec4(localPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * normal;  
     TexCoord = texCoord;
     vColor = color;
-    gl_Position = projection * view * model * vec4(position, 1.0);
+    gl_Position = projection * view * model * vec4(localPos, 1.0);
 })";
 
 const GLchar *fragmentShaderSource = R"(
@@ -165,29 +194,34 @@ in vec3 Normal;
 in vec2 TexCoord;
 in vec3 vColor;
 
-uniform sampler2D texture_diffuse1;
-uniform vec3 viewPos;
-
-// Luzes
-uniform vec3 keyLightPos;
-uniform vec3 keyLightColor;
-uniform float keyLightIntensity;
-uniform bool keyLightEnabled;
+uniform sampler2DArray diffuseMaps;  // todas as texturas da cena, uma por camada
+uniform int diffuseLayer;
 
-uniform vec3 fillLightPos;
-uniform vec3 fillLightColor;
-uniform float fillLightIntensity;
-uniform bool fillLightEnabled;
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+};
 
-uniform vec3 backLightPos;
-uniform vec3 backLightColor;
-uniform float backLightIntensity;
-uniform bool backLightEnabled;
+// Luzes (UniformBlocks.h): position.w diz se a luz está ligada, color.a é a intensidade
+struct Light
+{
+    vec4 position;
+    vec4 color;
+};
+layout (std140) uniform LightData
+{
+    Light lights[8];
+    vec4 ambientLight;
+    int lightCount;
+};
 
-uniform float ka;
-uniform float kd;
-uniform float ks;
+uniform vec3 ka;
+uniform vec3 kd;
+uniform vec3 ks;
 uniform float shininess;
+uniform bool hasDiffuseMap;
 
 out vec4 FragColor;
 
@@ -215,22 +249,19 @@ vec3 calculateLight(vec3 lightPos, vec3 lightColor, float lightIntensity, vec3 f
 
 void main()
 {
-    vec3 ambient = ka * vec3(1.0, 1.0, 1.0);
+    vec3 ambient = ka * ambientLight.rgb;
     vec3 norm = normalize(Normal);
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
     
     vec3 result = ambient;
     
-    if (keyLightEnabled)
-        result += calculateLight(keyLightPos, keyLightColor, keyLightIntensity, FragPos, norm, viewDir);
-    
-    if (fillLightEnabled)
-        result += calculateLight(fillLightPos, fillLightColor, fillLightIntensity, FragPos, norm, viewDir);
-    
-    if (backLightEnabled)
-        result += calculateLight(backLightPos, backLightColor, backLightIntensity, FragPos, norm, viewDir);
+    for (int i = 0; i < lightCount; i++)
+    {
+        if (lights[i].position.w > 0.0)
+            result += calculateLight(lights[i].position.xyz, lights[i].color.rgb, lights[i].color.a, FragPos, norm, viewDir);
+    }
     
-    vec4 texColor = texture(texture_diffuse1, TexCoord);
+    vec4 texColor = hasDiffuseMap ? texture(diffuseMaps, vec3(TexCoord, diffuseLayer)) : vec4(1.0);
     result = result * vColor * texColor.rgb;
     
     FragColor = vec4(result, 1.0);
@@ -272,6 +303,7 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    loadGLExtensions((GLADloadproc)glfwGetProcAddress);  // glTexStorage2D e glBufferStorage, se o driver tiver
 
     const GLubyte *renderer = glGetString(GL_RENDERER);
     const GLubyte *version = glGetString(GL_VERSION);
@@ -282,43 +314,69 @@ int main()
     glfwGetFramebufferSize(window, &width, &height);
     glViewport(0, 0, width, height);
 
-    GLuint shaderID = setupShader();
-    int nVertices;
-    GLuint VAO = loadSuzanneModel("../assets/Modelos3D/Suzanne.obj", nVertices);
-    GLuint textureID = loadTexture("../assets/Modelos3D/Suzanne.png");
-
-    float ka = 0.1f;
-    float kd = 0.7f;
-    float ks = 0.5f;
-    float shininess = 32.0f;
+    // Localizações dos uniforms resolvidas uma vez no link (Shader.h); o laço só usa as GLint
+    Shader shader;
+    loadShaderUniforms(shader, setupShader());
+    GLuint shaderID = shader.program;
+    GLint modelLoc = uniformLocation(shader, "model");
+    GLint positionOffsetLoc = uniformLocation(shader, "positionOffset");
+    GLint positionScaleLoc = uniformLocation(shader, "positionScale");
+    GLint kaLoc = uniformLocation(shader, "ka");
+    GLint kdLoc = uniformLocation(shader, "kd");
+    GLint ksLoc = uniformLocation(shader, "ks");
+    GLint shininessLoc = uniformLocation(shader, "shininess");
+    GLint hasDiffuseMapLoc = uniformLocation(shader, "hasDiffuseMap");
+    GLint diffuseLayerLoc = uniformLocation(shader, "diffuseLayer");
+    // Câmera e luzes em UBOs: um glBufferSubData de cada por quadro
+    UniformBuffer frameBuffer, lightBuffer;
+    createUniformBuffer(frameBuffer, FRAME_UNIFORMS_BINDING, sizeof(FrameUniforms));
+    createUniformBuffer(lightBuffer, LIGHT_UNIFORMS_BINDING, sizeof(LightUniforms));
+    bindUniformBlock(shader, "FrameData", FRAME_UNIFORMS_BINDING);
+    bindUniformBlock(shader, "LightData", LIGHT_UNIFORMS_BINDING);
+    assets.packTextures = true;  // map_Kd em um GL_TEXTURE_2D_ARRAY: um glBindTexture para a cena toda
+    startAssetLoader(assets, &materials, loadImage, stbi_image_free);
+    enableHotReload(assets);  // Suzanne.obj/.png alterados são recarregados com o programa aberto
+    uint32_t suzanne = requestMesh(assets, "../assets/Modelos3D/Suzanne.obj", PACKED_VERTICES);
+
+    vec3 ambientLight = vec3(0.1f);
 
     vec3 objectPosition = vec3(0.0f, 0.0f, 0.0f);
     float objectScale = 1.0f;
     setupLights(objectPosition, objectScale);
 
     glUseProgram(shaderID);
-    glUniform1i(glGetUniformLocation(shaderID, "texture_diffuse1"), 0);
-    glUniform1f(glGetUniformLocation(shaderID, "ka"), ka);
-    glUniform1f(glGetUniformLocation(shaderID, "kd"), kd);
-    glUniform1f(glGetUniformLocation(shaderID, "ks"), ks);
-    glUniform1f(glGetUniformLocation(shaderID, "shininess"), shininess);
-
-
-    glUniform3f(glGetUniformLocation(shaderID, "keyLightPos"), keyLight.position.x, keyLight.position.y, keyLight.position.z);
-    glUniform3f(glGetUniformLocation(shaderID, "keyLightColor"), keyLight.color.r, keyLight.color.g, keyLight.color.b);
-    glUniform1f(glGetUniformLocation(shaderID, "keyLightIntensity"), keyLight.intensity);
-
-    glUniform3f(glGetUniformLocation(shaderID, "fillLightPos"), fillLight.position.x, fillLight.position.y, fillLight.position.z);
-    glUniform3f(glGetUniformLocation(shaderID, "fillLightColor"), fillLight.color.r, fillLight.color.g, fillLight.color.b);
-    glUniform1f(glGetUniformLocation(shaderID, "fillLightIntensity"), fillLight.intensity);
-
-    glUniform3f(glGetUniformLocation(shaderID, "backLightPos"), backLight.position.x, backLight.position.y, backLight.position.z);
-    glUniform3f(glGetUniformLocation(shaderID, "backLightColor"), backLight.color.r, backLight.color.g, backLight.color.b);
-    glUniform1f(glGetUniformLocation(shaderID, "backLightIntensity"), backLight.intensity);
-        
+    glUniform1i(uniformLocation(shader, "diffuseMaps"), 0);
+
+    FrameUniforms frame;
+    LightUniforms lightData;
+    lightData.ambientLight = vec4(ambientLight, 1.0f);
+    lightData.lightCount = 3;
+
+    // Uniforms de material: definidos uma vez por material a cada quadro. Os materiais
+    // dividem o mesmo array, então a textura só é ligada quando o array muda
+    GLuint boundArray = 0;
+    auto bindMaterial = [&](const Material &material) {
+        glUniform3fv(kaLoc, 1, value_ptr(material.ambient));
+        glUniform3fv(kdLoc, 1, value_ptr(material.diffuse));
+        glUniform3fv(ksLoc, 1, value_ptr(material.specular));
+        glUniform1f(shininessLoc, material.shininess);
+        glUniform1i(hasDiffuseMapLoc, material.diffuseTexture != 0);
+        glUniform1i(diffuseLayerLoc, material.diffuseLayer);
+        if (material.diffuseTexture != 0 && material.diffuseTexture != boundArray)
+        {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, material.diffuseTexture);
+            boundArray = material.diffuseTexture;
+        }
+    };
+    // Uniforms de objeto: definidos quando o objeto muda dentro da fila
+    auto bindObject = [&](uint32_t object) {
+        const ModelInstance &instance = modelInstances[object];
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, value_ptr(instance.model));
+        glUniform3fv(positionOffsetLoc, 1, value_ptr(instance.mesh->positionOffset));
+        glUniform3fv(positionScaleLoc, 1, value_ptr(instance.mesh->positionScale));
+    };
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureID);
     glEnable(GL_DEPTH_TEST);
 
     while (!glfwWindowShouldClose(window))
@@ -337,27 +395,38 @@ int main()
             camera.processKeyboard(GLFW_KEY_D, deltaTime);
         
         glfwPollEvents();
+        updateAssetLoader(assets);
         glClearColor(0.08f, 0.08f, 0.08f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         mat4 projection = perspective(radians(camera.fov), (float)width / (float)height, 0.1f, 100.0f);
-        glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
-        
         mat4 view = camera.getViewMatrix();
-        glUniformMatrix4fv(glGetUniformLocation(shaderID, "view"), 1, GL_FALSE, value_ptr(view));
-        
-        glUniform3f(glGetUniformLocation(shaderID, "viewPos"), camera.position.x, camera.position.y, camera.position.z);
-
-        drawModel(shaderID, VAO, vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 1.0f, 1.0f), nVertices, vec3(1.0f, 1.0f, 1.0f));
+        frame.projection = projection;
+        frame.view = view;
+        frame.viewPos = vec4(camera.position, 1.0f);
+        updateUniformBuffer(frameBuffer, &frame, sizeof(frame));
+
+        const Light *sceneLights[3] = {&keyLight, &fillLight, &backLight};
+        const bool lightEnabled[3] = {keyLightEnabled, fillLightEnabled, backLightEnabled};
+        for (int i = 0; i < 3; i++)
+        {
+            lightData.lights[i].position = vec4(sceneLights[i]->position, lightEnabled[i] ? 1.0f : 0.0f);
+            lightData.lights[i].color = vec4(sceneLights[i]->color, sceneLights[i]->intensity);
+        }
+        updateUniformBuffer(lightBuffer, &lightData, sizeof(lightData));
 
-        glUniform1i(glGetUniformLocation(shaderID, "keyLightEnabled"), keyLightEnabled);
-        glUniform1i(glGetUniformLocation(shaderID, "fillLightEnabled"), fillLightEnabled);
-        glUniform1i(glGetUniformLocation(shaderID, "backLightEnabled"), backLightEnabled);
+        clearDrawQueue(drawQueue);
+        modelInstances.clear();
+        boundArray = 0;  // um array recriado pode ganhar o nome do antigo
+        drawModel(assetMesh(assets, suzanne), projection, view, (float)height, vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 1.0f, 1.0f));
+        flushDrawQueue(drawQueue, materials, bindMaterial, bindObject);
 
         glfwSwapBuffers(window);
     }
 
-    glDeleteVertexArrays(1, &VAO);
+    destroyUniformBuffer(frameBuffer);
+    destroyUniformBuffer(lightBuffer);
+    stopAssetLoader(assets);
     glfwTerminate();
     return 0;
 }
@@ -382,6 +451,16 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
                 backLightEnabled = !backLightEnabled;
                 cout << "Back light " << (backLightEnabled ? "enabled" : "disabled") << endl;
                 break;
+            case GLFW_KEY_C:
+                meshletCullingEnabled = !meshletCullingEnabled;
+                cout << "Meshlet culling " << (meshletCullingEnabled ? "enabled" : "disabled") << " ("
+                     << meshletDrawList.visibleTriangles << "/" << meshletDrawList.totalTriangles
+                     << " triangles drawn last frame)" << endl;
+                break;
+            case GLFW_KEY_T:
+                printTextureMemory(assets.textureRegistry);
+                printTextureArrays(assets.textureArrays);
+                break;
         }
     }
 }
@@ -457,146 +536,35 @@ int setupShader()
     return shaderProgram;
 }
 
-GLuint loadTexture(string filePath)
+// Só decodifica: o envio para a GPU é feito aos poucos por updateAssetLoader
+unsigned char *loadImage(const char *filePath, int *width, int *height, int *channels)
 {
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrComponents, 0);
-    
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << filePath << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
-
-struct Vertex {
-    vec3 position;
-    vec3 normal;
-    vec2 texCoord;
-};
-
-GLuint loadSuzanneModel(const string& objPath, int &nVertices) {
-    vector<vec3> temp_positions;
-    vector<vec3> temp_normals;
-    vector<vec2> temp_texcoords;
-    vector<Vertex> vertices;
-
-    ifstream file(objPath);
-    if (!file.is_open()) {
-        cerr << "Failed to open OBJ file: " << objPath << endl;
-        return 0;
-    }
-
-    string line;
-    while (getline(file, line)) {
-        istringstream iss(line);
-        string type;
-        iss >> type;
-
-        if (type == "v") {
-            vec3 position;
-            iss >> position.x >> position.y >> position.z;
-            temp_positions.push_back(position);
-        }
-        else if (type == "vn") {
-            vec3 normal;
-            iss >> normal.x >> normal.y >> normal.z;
-            temp_normals.push_back(normal);
-        }
-        else if (type == "vt") {
-            vec2 texcoord;
-            iss >> texcoord.x >> texcoord.y;
-            texcoord.y = 1.0f - texcoord.y;
-            temp_texcoords.push_back(texcoord);
-        }
-        else if (type == "f") {
-            string vertexData;
-            while (iss >> vertexData) {
-                Vertex vertex;
-                istringstream viss(vertexData);
-                string indexStr;
-                unsigned int indices[3] = {0, 0, 0};
-                int i = 0;
-
-                while (getline(viss, indexStr, '/')) {
-                    if (!indexStr.empty()) {
-                        indices[i] = stoul(indexStr) - 1;
-                    }
-                    i++;
-                    if (i >= 3) break;
-                }
-
-                if (indices[0] < temp_positions.size()) {
-                    vertex.position = temp_positions[indices[0]];
-                }
-                if (indices[1] < temp_texcoords.size()) {
-                    vertex.texCoord = temp_texcoords[indices[1]];
-                }
-                if (indices[2] < temp_normals.size()) {
-                    vertex.normal = temp_normals[indices[2]];
-                }
-                vertices.push_back(vertex);
-            }
-        }
-    }
-
-    file.close();
-    nVertices = vertices.size();
-
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
-    glEnableVertexAttribArray(3);
-
-    glBindVertexArray(0);
-    return VAO;
+    return stbi_load(filePath, width, height, channels, 0);
 }
 
-void drawModel(GLuint shaderID, GLuint VAO, vec3 position, vec3 dimensions, int nVertices, vec3 color)
+void drawModel(const GPUMesh &mesh, const mat4 &projection, const mat4 &view, float viewportHeight, vec3 position, vec3 dimensions)
 {
     mat4 model = mat4(1.0f);
     model = translate(model, position);
     model = scale(model, dimensions);
     
-    glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
-    glUniform3f(glGetUniformLocation(shaderID, "vColor"), color.r, color.g, color.b);
+    // Só enfileira: os uniforms do objeto são definidos em flushDrawQueue (bindObject)
+    uint32_t object = (uint32_t)modelInstances.size();
+    modelInstances.push_back({&mesh, model});
     
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, nVertices);
-    glBindVertexArray(0);
+    size_t lod = selectMeshLOD(mesh, model, projection, camera.position, viewportHeight);
+    if (lod != currentLOD)
+    {
+        currentLOD = lod;
+        cout << "LOD " << lod << " (" << mesh.lods[lod].indexCount / 3 << " triangles)" << endl;
+    }
+
+    // Os meshlets cobrem só a malha completa; os níveis simplificados são desenhados inteiros
+    if (lod > 0 || !meshletCullingEnabled)
+        submitMeshLOD(drawQueue, mesh, lod, object);
+    else
+    {
+        cullMeshlets(mesh, projection * view, model, camera.position, meshletDrawList);
+        submitMeshlets(drawQueue, mesh, meshletDrawList, object);
+    }
 }
@@ -7,6 +7,10 @@
 #include <vector>
 #include <algorithm>
 
+#include "Shader.h"
+#include "UniformBlocks.h"
+#include "InstanceBuffer.h"
+
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
@@ -28,21 +32,33 @@ std::vector<SceneObject> sceneObjects;
 int selectedObjectIndex = 0;
 bool showTrajectories = true;
 
+// Grade de cubos extras para testar o desenho instanciado (tecla N)
+const int CROWD_SIZE_X = 50, CROWD_SIZE_Y = 40, CROWD_SIZE_Z = 50;
+std::vector<glm::vec3> crowdPositions;
+bool showCrowd = false;
+
 const char* vertexShaderSource = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
+// Por instância (InstanceBuffer.h): um cubo inteiro por glDrawArraysInstanced
+layout (location = 2) in mat4 instanceModel;
+layout (location = 6) in vec4 instanceColor;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Câmera do quadro, compartilhada pelos dois programas (UniformBlocks.h)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+};
 
 out vec3 vertexColor;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    vertexColor = aColor;
+    gl_Position = projection * view * instanceModel * vec4(aPos, 1.0);
+    vertexColor = aColor * instanceColor.rgb;
 }
 )";
 
@@ -60,8 +76,12 @@ const char* trajectoryVertexShaderSource = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+};
 
 void main()
 {
@@ -219,6 +239,16 @@ void processInput(GLFWwindow* window) {
         }
     }
 
+    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS) {
+        static double lastPressTime = 0;
+        double currentTime = glfwGetTime();
+        if (currentTime - lastPressTime > 0.2) {
+            showCrowd = !showCrowd;
+            std::cout << (showCrowd ? "Showing " : "Hiding ") << crowdPositions.size() << " extra cubes\n";
+            lastPressTime = currentTime;
+        }
+    }
+
     if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS) {
         static double lastPressTime = 0;
         double currentTime = glfwGetTime();
@@ -243,31 +273,17 @@ int main() {
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
     glEnable(GL_DEPTH_TEST);
 
-    int vs = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vs, 1, &vertexShaderSource, nullptr);
-    glCompileShader(vs);
-    int fs = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fs, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(fs);
-    int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vs);
-    glAttachShader(shaderProgram, fs);
-    glLinkProgram(shaderProgram);
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-
-    int trajectoryVS = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(trajectoryVS, 1, &trajectoryVertexShaderSource, nullptr);
-    glCompileShader(trajectoryVS);
-    int trajectoryFS = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(trajectoryFS, 1, &trajectoryFragmentShaderSource, nullptr);
-    glCompileShader(trajectoryFS);
-    int trajectoryShaderProgram = glCreateProgram();
-    glAttachShader(trajectoryShaderProgram, trajectoryVS);
-    glAttachShader(trajectoryShaderProgram, trajectoryFS);
-    glLinkProgram(trajectoryShaderProgram);
-    glDeleteShader(trajectoryVS);
-    glDeleteShader(trajectoryFS);
+    // Localizações resolvidas uma vez no link (Shader.h)
+    Shader shader, trajectoryShader;
+    createShader(shader, vertexShaderSource, fragmentShaderSource);
+    createShader(trajectoryShader, trajectoryVertexShaderSource, trajectoryFragmentShaderSource);
+
+    // view e projection vão em um UBO lido pelos dois programas, atualizado uma vez por quadro
+    UniformBuffer frameBuffer;
+    createUniformBuffer(frameBuffer, FRAME_UNIFORMS_BINDING, sizeof(FrameUniforms));
+    bindUniformBlock(shader, "FrameData", FRAME_UNIFORMS_BINDING);
+    bindUniformBlock(trajectoryShader, "FrameData", FRAME_UNIFORMS_BINDING);
+    FrameUniforms frame;
 
     unsigned int VBO, VAO;
     glGenVertexArrays(1, &VAO);
@@ -280,6 +296,11 @@ int main() {
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
+    // Matriz e cor de cada cubo nas localizações 2..6, reenviadas uma vez por quadro
+    InstanceBuffer instances;
+    createInstanceBuffer(instances, VAO, 2);
+    std::vector<InstanceData> instanceData;
+
     unsigned int trajectoryVAO, trajectoryVBO;
     glGenVertexArrays(1, &trajectoryVAO);
     glGenBuffers(1, &trajectoryVBO);
@@ -290,6 +311,11 @@ int main() {
         {{-2.0f, 1.0f, -3.0f}, {}, 0.02f, 0, false, true}
     };
 
+    for (int x = 0; x < CROWD_SIZE_X; ++x)
+        for (int y = 0; y < CROWD_SIZE_Y; ++y)
+            for (int z = 0; z < CROWD_SIZE_Z; ++z)
+                crowdPositions.push_back(glm::vec3((x - CROWD_SIZE_X / 2) * 1.5f, (y - CROWD_SIZE_Y / 2) * 1.5f, -10.0f - z * 1.5f));
+
     while (!glfwWindowShouldClose(window)) {
         processInput(window);
 
@@ -298,11 +324,13 @@ int main() {
 
         glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -8.0f));
         glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH/SCR_HEIGHT, 0.1f, 100.0f);
+        frame.projection = projection;
+        frame.view = view;
+        frame.viewPos = glm::vec4(0.0f, 0.0f, 8.0f, 1.0f);
+        updateUniformBuffer(frameBuffer, &frame, sizeof(frame));
 
         if (showTrajectories) {
-            glUseProgram(trajectoryShaderProgram);
-            glUniformMatrix4fv(glGetUniformLocation(trajectoryShaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-            glUniformMatrix4fv(glGetUniformLocation(trajectoryShaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            glUseProgram(trajectoryShader.program);
 
             for (size_t i = 0; i < sceneObjects.size(); ++i) {
                 const auto& obj = sceneObjects[i];
@@ -325,33 +353,39 @@ int main() {
             }
         }
 
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO);
+        // Rotação e escala são as mesmas para todos os cubos; só a translação muda
+        glm::mat4 rotationScale = glm::mat4(1.0f);
+        rotationScale = glm::rotate(rotationScale, glm::radians(rotationX), glm::vec3(1, 0, 0));
+        rotationScale = glm::rotate(rotationScale, glm::radians(rotationY), glm::vec3(0, 1, 0));
+        rotationScale = glm::rotate(rotationScale, glm::radians(rotationZ), glm::vec3(0, 0, 1));
+        rotationScale = glm::scale(rotationScale, glm::vec3(scale));
 
+        instanceData.clear();
         for (size_t i = 0; i < sceneObjects.size(); ++i) {
-            const auto& obj = sceneObjects[i];
-            
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, obj.position);
-            model = glm::rotate(model, glm::radians(rotationX), glm::vec3(1, 0, 0));
-            model = glm::rotate(model, glm::radians(rotationY), glm::vec3(0, 1, 0));
-            model = glm::rotate(model, glm::radians(rotationZ), glm::vec3(0, 0, 1));
-            model = glm::scale(model, glm::vec3(scale));
-
-            glm::vec3 baseColor = (i == selectedObjectIndex) ? glm::vec3(1.0f, 1.0f, 1.0f) : glm::vec3(0.7f, 0.7f, 0.7f);
-            glUniform3fv(glGetUniformLocation(shaderProgram, "overrideColor"), 1, glm::value_ptr(baseColor));
-
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            glm::mat4 model = rotationScale;
+            model[3] = glm::vec4(sceneObjects[i].position, 1.0f);
+            float brightness = (i == (size_t)selectedObjectIndex) ? 1.0f : 0.7f;
+            instanceData.push_back({model, glm::vec4(glm::vec3(brightness), 1.0f)});
+        }
+        if (showCrowd) {
+            for (const glm::vec3& crowdPosition : crowdPositions) {
+                glm::mat4 model = rotationScale;
+                model[3] = glm::vec4(crowdPosition, 1.0f);
+                instanceData.push_back({model, glm::vec4(0.5f, 0.5f, 0.5f, 1.0f)});
+            }
         }
+        uploadInstances(instances, instanceData);
+
+        glUseProgram(shader.program);
+        glBindVertexArray(VAO);
+        drawInstancedArrays(instances, GL_TRIANGLES, 0, 36);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    destroyInstanceBuffer(instances);
+    destroyUniformBuffer(frameBuffer);
     glfwTerminate();
     return 0;
 }
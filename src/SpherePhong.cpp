@@ -27,6 +27,10 @@ using namespace std;
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+// Texturas compartilhadas por caminho (TextureRegistry.h); imagens decodificadas
+// ficam no cache compartilhado (../cache)
+#include "TextureRegistry.h"
+
 using namespace glm;
 
 #include <cmath>
@@ -38,6 +42,7 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 int setupShader();
 int setupGeometry();
 GLuint loadTexture(string filePath, int &width, int &height);
+unsigned char *loadImage(const char *filePath, int *width, int *height, int *channels);
 
 void drawGeometry(GLuint shaderID, GLuint VAO, vec3 position, vec3 dimensions, float angle, int nVertices, vec3 color= vec3(1.0,0.0,0.0), vec3 axis = (vec3(0.0, 0.0, 1.0)));
 GLuint generateSphere(float radius, int latSegments, int lonSegments, int &nVertices);
@@ -45,6 +50,9 @@ GLuint generateSphere(float radius, int latSegments, int lonSegments, int &nVert
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 800, HEIGHT = 800;
 
+// Texturas carregadas por loadTexture
+TextureRegistry textures;
+
 // Código fonte do Vertex Shader (em GLSL): ainda hardcoded
 const GLchar *vertexShaderSource = R"(
 #version 400
@@ -220,6 +228,7 @@ int main()
 	}
 	// Pede pra OpenGL desalocar os buffers
 	glDeleteVertexArrays(1, &VAO);
+	destroyTextureRegistry(textures);
 	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
 	glfwTerminate();
 	return 0;
@@ -350,46 +359,25 @@ int setupGeometry()
 
 GLuint loadTexture(string filePath, int &width, int &height)
 {
-	GLuint texID; // id da textura a ser carregada
-
-	// Gera o identificador da textura na memória
-	glGenTextures(1, &texID);
-	glBindTexture(GL_TEXTURE_2D, texID);
-
-	// Ajuste dos parâmetros de wrapping e filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Carregamento da imagem usando a função stbi_load da biblioteca stb_image
-	int nrChannels;
-
-	unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
-
-	if (data)
-	{
-		if (nrChannels == 3) // jpg, bmp
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		}
-		else // assume que é 4 canais png
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		}
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
+	// Filtro linear sem mipmaps; o mesmo arquivo pedido de novo devolve a mesma textura
+	TextureSampler sampler;
+	sampler.minFilter = GL_LINEAR;
+	TextureHandle handle = acquireTexture(textures, filePath, loadImage, stbi_image_free, sampler);
+
+	const TextureEntry *entry = textureEntry(textures, handle);
+	width = entry->width;
+	height = entry->height;
+	if (width == 0)
 	{
 		std::cout << "Failed to load texture " << filePath << std::endl;
 	}
 
-	stbi_image_free(data);
-
-	glBindTexture(GL_TEXTURE_2D, 0);
+	return entry->texture;
+}
 
-	return texID;
+unsigned char *loadImage(const char *filePath, int *width, int *height, int *channels)
+{
+	return stbi_load(filePath, width, height, channels, 0);
 }
 
 void drawGeometry(GLuint shaderID, GLuint VAO, vec3 position, vec3 dimensions, float angle, int nVertices, vec3 color, vec3 axis)
@@ -5,12 +5,21 @@
 #include <iostream>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include "ImageCache.h"
+#include "Shader.h"
+#include "InstanceBuffer.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 
 
+// Decodificador usado quando a imagem ainda não está no cache compartilhado
+unsigned char* loadImage(const char* filePath, int* width, int* height, int* channels)
+{
+    return stbi_load(filePath, width, height, channels, 0);
+}
+
 // Função para lidar com resize da janela
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
@@ -30,17 +39,17 @@ const char* vertexShaderSource = R"glsl(
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
 layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in mat4 instanceModel;  // por cubo (InstanceBuffer.h), localizações 3..6
 
 out vec3 ourColor;
 out vec2 TexCoord;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * instanceModel * vec4(aPos, 1.0);
     ourColor = aColor;
     TexCoord = aTexCoord;
 }
@@ -158,48 +167,18 @@ int main()
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
-    // Compilar vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    // Verifica erros de compilação
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if(!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "Erro vertex shader:\n" << infoLog << std::endl;
-    }
+    // Matrizes dos cubos (location = 3..6): os 10 cubos saem em um único glDrawArraysInstanced
+    InstanceBuffer instances;
+    createInstanceBuffer(instances, VAO, 3);
+    std::vector<InstanceData> instanceData;
 
-    // Compilar fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if(!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cout << "Erro fragment shader:\n" << infoLog << std::endl;
-    }
-
-    // Linkar shader program
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if(!success)
-    {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cout << "Erro link shader program:\n" << infoLog << std::endl;
-    }
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // Compila e linka; as localizações dos uniforms ficam resolvidas desde já (Shader.h)
+    Shader shader;
+    createShader(shader, vertexShaderSource, fragmentShaderSource);
+    GLuint shaderProgram = shader.program;
+    GLint viewLoc = uniformLocation(shader, "view");
+    GLint projLoc = uniformLocation(shader, "projection");
+    GLint textureLoc = uniformLocation(shader, "ourTexture");
 
     // Carregar textura
     GLuint texture;
@@ -212,30 +191,33 @@ int main()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // Carrega imagem usando stb_image
-    int width, height, nrChannels;
+    // Carrega imagem usando stb_image (ou do cache compartilhado, entrada "flip", ver ImageCache.h)
+    ImageStaging image;
     stbi_set_flip_vertically_on_load(true); // inverte verticalmente para combinar com coords OpenGL
-    unsigned char *data = stbi_load("C:/Users/mateu/CGCCHibrido/assets/tex/pixelWall.png", &width, &height, &nrChannels, 0);
-    if (data)
+    if (loadImageStaging("../assets/tex/pixelWall.png", loadImage, stbi_image_free, image, "flip"))
     {
         GLenum format;
-        if (nrChannels == 1)
+        if (image.channels == 1)
             format = GL_RED;
-        else if (nrChannels == 3)
+        else if (image.channels == 3)
             format = GL_RGB;
-        else if (nrChannels == 4)
+        else if (image.channels == 4)
             format = GL_RGBA;
         else
             format = GL_RGB;
 
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        // Os mipmaps já vêm prontos do cache (Mipmap.h), um glTexImage2D por nível;
+        // os níveis pequenos têm linhas de qualquer tamanho, daí o alinhamento 1
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (size_t level = 0; level < image.levels.size(); level++)
+            glTexImage2D(GL_TEXTURE_2D, (GLint)level, format, image.levels[level].width, image.levels[level].height, 0,
+                         format, GL_UNSIGNED_BYTE, image.levels[level].pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     }
     else
     {
         std::cout << "Falha ao carregar textura" << std::endl;
     }
-    stbi_image_free(data);
 
     // Configura OpenGL para usar profundidade
     glEnable(GL_DEPTH_TEST);
@@ -265,30 +247,28 @@ int main()
         glUseProgram(shaderProgram);
 
         // Passa view e projection para shader
-        int viewLoc = glGetUniformLocation(shaderProgram, "view");
-        int projLoc = glGetUniformLocation(shaderProgram, "projection");
         glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
 
         // Ativa textura
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, texture);
-        glUniform1i(glGetUniformLocation(shaderProgram, "ourTexture"), 0);
+        glUniform1i(textureLoc, 0);
 
         glBindVertexArray(VAO);
 
         // Desenha vários cubos, cada um com posição e rotação diferente
+        instanceData.clear();
         for(unsigned int i = 0; i < 10; i++)
         {
             model = glm::mat4(1.0f);
             model = glm::translate(model, glm::vec3(i % 3 * 1.5f, (i / 3) * 1.5f, 0.0f));
             float angle = 20.0f * i;
             model = glm::rotate(model, (float)glfwGetTime() + glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            int modelLoc = glGetUniformLocation(shaderProgram, "model");
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            instanceData.push_back({model, glm::vec4(1.0f)});
         }
+        uploadInstances(instances, instanceData);
+        drawInstancedArrays(instances, GL_TRIANGLES, 0, 36);
 
         // Swap buffers e eventos
         glfwSwapBuffers(window);
@@ -296,6 +276,7 @@ int main()
     }
 
     // Limpar
+    destroyInstanceBuffer(instances);
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteProgram(shaderProgram);